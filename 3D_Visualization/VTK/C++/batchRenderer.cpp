@@ -0,0 +1,132 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// batchRenderer.cpp : Headless rendering of a list of scenes to PNG images and frame sequences.
+//
+#include "batchRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <vtkCamera.h>
+#include <vtkPNGWriter.h>
+#include <vtkProp.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderer.h>
+#include <vtkWindowToImageFilter.h>
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+std::string BatchScene::option(const std::string& key, const std::string& fallback) const {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+double BatchScene::number(const std::string& key, double fallback) const {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : std::atof(it->second.c_str());
+}
+
+bool loadBatchScenes(const std::string& path, std::vector<BatchScene>& scenes) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        line_number++;
+        std::istringstream fields(line);
+        BatchScene scene;
+        if (!(fields >> scene.name) || scene.name[0] == '#') continue;
+        if (!(fields >> scene.shape)) {
+            std::cerr << "Error: " << path << ":" << line_number << ": scene " << scene.name << " has no shape" << std::endl;
+            return false;
+        }
+        std::string field;
+        while (fields >> field) {
+            const size_t equals = field.find('=');
+            if (equals == std::string::npos) {
+                std::cerr << "Error: " << path << ":" << line_number << ": expected key=value, got " << field << std::endl;
+                return false;
+            }
+            scene.options[field.substr(0, equals)] = field.substr(equals + 1);
+        }
+        scene.frames = std::max(1, static_cast<int>(scene.number("frames", 1)));
+        scene.orbit_deg = scene.number("orbit", 360.0);
+        scenes.push_back(scene);
+    }
+    return true;
+}
+
+BatchRenderer::BatchRenderer(int width, int height)
+    : window_(vtkSmartPointer<vtkRenderWindow>::New()),
+      renderer_(vtkSmartPointer<vtkRenderer>::New()),
+      capture_(vtkSmartPointer<vtkWindowToImageFilter>::New()),
+      writer_(vtkSmartPointer<vtkPNGWriter>::New()) {
+    window_->SetOffScreenRendering(1);
+    window_->SetSize(width, height);
+    window_->AddRenderer(renderer_);
+    renderer_->SetBackground(0.1, 0.2, 0.3); // Background color
+
+    capture_->SetInput(window_);
+    capture_->SetInputBufferTypeToRGB();
+    capture_->ReadFrontBufferOff();
+    capture_->ShouldRerenderOff(); // render() has just drawn the frame
+    writer_->SetInputConnection(capture_->GetOutputPort());
+}
+
+BatchRenderer::~BatchRenderer() = default;
+
+bool BatchRenderer::render(const BatchScene& scene, vtkProp* prop, const std::string& output_dir) {
+    // An empty scene would still write images; a prop that failed to load is an error
+    if (!prop) {
+        std::cerr << "Error: Nothing to render in scene " << scene.name << std::endl;
+        return false;
+    }
+    renderer_->RemoveAllViewProps();
+    renderer_->AddViewProp(prop);
+
+    // Same starting view for every scene: looking down -z, then fitted to the prop
+    vtkCamera* camera = renderer_->GetActiveCamera();
+    camera->SetPosition(0.0, 0.0, 1.0);
+    camera->SetFocalPoint(0.0, 0.0, 0.0);
+    camera->SetViewUp(0.0, 1.0, 0.0);
+    renderer_->ResetCamera();
+
+    const double step = scene.frames > 1 ? scene.orbit_deg / scene.frames : 0.0;
+    for (int frame = 0; frame < scene.frames; ++frame) {
+        if (frame > 0) camera->Azimuth(step);
+
+        const auto render_start = std::chrono::steady_clock::now();
+        renderer_->ResetCameraClippingRange();
+        window_->Render();
+        render_s_ += secondsSince(render_start);
+
+        char file_name[64];
+        if (scene.frames > 1) std::snprintf(file_name, sizeof(file_name), "_%04d.png", frame);
+        else std::snprintf(file_name, sizeof(file_name), ".png");
+        const std::string path = output_dir + "/" + scene.name + file_name;
+
+        const auto write_start = std::chrono::steady_clock::now();
+        capture_->Modified();
+        writer_->SetFileName(path.c_str());
+        writer_->Write();
+        write_s_ += secondsSince(write_start);
+        if (writer_->GetErrorCode() != 0) {
+            std::cerr << "Error: Unable to write " << path << std::endl;
+            return false;
+        }
+        frames_++;
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// batchRenderer.h : Headless rendering of a list of scenes to PNG images and frame sequences.
+//
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <vtkSmartPointer.h>
+
+class vtkPNGWriter;
+class vtkProp;
+class vtkRenderer;
+class vtkRenderWindow;
+class vtkWindowToImageFilter;
+
+// One line of a scene file:
+//
+//   <name> <shape> [key=value ...]
+//
+// The shape and its keys are interpreted by the caller (vtkApp). Keys read here:
+// frames=N renders N frames orbiting the camera by orbit=D degrees in total (default 360)
+// as name_0000.png ...; a single frame is written as name.png. Blank lines and lines
+// starting with # are skipped.
+struct BatchScene {
+    std::string name;
+    std::string shape;
+    std::map<std::string, std::string> options;
+    int frames = 1;
+    double orbit_deg = 360.0;
+
+    std::string option(const std::string& key, const std::string& fallback) const;
+    double number(const std::string& key, double fallback) const;
+};
+
+bool loadBatchScenes(const std::string& path, std::vector<BatchScene>& scenes);
+
+// One offscreen window, renderer and PNG writer reused for every scene. The window uses
+// whatever offscreen context VTK was built with (EGL or OSMesa for servers without a
+// display; on a desktop build, a hidden window).
+class BatchRenderer {
+public:
+    BatchRenderer(int width, int height);
+    ~BatchRenderer();
+
+    // Renders all frames of the scene with prop as its only content into output_dir.
+    // Returns false for a null prop (its data could not be loaded) or a failed write.
+    bool render(const BatchScene& scene, vtkProp* prop, const std::string& output_dir);
+
+    uint64_t frames() const { return frames_; }
+    double renderSeconds() const { return render_s_; }
+    double writeSeconds() const { return write_s_; }
+
+private:
+    vtkSmartPointer<vtkRenderWindow> window_;
+    vtkSmartPointer<vtkRenderer> renderer_;
+    vtkSmartPointer<vtkWindowToImageFilter> capture_;
+    vtkSmartPointer<vtkPNGWriter> writer_;
+    uint64_t frames_ = 0;
+    double render_s_ = 0.0;
+    double write_s_ = 0.0;
+};
@@ -0,0 +1,166 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// liveViewer.cpp : Live VTK view of point clouds and trajectories written by other threads.
+//
+#include "liveViewer.h"
+
+#include <cstdio>
+
+#include <vtkActor.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkPointData.h>
+#include <vtkPointGaussianMapper.h>
+#include <vtkPoints.h>
+#include <vtkPolyDataMapper.h>
+#include <vtkProperty.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
+#include <vtkRenderer.h>
+
+LiveCloud::LiveCloud()
+    : points(vtkSmartPointer<vtkFloatArray>::New()),
+      values(vtkSmartPointer<vtkFloatArray>::New()),
+      data(vtkSmartPointer<vtkPolyData>::New()) {
+    points->SetNumberOfComponents(3);
+    values->SetName("Scalars");
+    auto wrapper = vtkSmartPointer<vtkPoints>::New();
+    wrapper->SetData(points);
+    data->SetPoints(wrapper);
+    data->GetPointData()->SetScalars(values);
+}
+
+void LiveCloud::resize(vtkIdType n) {
+    points->SetNumberOfTuples(n);
+    values->SetNumberOfTuples(n);
+}
+
+LiveTrajectory::LiveTrajectory()
+    : points(vtkSmartPointer<vtkFloatArray>::New()),
+      lines(vtkSmartPointer<vtkCellArray>::New()),
+      data(vtkSmartPointer<vtkPolyData>::New()) {
+    points->SetNumberOfComponents(3);
+    auto wrapper = vtkSmartPointer<vtkPoints>::New();
+    wrapper->SetData(points);
+    data->SetPoints(wrapper);
+    data->SetLines(lines);
+}
+
+void LiveTrajectory::resize(vtkIdType n) {
+    points->SetNumberOfTuples(n);
+    lines->Reset();
+    if (n < 2) return;
+    lines->InsertNextCell(n);
+    for (vtkIdType i = 0; i < n; ++i) lines->InsertCellPoint(i);
+}
+
+LiveViewer::LiveViewer(LiveScene& scene)
+    : scene_(scene),
+      cloud_mapper_(vtkSmartPointer<vtkPointGaussianMapper>::New()),
+      trajectory_mapper_(vtkSmartPointer<vtkPolyDataMapper>::New()),
+      cloud_actor_(vtkSmartPointer<vtkActor>::New()),
+      trajectory_actor_(vtkSmartPointer<vtkActor>::New()),
+      renderer_(vtkSmartPointer<vtkRenderer>::New()),
+      window_(vtkSmartPointer<vtkRenderWindow>::New()),
+      interactor_(vtkSmartPointer<vtkRenderWindowInteractor>::New()) {
+    // Scale factor 0 draws plain points, the cheapest primitive for millions of them
+    cloud_mapper_->SetScaleFactor(0.0);
+    cloud_mapper_->SetScalarRange(-2.0, 3.0);
+    cloud_mapper_->SetInputData(scene_.cloud.front().data);
+    cloud_actor_->SetMapper(cloud_mapper_);
+    cloud_actor_->GetProperty()->SetPointSize(2.0f);
+
+    trajectory_mapper_->SetInputData(scene_.trajectory.front().data);
+    trajectory_mapper_->ScalarVisibilityOff();
+    trajectory_actor_->SetMapper(trajectory_mapper_);
+    trajectory_actor_->GetProperty()->SetColor(1.0, 0.5, 0.0); // Orange
+    trajectory_actor_->GetProperty()->SetLineWidth(3.0f);
+
+    renderer_->AddActor(cloud_actor_);
+    renderer_->AddActor(trajectory_actor_);
+    renderer_->SetBackground(0.1, 0.2, 0.3); // Background color
+    window_->AddRenderer(renderer_);
+    window_->SetSize(1280, 720);
+    window_->SetWindowName("Live View");
+    interactor_->SetRenderWindow(window_);
+}
+
+LiveViewer::~LiveViewer() = default;
+
+void LiveViewer::run(double seconds, int period_ms) {
+    seconds_ = seconds;
+    interactor_->Initialize();
+
+    auto callback = vtkSmartPointer<vtkCallbackCommand>::New();
+    callback->SetCallback(&LiveViewer::onTimer);
+    callback->SetClientData(this);
+    interactor_->AddObserver(vtkCommand::TimerEvent, callback);
+    interactor_->CreateRepeatingTimer(static_cast<unsigned long>(period_ms));
+
+    start_ = last_report_ = std::chrono::steady_clock::now();
+    render();
+    interactor_->Start();
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    std::printf("[live] %llu frames in %.1f s (%.1f fps), %.2f ms per render; cloud %llu published / %llu dropped, trajectory %llu / %llu\n",
+        static_cast<unsigned long long>(frames_), elapsed, frames_ / elapsed, meanRenderMs(),
+        static_cast<unsigned long long>(scene_.cloud.published()), static_cast<unsigned long long>(scene_.cloud.dropped()),
+        static_cast<unsigned long long>(scene_.trajectory.published()), static_cast<unsigned long long>(scene_.trajectory.dropped()));
+}
+
+void LiveViewer::onTimer(vtkObject*, unsigned long, void* client, void*) {
+    static_cast<LiveViewer*>(client)->tick();
+}
+
+void LiveViewer::tick() {
+    bool changed = false;
+
+    // The previous front slot goes back to the producer with update(), so the mapper is
+    // switched to the new slot before anything renders again
+    if (scene_.cloud.update()) {
+        LiveCloud& cloud = scene_.cloud.front();
+        cloud.points->Modified();
+        cloud.values->Modified();
+        cloud_mapper_->SetInputData(cloud.data);
+        changed = true;
+    }
+    if (scene_.trajectory.update()) {
+        LiveTrajectory& trajectory = scene_.trajectory.front();
+        trajectory.points->Modified();
+        trajectory.lines->Modified();
+        trajectory_mapper_->SetInputData(trajectory.data);
+        changed = true;
+    }
+    if (changed) {
+        if (!camera_reset_ && scene_.cloud.front().size() > 0) {
+            renderer_->ResetCamera();
+            camera_reset_ = true;
+        }
+        render();
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const double since_report = std::chrono::duration<double>(now - last_report_).count();
+    if (since_report >= 1.0) {
+        report(since_report);
+        last_report_ = now;
+    }
+    if (seconds_ > 0.0 && std::chrono::duration<double>(now - start_).count() >= seconds_) {
+        interactor_->TerminateApp();
+    }
+}
+
+void LiveViewer::render() {
+    const auto start = std::chrono::steady_clock::now();
+    window_->Render();
+    render_ms_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    frames_++;
+}
+
+void LiveViewer::report(double elapsed_s) {
+    std::printf("[live] %.1f fps, %.2f ms per render, %lld points, %lld poses\n",
+        (frames_ - frames_at_report_) / elapsed_s, meanRenderMs(),
+        static_cast<long long>(scene_.cloud.front().size()), static_cast<long long>(scene_.trajectory.front().size()));
+    frames_at_report_ = frames_;
+}
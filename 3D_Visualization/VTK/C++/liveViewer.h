@@ -0,0 +1,99 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// liveViewer.h : Live VTK view of point clouds and trajectories written by other threads.
+//
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include "tripleBuffer.h"
+
+class vtkActor;
+class vtkObject;
+class vtkPointGaussianMapper;
+class vtkPolyDataMapper;
+class vtkRenderer;
+class vtkRenderWindow;
+class vtkRenderWindowInteractor;
+
+// Point cloud slot: float positions and one scalar per point (used for colouring),
+// filled in place through the raw pointers
+struct LiveCloud {
+    LiveCloud();
+
+    // Keeps the allocation when the size does not grow
+    void resize(vtkIdType n);
+    vtkIdType size() const { return points->GetNumberOfTuples(); }
+    float* xyz() { return points->GetPointer(0); }
+    float* scalars() { return values->GetPointer(0); }
+
+    vtkSmartPointer<vtkFloatArray> points;
+    vtkSmartPointer<vtkFloatArray> values;
+    vtkSmartPointer<vtkPolyData> data;
+};
+
+// Trajectory slot: camera / vehicle positions drawn as one polyline
+struct LiveTrajectory {
+    LiveTrajectory();
+
+    // Also rebuilds the polyline over the n positions
+    void resize(vtkIdType n);
+    vtkIdType size() const { return points->GetNumberOfTuples(); }
+    float* xyz() { return points->GetPointer(0); }
+
+    vtkSmartPointer<vtkFloatArray> points;
+    vtkSmartPointer<vtkCellArray> lines;
+    vtkSmartPointer<vtkPolyData> data;
+};
+
+// What producers write to: each stream has one producer thread, which fills back() and
+// calls publish(). Neither call waits for the renderer.
+struct LiveScene {
+    TripleBuffer<LiveCloud> cloud;
+    TripleBuffer<LiveTrajectory> trajectory;
+};
+
+// Renders a LiveScene. A repeating interactor timer picks up the newest published cloud
+// and trajectory and renders only when one of them changed; camera interaction works as
+// usual in between. Frame rate and render time are printed once per second.
+class LiveViewer {
+public:
+    explicit LiveViewer(LiveScene& scene);
+    ~LiveViewer();
+
+    // Blocks until the window is closed, or for `seconds` when > 0
+    void run(double seconds = 0.0, int period_ms = 10);
+
+    uint64_t frames() const { return frames_; }
+    double meanRenderMs() const { return frames_ ? render_ms_ / frames_ : 0.0; }
+
+private:
+    static void onTimer(vtkObject* caller, unsigned long event, void* client, void* call);
+    void tick();
+    void render();
+    void report(double elapsed_s);
+
+    LiveScene& scene_;
+    vtkSmartPointer<vtkPointGaussianMapper> cloud_mapper_;
+    vtkSmartPointer<vtkPolyDataMapper> trajectory_mapper_;
+    vtkSmartPointer<vtkActor> cloud_actor_;
+    vtkSmartPointer<vtkActor> trajectory_actor_;
+    vtkSmartPointer<vtkRenderer> renderer_;
+    vtkSmartPointer<vtkRenderWindow> window_;
+    vtkSmartPointer<vtkRenderWindowInteractor> interactor_;
+
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point last_report_;
+    double seconds_ = 0.0;
+    bool camera_reset_ = false;
+    uint64_t frames_ = 0;
+    uint64_t frames_at_report_ = 0;
+    double render_ms_ = 0.0;
+};
@@ -1,7 +1,26 @@
 // vtkApp.cpp : This file contains the 'main' function. Program execution begins and ends there.
 //
+//   vtkApp                         # the four demos, one window each
+//   vtkApp live [points] [seconds] # live view of a streamed cloud and trajectory (default 1M points)
+//   vtkApp replay capture.pcap vlp16|hdl32|vls128 [slam.flog] [seconds]
+//                                  # live view of a Velodyne replay and a SLAM trajectory
+//   vtkApp grid [n]                # n^3 structured grid: build time, memory, level-of-detail view
+//   vtkApp batch scenes.txt outdir [width height]   # headless: render a scene file to PNGs
+//
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <vtkSmartPointer.h>
 #include <vtkSphereSource.h>
@@ -25,9 +44,26 @@
 #include <vtkDoubleArray.h>
 #include <vtkLineSource.h>
 #include <vtkProperty.h>
+#include <vtkFloatArray.h>
+#include <vtkSMPTools.h>
+#include <vtkLODProp3D.h>
+#include <vtkDataSetSurfaceFilter.h>
+#include <vtkExtractGrid.h>
+#include <vtkStructuredGridOutlineFilter.h>
+
+#include <vtkPLYReader.h>
+#include <vtkPointGaussianMapper.h>
+
+#include "batchRenderer.h"
+#include "cloudFilter.h"
+#include "featureLog.h"
+#include "liveViewer.h"
+#include "processStats.h"
+#include "velodyneDecoder.h"
+#include "velodynePcap.h"
 
-// Function to display a VTK actor
-void DisplayActor(vtkSmartPointer<vtkActor> actor) {
+// Function to display a VTK actor (or any other prop)
+void DisplayActor(vtkProp* actor) {
     vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
     vtkSmartPointer<vtkRenderWindow> renderWindow = vtkSmartPointer<vtkRenderWindow>::New();
     vtkSmartPointer<vtkRenderWindowInteractor> renderWindowInteractor = vtkSmartPointer<vtkRenderWindowInteractor>::New();
@@ -42,10 +78,9 @@ void DisplayActor(vtkSmartPointer<vtkActor> actor) {
     renderWindowInteractor->Start();
 }
 
-int main() {
-    // 1. Sphere
+vtkSmartPointer<vtkActor> MakeSphereActor(double radius, const double color[3]) {
     auto sphereSource = vtkSmartPointer<vtkSphereSource>::New();
-    sphereSource->SetRadius(1.0);
+    sphereSource->SetRadius(radius);
     sphereSource->SetCenter(0, 0, 0);
     sphereSource->Update();
 
@@ -54,14 +89,14 @@ int main() {
 
     auto sphereActor = vtkSmartPointer<vtkActor>::New();
     sphereActor->SetMapper(sphereMapper);
-    sphereActor->GetProperty()->SetColor(1.0, 0.0, 0.0); // Red
-
-    DisplayActor(sphereActor);
+    sphereActor->GetProperty()->SetColor(color[0], color[1], color[2]);
+    return sphereActor;
+}
 
-    // 2. Cylinder
+vtkSmartPointer<vtkActor> MakeCylinderActor(double radius, double height, const double color[3]) {
     auto cylinderSource = vtkSmartPointer<vtkCylinderSource>::New();
-    cylinderSource->SetRadius(1.0);
-    cylinderSource->SetHeight(2.0);
+    cylinderSource->SetRadius(radius);
+    cylinderSource->SetHeight(height);
     cylinderSource->SetResolution(50);
     cylinderSource->Update();
 
@@ -70,17 +105,21 @@ int main() {
 
     auto cylinderActor = vtkSmartPointer<vtkActor>::New();
     cylinderActor->SetMapper(cylinderMapper);
-    cylinderActor->GetProperty()->SetColor(0.0, 0.0, 1.0); // Blue
+    cylinderActor->GetProperty()->SetColor(color[0], color[1], color[2]);
+    return cylinderActor;
+}
 
-    DisplayActor(cylinderActor);
+// Unit sphere minus a cube
+vtkSmartPointer<vtkActor> MakeBooleanActor(const double color[3]) {
+    auto sphereSource = vtkSmartPointer<vtkSphereSource>::New();
+    sphereSource->SetRadius(1.0);
+    sphereSource->SetCenter(0, 0, 0);
 
-    // 3. Boolean Operations: Sphere - Cube
     auto cubeSource = vtkSmartPointer<vtkCubeSource>::New();
     cubeSource->SetCenter(0.5, 0.5, 0.0);
     cubeSource->SetXLength(1.5);
     cubeSource->SetYLength(1.5);
     cubeSource->SetZLength(1.5);
-    cubeSource->Update();
 
     auto booleanOperation = vtkSmartPointer<vtkBooleanOperationPolyDataFilter>::New();
     booleanOperation->SetOperationToDifference();
@@ -93,44 +132,384 @@ int main() {
 
     auto booleanActor = vtkSmartPointer<vtkActor>::New();
     booleanActor->SetMapper(booleanMapper);
-    booleanActor->GetProperty()->SetColor(1.0, 0.5, 0.0); // Orange
+    booleanActor->GetProperty()->SetColor(color[0], color[1], color[2]);
+    return booleanActor;
+}
+
+// Point cloud from a PLY file, drawn as plain points; null if the file cannot be read
+vtkSmartPointer<vtkActor> MakeCloudActor(const std::string& path, const double color[3]) {
+    if (path.empty() || !std::ifstream(path)) {
+        std::cerr << "Error: Unable to open point cloud " << (path.empty() ? "(no file given)" : path) << std::endl;
+        return vtkSmartPointer<vtkActor>();
+    }
+    auto reader = vtkSmartPointer<vtkPLYReader>::New();
+    reader->SetFileName(path.c_str());
+    reader->Update();
+    if (reader->GetOutput()->GetNumberOfPoints() == 0) {
+        std::cerr << "Error: No points read from " << path << " (not a PLY file, or empty)" << std::endl;
+        return vtkSmartPointer<vtkActor>();
+    }
 
-    DisplayActor(booleanActor);
+    auto cloudMapper = vtkSmartPointer<vtkPointGaussianMapper>::New();
+    cloudMapper->SetInputConnection(reader->GetOutputPort());
+    cloudMapper->SetScaleFactor(0.0);
+    cloudMapper->ScalarVisibilityOff();
+
+    auto cloudActor = vtkSmartPointer<vtkActor>::New();
+    cloudActor->SetMapper(cloudMapper);
+    cloudActor->GetProperty()->SetColor(color[0], color[1], color[2]);
+    cloudActor->GetProperty()->SetPointSize(2.0f);
+    return cloudActor;
+}
+
+// Structured grid of nx * ny * nz points on [-1, 1)^3 with the distance to the origin as
+// point scalars. Points and scalars are allocated once and written through raw pointers,
+// one z slice per work item, in parallel with vtkSMPTools. Float storage: 16 bytes per point.
+vtkSmartPointer<vtkStructuredGrid> BuildStructuredGrid(int nx, int ny, int nz) {
+    const vtkIdType slice = vtkIdType(nx) * ny;
+    const vtkIdType total = slice * nz;
 
-    // 4. Structured Grid with Scalars
-    int nx = 20, ny = 20, nz = 20;
     auto points = vtkSmartPointer<vtkPoints>::New();
-    for (int i = 0; i < nx; ++i) {
-        for (int j = 0; j < ny; ++j) {
-            for (int k = 0; k < nz; ++k) {
-                double x = static_cast<double>(i) / nx * 2.0 - 1.0;
-                double y = static_cast<double>(j) / ny * 2.0 - 1.0;
-                double z = static_cast<double>(k) / nz * 2.0 - 1.0;
-                points->InsertNextPoint(x, y, z);
+    points->SetDataTypeToFloat();
+    points->SetNumberOfPoints(total);
+    float* xyz = static_cast<float*>(points->GetVoidPointer(0));
+
+    auto scalars = vtkSmartPointer<vtkFloatArray>::New();
+    scalars->SetName("Scalars");
+    scalars->SetNumberOfTuples(total);
+    float* values = scalars->GetPointer(0);
+
+    // VTK point order: x fastest, then y, then z
+    vtkSMPTools::For(0, nz, [&](vtkIdType kBegin, vtkIdType kEnd) {
+        for (vtkIdType k = kBegin; k < kEnd; ++k) {
+            const float z = static_cast<float>(k) / nz * 2.0f - 1.0f;
+            for (int j = 0; j < ny; ++j) {
+                const float y = static_cast<float>(j) / ny * 2.0f - 1.0f;
+                const vtkIdType row = k * slice + vtkIdType(j) * nx;
+                float* p = xyz + 3 * row;
+                float* s = values + row;
+                for (int i = 0; i < nx; ++i) {
+                    const float x = static_cast<float>(i) / nx * 2.0f - 1.0f;
+                    p[3 * i] = x;
+                    p[3 * i + 1] = y;
+                    p[3 * i + 2] = z;
+                    s[i] = std::sqrt(x * x + y * y + z * z);
+                }
             }
         }
-    }
+    });
 
     auto structuredGrid = vtkSmartPointer<vtkStructuredGrid>::New();
     structuredGrid->SetDimensions(nx, ny, nz);
     structuredGrid->SetPoints(points);
+    structuredGrid->GetPointData()->SetScalars(scalars);
+    return structuredGrid;
+}
 
-    auto scalars = vtkSmartPointer<vtkDoubleArray>::New();
-    scalars->SetName("Scalars");
-    for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i) {
-        double p[3];
-        points->GetPoint(i, p);
-        scalars->InsertNextValue(sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]));
+// Three levels for the grid: the boundary surface, the surface of every 4th point and the
+// outline. While the camera moves the renderer picks the finest level that meets the
+// interactor's desired update rate; the full level is drawn once it stops.
+vtkSmartPointer<vtkLODProp3D> MakeGridLod(vtkStructuredGrid* grid) {
+    auto lod = vtkSmartPointer<vtkLODProp3D>::New();
+
+    auto surface = vtkSmartPointer<vtkDataSetSurfaceFilter>::New();
+    surface->SetInputData(grid);
+    auto surfaceMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    surfaceMapper->SetInputConnection(surface->GetOutputPort());
+    surfaceMapper->SetScalarRange(0.0, std::sqrt(3.0));
+    lod->AddLOD(surfaceMapper, 0.0);
+
+    auto coarse = vtkSmartPointer<vtkExtractGrid>::New();
+    coarse->SetInputData(grid);
+    coarse->SetSampleRate(4, 4, 4);
+    coarse->IncludeBoundaryOn();
+    auto coarseSurface = vtkSmartPointer<vtkDataSetSurfaceFilter>::New();
+    coarseSurface->SetInputConnection(coarse->GetOutputPort());
+    auto coarseMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    coarseMapper->SetInputConnection(coarseSurface->GetOutputPort());
+    coarseMapper->SetScalarRange(0.0, std::sqrt(3.0));
+    lod->AddLOD(coarseMapper, 0.0);
+
+    auto outline = vtkSmartPointer<vtkStructuredGridOutlineFilter>::New();
+    outline->SetInputData(grid);
+    auto outlineMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    outlineMapper->SetInputConnection(outline->GetOutputPort());
+    lod->AddLOD(outlineMapper, 0.0);
+    return lod;
+}
+
+// Builds an n^3 grid and reports build time and memory before showing it
+int RunGridDemo(int n) {
+    const size_t residentBefore = residentSetBytes();
+    const auto start = std::chrono::steady_clock::now();
+    vtkSmartPointer<vtkStructuredGrid> grid = BuildStructuredGrid(n, n, n);
+    const double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const size_t residentAfter = std::max(residentSetBytes(), residentBefore);
+
+    std::cout << "Grid " << n << "^3: " << grid->GetNumberOfPoints() << " points, "
+              << grid->GetNumberOfCells() << " cells, built in " << buildSeconds << " s ("
+              << grid->GetNumberOfPoints() / buildSeconds / 1e6 << " M points/s, "
+              << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)" << std::endl;
+    std::cout << "Memory: " << grid->GetActualMemorySize() / 1024 << " MB in the grid, "
+              << (residentAfter - residentBefore) / (1024 * 1024) << " MB resident added" << std::endl;
+
+    DisplayActor(MakeGridLod(grid));
+    return 0;
+}
+
+// Live demo: one thread streams a rotating LiDAR-like cloud (terrain, with a sweep
+// highlighted in the scalars), another a growing loop trajectory. Neither waits for the viewer.
+int RunLiveDemo(vtkIdType cloudPoints, double seconds) {
+    LiveScene scene;
+    std::atomic<bool> running{ true };
+
+    std::thread cloudThread([&] {
+        const int side = static_cast<int>(std::sqrt(static_cast<double>(cloudPoints)));
+        for (int frame = 0; running; ++frame) {
+            LiveCloud& cloud = scene.cloud.back();
+            cloud.resize(vtkIdType(side) * side);
+            float* xyz = cloud.xyz();
+            float* scalars = cloud.scalars();
+            const float sweep = 0.1f * frame;
+            for (int i = 0; i < side; ++i) {
+                for (int j = 0; j < side; ++j) {
+                    const float x = 40.0f * i / side - 20.0f;
+                    const float y = 40.0f * j / side - 20.0f;
+                    const float z = 0.5f * std::sin(0.3f * x) * std::cos(0.2f * y);
+                    const size_t n = size_t(i) * side + j;
+                    xyz[3 * n] = x;
+                    xyz[3 * n + 1] = y;
+                    xyz[3 * n + 2] = z;
+                    const float angle = std::atan2(y, x) - sweep;
+                    scalars[n] = z + 2.5f * (0.5f + 0.5f * std::cos(angle));
+                }
+            }
+            scene.cloud.publish();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    });
+
+    std::thread trajectoryThread([&] {
+        std::vector<float> poses;
+        for (int step = 0; running; ++step) {
+            const float t = 0.02f * step;
+            poses.push_back(15.0f * std::sin(t));
+            poses.push_back(10.0f * std::sin(2.0f * t));
+            poses.push_back(2.0f + 0.5f * std::sin(3.0f * t));
+
+            LiveTrajectory& trajectory = scene.trajectory.back();
+            trajectory.resize(static_cast<vtkIdType>(poses.size() / 3));
+            std::memcpy(trajectory.xyz(), poses.data(), poses.size() * sizeof(float));
+            scene.trajectory.publish();
+            std::this_thread::sleep_for(std::chrono::milliseconds(33));
+        }
+    });
+
+    LiveViewer viewer(scene);
+    viewer.run(seconds);
+
+    running = false;
+    cloudThread.join();
+    trajectoryThread.join();
+    return 0;
+}
+
+// Live view of recorded perception output, both streams paced by their capture times:
+// the velodyneReplay chain (decoding, ground removal, voxel grid) publishes ground points
+// and obstacle voxels after every scan, and the poses of a feature log written by
+// orb_slam or sift_slam are chained into a growing trajectory. The SLAM trajectory has
+// the unit steps of recoverPose and is not registered to the LiDAR frame.
+int RunReplay(const std::string& pcapPath, VelodyneModel model, const std::string& logPath, double seconds) {
+    VelodynePcapReader reader;
+    if (!reader.open(pcapPath)) {
+        std::cerr << "Error: Unable to open " << pcapPath << " as an Ethernet pcap capture" << std::endl;
+        return -1;
     }
-    structuredGrid->GetPointData()->SetScalars(scalars);
+    FeatureLogReader featureLog;
+    if (!logPath.empty() && !featureLog.open(logPath)) {
+        std::cerr << "Error: Unable to read feature log " << logPath << std::endl;
+        return -1;
+    }
+
+    LiveScene scene;
+    std::atomic<bool> running{ true };
+    const auto start = std::chrono::steady_clock::now();
+
+    std::thread cloudThread([&] {
+        VelodyneDecoder decoder(model, defaultCalibration(model));
+        CloudFilter filter;
+        LidarScan scan;
+        VelodynePacket packet;
+        std::vector<LidarPoint> obstacles, ground;
+        uint64_t firstCaptureUs = 0;
+        while (running && reader.next(packet)) {
+            if (firstCaptureUs == 0) firstCaptureUs = packet.capture_us;
+            std::this_thread::sleep_until(start + std::chrono::microseconds(packet.capture_us - firstCaptureUs));
+            if (!decoder.add(packet, scan)) continue;
+
+            // Height as the scalar, so ground and obstacles separate by colour
+            filter.process(scan, decoder.rings(), obstacles, ground);
+            LiveCloud& cloud = scene.cloud.back();
+            cloud.resize(static_cast<vtkIdType>(ground.size() + obstacles.size()));
+            float* xyz = cloud.xyz();
+            float* scalars = cloud.scalars();
+            size_t n = 0;
+            for (const std::vector<LidarPoint>* points : { &ground, &obstacles }) {
+                for (const LidarPoint& p : *points) {
+                    xyz[3 * n] = p.x;
+                    xyz[3 * n + 1] = p.y;
+                    xyz[3 * n + 2] = p.z;
+                    scalars[n++] = p.z;
+                }
+            }
+            scene.cloud.publish();
+        }
+        std::cout << "Velodyne replay finished: " << scene.cloud.published() << " scans published, "
+                  << decoder.badPackets() << " malformed packets" << std::endl;
+    });
+
+    std::thread trajectoryThread([&] {
+        if (featureLog.frames() == 0) return;
+        const int64_t firstCaptureNs = featureLog.frame(0).header->capture_ns;
+        ChainedPose pose;
+        std::vector<float> positions;
+        for (size_t i = 0; running && i < featureLog.frames(); ++i) {
+            const FeatureLogFrameHeader& frame = *featureLog.frame(i).header;
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(frame.capture_ns - firstCaptureNs));
+            pose.add(frame);
+            for (double v : pose.position) positions.push_back(static_cast<float>(v));
+
+            LiveTrajectory& trajectory = scene.trajectory.back();
+            trajectory.resize(static_cast<vtkIdType>(positions.size() / 3));
+            std::memcpy(trajectory.xyz(), positions.data(), positions.size() * sizeof(float));
+            scene.trajectory.publish();
+        }
+    });
+
+    LiveViewer viewer(scene);
+    viewer.run(seconds);
+
+    running = false;
+    cloudThread.join();
+    trajectoryThread.join();
+    return 0;
+}
+
+// Image size argument: a positive integer up to 16384, false for anything else
+bool ParseImageSize(const char* text, int& value) {
+    char* end = nullptr;
+    const long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed <= 0 || parsed > 16384) return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+// Headless batch: every scene of the file is rendered offscreen with one reused window
+int RunBatch(const std::string& scenePath, const std::string& outputDir, int width, int height) {
+    std::vector<BatchScene> scenes;
+    if (!loadBatchScenes(scenePath, scenes)) {
+        std::cerr << "Error: Unable to read scenes from " << scenePath << std::endl;
+        return -1;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(outputDir, error);
+    if (error) {
+        std::cerr << "Error: Unable to create " << outputDir << ": " << error.message() << std::endl;
+        return -1;
+    }
+
+    BatchRenderer batch(width, height);
+    const auto start = std::chrono::steady_clock::now();
+    for (const BatchScene& scene : scenes) {
+        double color[3] = { 1.0, 1.0, 1.0 };
+        std::sscanf(scene.option("color", "1,1,1").c_str(), "%lf,%lf,%lf", &color[0], &color[1], &color[2]);
+
+        vtkSmartPointer<vtkProp> prop;
+        if (scene.shape == "sphere") {
+            prop = MakeSphereActor(scene.number("radius", 1.0), color);
+        }
+        else if (scene.shape == "cylinder") {
+            prop = MakeCylinderActor(scene.number("radius", 1.0), scene.number("height", 2.0), color);
+        }
+        else if (scene.shape == "boolean") {
+            prop = MakeBooleanActor(color);
+        }
+        else if (scene.shape == "grid") {
+            const int n = static_cast<int>(scene.number("n", 20));
+            prop = MakeGridLod(BuildStructuredGrid(n, n, n));
+        }
+        else if (scene.shape == "cloud") {
+            prop = MakeCloudActor(scene.option("file", ""), color);
+        }
+        else {
+            std::cerr << "Error: Unknown shape " << scene.shape << " in scene " << scene.name << std::endl;
+            return -1;
+        }
+        if (!batch.render(scene, prop, outputDir)) return -1;
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Rendered " << scenes.size() << " scenes, " << batch.frames() << " frames at " << width << "x" << height
+              << " in " << elapsed << " s: " << batch.frames() / elapsed << " frames/s overall, "
+              << batch.frames() / batch.renderSeconds() << " frames/s rendering, "
+              << 1000.0 * batch.writeSeconds() / batch.frames() << " ms per PNG" << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "live") {
+        const vtkIdType cloudPoints = argc > 2 ? std::atoll(argv[2]) : 1000000;
+        const double seconds = argc > 3 ? std::atof(argv[3]) : 0.0;
+        return RunLiveDemo(cloudPoints, seconds);
+    }
+    if (argc > 1 && std::string(argv[1]) == "replay") {
+        VelodyneModel model;
+        if (argc < 4) {
+            std::cerr << "Usage: " << argv[0] << " replay <capture.pcap> <vlp16|hdl32|vls128> [slam.flog] [seconds]" << std::endl;
+            return -1;
+        }
+        if (!parseVelodyneModel(argv[3], model)) {
+            std::cerr << "Error: Unknown model " << argv[3] << std::endl;
+            return -1;
+        }
+        return RunReplay(argv[2], model, argc > 4 ? argv[4] : "", argc > 5 ? std::atof(argv[5]) : 0.0);
+    }
+    if (argc > 1 && std::string(argv[1]) == "grid") {
+        return RunGridDemo(argc > 2 ? std::atoi(argv[2]) : 512);
+    }
+    if (argc > 1 && std::string(argv[1]) == "batch") {
+        if (argc < 4) {
+            std::cerr << "Usage: " << argv[0] << " batch <scenes.txt> <output dir> [width height]" << std::endl;
+            return -1;
+        }
+        int width = 1280, height = 720;
+        if (argc > 4 && !ParseImageSize(argv[4], width)) {
+            std::cerr << "Error: Invalid width " << argv[4] << std::endl;
+            return -1;
+        }
+        if (argc > 5 && !ParseImageSize(argv[5], height)) {
+            std::cerr << "Error: Invalid height " << argv[5] << std::endl;
+            return -1;
+        }
+        return RunBatch(argv[2], argv[3], width, height);
+    }
+
+    // 1. Sphere
+    const double red[3] = { 1.0, 0.0, 0.0 };
+    DisplayActor(MakeSphereActor(1.0, red));
 
-    auto gridMapper = vtkSmartPointer<vtkDataSetMapper>::New();
-    gridMapper->SetInputData(structuredGrid);
+    // 2. Cylinder
+    const double blue[3] = { 0.0, 0.0, 1.0 };
+    DisplayActor(MakeCylinderActor(1.0, 2.0, blue));
 
-    auto gridActor = vtkSmartPointer<vtkActor>::New();
-    gridActor->SetMapper(gridMapper);
+    // 3. Boolean Operations: Sphere - Cube
+    const double orange[3] = { 1.0, 0.5, 0.0 };
+    DisplayActor(MakeBooleanActor(orange));
 
-    DisplayActor(gridActor);
+    // 4. Structured Grid with Scalars
+    vtkSmartPointer<vtkStructuredGrid> structuredGrid = BuildStructuredGrid(20, 20, 20);
+    DisplayActor(MakeGridLod(structuredGrid));
 
     return 0;
 }
@@ -0,0 +1,341 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// faceStreamServer.cpp : Headless face detection, recognition and EKF tracking for many
+// camera streams in one process:
+//
+//   faceStreamServer [options] <source> [<source> ...]
+//
+//   --reference face.jpg   enroll this face once; every stream reports matches against it
+//   --threads n            pool workers (default: hardware concurrency)
+//   --max-latency ms       frames older than this when a worker picks them up are skipped (200)
+//   --ramp s               start with one stream and add one every s seconds
+//   --seconds s            stop after s seconds (default: when every source has ended)
+//   --int8 scales.txt      run the ResNet in int8 with scales from faceNetBenchmark --scales
+//
+// Sources are camera indices, video files or image directories; files are replayed at
+// their recorded rate, like cameras. The shape predictor is loaded once and shared; the
+// detector and ResNet are copied once per pool worker, not per stream, because dlib runs
+// them with internal scratch state. Each stream has at most one frame in the pool, so a
+// stream can never crowd out the others; its next frame is the newest one.
+//
+#include <opencv2/opencv.hpp>
+#include <dlib/opencv.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "faceModels.h"
+#include "frameSource.h"
+#include "kalmanTrackPool.h"
+#include "processStats.h"
+#include "quantizedFaceNet.h"
+#include "pyramidFeatures.h"
+#include "trackManager.h"
+#include "tracing.h"
+#include "workStealingPool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Detector and ResNet of one pool worker
+struct WorkerModels {
+    dlib::frontal_face_detector face_detector;
+    FaceEncoder face_recognizer;
+    std::unique_ptr<QuantizedFaceNet> quantized; // With --int8, replaces face_recognizer
+
+    dlib::matrix<float, 0, 1> describe(const dlib::matrix<dlib::rgb_pixel>& chip) {
+        return quantized ? quantizedDescriptor(*quantized, chip) : face_recognizer(chip);
+    }
+};
+
+struct Stream {
+    explicit Stream(const std::string& source_name)
+        : name(source_name), track_pool(64, 100.0, 5.0 * CV_PI / 180.0, 2.0, 500.0), tracker(track_pool) {}
+
+    std::string name;
+    FrameSource source;
+    KalmanTrackPool track_pool;
+    TrackManager<KalmanTrackPool> tracker; // Only touched by the task of this stream's frame in flight
+    bool in_flight = false;                // Guarded by the server mutex
+    bool ended = false;
+
+    // Guarded by the server mutex
+    std::vector<double> latencies_ms;      // Since the last report
+    uint64_t processed = 0;
+    uint64_t late = 0;
+    uint64_t faces = 0;
+    uint64_t matches = 0;
+};
+
+struct Percentiles {
+    double p50 = 0.0, p99 = 0.0, max = 0.0;
+};
+
+Percentiles percentiles(std::vector<double>& samples) {
+    Percentiles result;
+    if (samples.empty()) return result;
+    std::sort(samples.begin(), samples.end());
+    result.p50 = samples[samples.size() / 2];
+    result.p99 = samples[(samples.size() * 99) / 100];
+    result.max = samples.back();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    trace::Session tracing("face_stream_server");
+
+    std::string reference_path, scales_path;
+    int threads = 0;
+    double max_latency_ms = 200.0;
+    double ramp_s = 0.0;
+    double run_s = 0.0;
+    std::vector<std::string> sources;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--reference") == 0 && i + 1 < argc) reference_path = argv[++i];
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--max-latency") == 0 && i + 1 < argc) max_latency_ms = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--ramp") == 0 && i + 1 < argc) ramp_s = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) run_s = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--int8") == 0 && i + 1 < argc) scales_path = argv[++i];
+        else sources.push_back(argv[i]);
+    }
+    if (sources.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--reference face.jpg] [--threads n] [--max-latency ms] [--ramp s] [--seconds s] [--int8 scales.txt] <source> [<source> ...]" << std::endl;
+        return -1;
+    }
+
+    std::shared_ptr<FaceModels> models;
+    try {
+        models = loadFaceModels("shape_predictor_68_face_landmarks.dat", "dlib_face_recognition_resnet_model_v1.dat", "face_models.cache");
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: Unable to load the face models: " << e.what() << std::endl;
+        return -1;
+    }
+    const dlib::shape_predictor& shape_predictor = models->shape_predictor; // Thread safe, shared
+
+    // int8 ResNet: one set of packed weights, shared by the per-worker copies
+    std::unique_ptr<QuantizedFaceNet> quantized;
+    if (!scales_path.empty()) {
+        FaceNetWeights weights;
+        FaceNetScales scales;
+        if (!faceNetWeights(*models, weights)) {
+            std::cerr << "Error: The ResNet does not have the layout of anet_type" << std::endl;
+            return -1;
+        }
+        if (!scales.load(scales_path) || scales.activation.size() != 1 + 2 * weights.blocks.size()) {
+            std::cerr << "Error: Unable to read the int8 scales " << scales_path << std::endl;
+            return -1;
+        }
+        quantized.reset(new QuantizedFaceNet(weights, scales));
+    }
+
+    WorkStealingPool pool(threads);
+    std::vector<std::unique_ptr<WorkerModels>> worker_models;
+    for (int i = 0; i < pool.threads(); ++i) {
+        worker_models.emplace_back(new WorkerModels{ models->face_detector, FaceEncoder(*models), nullptr });
+        if (quantized) worker_models.back()->quantized.reset(new QuantizedFaceNet(*quantized));
+    }
+
+    // Reference embedding, computed once and shared read-only by every stream
+    std::shared_ptr<const dlib::matrix<float, 0, 1>> reference;
+    if (!reference_path.empty()) {
+        cv::Mat image = cv::imread(reference_path, cv::IMREAD_COLOR);
+        if (image.empty()) {
+            std::cerr << "Error: Unable to read " << reference_path << std::endl;
+            return -1;
+        }
+        dlib::cv_image<dlib::bgr_pixel> dlib_image(image);
+        std::vector<dlib::rectangle> faces = models->face_detector(dlib_image);
+        if (faces.empty()) {
+            std::cerr << "Error: No face in " << reference_path << std::endl;
+            return -1;
+        }
+        dlib::matrix<dlib::rgb_pixel> chip;
+        dlib::extract_image_chip(dlib_image, dlib::get_face_chip_details(shape_predictor(dlib_image, faces[0]), 150, 0.25), chip);
+        reference = std::make_shared<const dlib::matrix<float, 0, 1>>(worker_models[0]->describe(chip));
+    }
+
+    std::vector<std::unique_ptr<Stream>> streams;
+    for (const std::string& name : sources) streams.emplace_back(new Stream(name));
+
+    PyramidConfig gray_only;
+    gray_only.levels = 1;
+    auto openStream = [&](Stream& stream) {
+        stream.source.setPyramid(gray_only);
+        stream.source.setRealtime(true);
+        if (!stream.source.open(stream.name, FrameSourceMode::LatestOnly)) {
+            std::cerr << "Error: Unable to open " << stream.name << std::endl;
+            stream.ended = true;
+            return false;
+        }
+        return true;
+    };
+
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    // One frame of one stream, run on any pool worker
+    auto processFrame = [&](Stream& stream, Frame& captured, int worker) {
+        TRACE_SCOPE("stream.frame");
+        size_t face_count = 0, match_count = 0;
+        const bool late = msSince(captured.capture_time) > max_latency_ms;
+        if (!late) {
+            WorkerModels& local = *worker_models[worker];
+            dlib::cv_image<dlib::bgr_pixel> dlib_frame(captured.image);
+            cv::Mat gray = asMat(captured.pyramid->gray());
+            dlib::cv_image<unsigned char> dlib_gray(gray);
+
+            std::vector<dlib::rectangle> faces;
+            {
+                TRACE_SCOPE("face_detector");
+                faces = local.face_detector(dlib_gray);
+            }
+            std::vector<Detection> detections;
+            for (const dlib::rectangle& face : faces) {
+                detections.push_back({ face.left() + face.width() / 2.0f, face.top() + face.height() / 2.0f });
+                if (!reference) continue;
+
+                dlib::full_object_detection shape;
+                {
+                    TRACE_SCOPE("shape_predictor");
+                    shape = shape_predictor(dlib_gray, face);
+                }
+                dlib::matrix<dlib::rgb_pixel> face_chip;
+                dlib::extract_image_chip(dlib_frame, dlib::get_face_chip_details(shape, 150, 0.25), face_chip);
+                dlib::matrix<float, 0, 1> encoding;
+                {
+                    TRACE_SCOPE("resnet");
+                    encoding = local.describe(face_chip);
+                }
+                if (dlib::length(encoding - *reference) < 0.6) match_count++;
+            }
+            {
+                TRACE_SCOPE("tracker.step");
+                stream.tracker.step(detections);
+            }
+            face_count = faces.size();
+        }
+
+        const double latency_ms = msSince(captured.capture_time);
+        std::lock_guard<std::mutex> lock(mutex);
+        stream.in_flight = false;
+        if (late) {
+            stream.late++;
+        }
+        else {
+            stream.processed++;
+            stream.faces += face_count;
+            stream.matches += match_count;
+            stream.latencies_ms.push_back(latency_ms);
+        }
+        changed.notify_one();
+    };
+
+    // Aggregate fps and latency since the previous report, then per stream
+    auto report = [&](size_t active, double window_s, bool per_stream) {
+        std::vector<double> all;
+        uint64_t frames = 0, late = 0;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < active; ++i) {
+            Stream& stream = *streams[i];
+            all.insert(all.end(), stream.latencies_ms.begin(), stream.latencies_ms.end());
+            frames += stream.latencies_ms.size();
+            if (per_stream) {
+                Percentiles p = percentiles(stream.latencies_ms);
+                std::printf("  %-24s %8llu frames, %6llu late, %6llu dropped at source, p50 %.1f ms, p99 %.1f ms, faces %llu, matches %llu\n",
+                    stream.name.c_str(), static_cast<unsigned long long>(stream.processed), static_cast<unsigned long long>(stream.late),
+                    static_cast<unsigned long long>(stream.source.droppedFrames()), p.p50, p.p99,
+                    static_cast<unsigned long long>(stream.faces), static_cast<unsigned long long>(stream.matches));
+            }
+            late += stream.late;
+            stream.latencies_ms.clear();
+        }
+        Percentiles p = percentiles(all);
+        std::printf("[server] %zu streams: %.1f fps aggregate (%.1f per stream), latency p50 %.1f ms, p99 %.1f ms, max %.1f ms, %llu late in total, RSS %.0f MB\n",
+            active, frames / window_s, frames / window_s / std::max<size_t>(active, 1), p.p50, p.p99, p.max,
+            static_cast<unsigned long long>(late), residentSetBytes() / 1048576.0);
+    };
+
+    // Dispatch: hand each idle stream its newest frame, round robin, stream i preferring worker i
+    const auto start = Clock::now();
+    auto last_report = start;
+    size_t active = ramp_s > 0.0 ? 1 : streams.size();
+    for (size_t i = 0; i < active; ++i) openStream(*streams[i]);
+    std::printf("[server] %zu sources, %d workers, max latency %.0f ms%s%s\n", streams.size(), pool.threads(), max_latency_ms,
+        reference ? ", matching against the reference" : "", quantized ? " (int8 ResNet)" : "");
+
+    while (true) {
+        const double elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+        if (run_s > 0.0 && elapsed_s >= run_s) break;
+
+        // Add the next stream at the end of each ramp step, after reporting the current count
+        const double since_report_s = std::chrono::duration<double>(Clock::now() - last_report).count();
+        if (ramp_s > 0.0 ? since_report_s >= ramp_s : since_report_s >= 5.0) {
+            report(active, since_report_s, false);
+            last_report = Clock::now();
+            if (ramp_s > 0.0 && active < streams.size()) openStream(*streams[active++]);
+        }
+
+        bool dispatched = false, all_ended = true;
+        for (size_t i = 0; i < active; ++i) {
+            Stream& stream = *streams[i];
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stream.ended) continue;
+                all_ended = false;
+                if (stream.in_flight) continue;
+            }
+            auto frame = std::make_shared<Frame>();
+            if (!stream.source.tryRead(*frame)) {
+                if (stream.source.finished()) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stream.ended = true;
+                }
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stream.in_flight = true;
+            }
+            pool.submit([&, frame, i](int worker) { processFrame(*streams[i], *frame, worker); }, static_cast<int>(i));
+            dispatched = true;
+        }
+        if (all_ended && active == streams.size()) break;
+        if (!dispatched) {
+            // Woken by a finished frame, or poll the sources again shortly
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+    pool.waitIdle();
+
+    const double total_s = std::chrono::duration<double>(Clock::now() - start).count();
+    uint64_t total_frames = 0;
+    for (size_t i = 0; i < active; ++i) total_frames += streams[i]->processed;
+    std::printf("[server] done: %llu frames in %.1f s (%.1f fps aggregate), %llu pool tasks, %llu stolen\n",
+        static_cast<unsigned long long>(total_frames), total_s, total_frames / total_s,
+        static_cast<unsigned long long>(pool.executed()), static_cast<unsigned long long>(pool.stolen()));
+    report(active, std::chrono::duration<double>(Clock::now() - last_report).count(), true);
+    for (std::unique_ptr<Stream>& stream : streams) stream->source.close();
+    return 0;
+}
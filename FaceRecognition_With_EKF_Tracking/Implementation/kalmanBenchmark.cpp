@@ -0,0 +1,119 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// kalmanBenchmark.cpp : Predict + update throughput of the fixed-size Kalman kernels
+// against the original cv::Mat EKF functions of movingFaceRecog.cpp.
+//
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "kalmanFilter.h"
+
+// Original EKF functions, kept verbatim as the baseline
+namespace legacy {
+
+void predict(cv::Mat& state, cv::Mat& P, const cv::Mat& u, const cv::Mat& R) {
+    state += u;
+    P = P + R;
+}
+
+void update(cv::Mat& state, cv::Mat& P, const cv::Mat& z, const cv::Mat& H, const cv::Mat& Q) {
+    cv::Mat predicted_observation = H * state;
+    cv::Mat y = z - predicted_observation(cv::Range(0, 2), cv::Range::all());
+    cv::Mat S = H * P * H.t() + Q;
+    cv::Mat K = P * H.t() * S.inv();
+    state += K * y;
+    cv::Mat I = cv::Mat::eye(3, 3, CV_64F);
+    P = (I - K * H) * P;
+}
+
+} // namespace legacy
+
+using Filter = KalmanFilter<double, 3, 2>;
+
+// Synthetic face centre measurement for filter i at step k
+static void measurement(size_t i, int k, double& zx, double& zy) {
+    zx = 320.0 + 100.0 * std::cos(0.05 * k + i);
+    zy = 240.0 + 80.0 * std::sin(0.05 * k + i);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    const int steps = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const size_t batch = 4096;
+
+    // Same noise settings as movingFaceRecog.cpp
+    const double process_xy = 0.5, process_theta = 5.0 * CV_PI / 180.0, measurement_var = 2.0;
+
+    // 1. cv::Mat baseline
+    cv::Mat state = cv::Mat::zeros(3, 1, CV_64F);
+    cv::Mat P = cv::Mat::eye(3, 3, CV_64F) * 500;
+    cv::Mat R = (cv::Mat_<double>(3, 3) << process_xy, 0, 0, 0, process_xy, 0, 0, 0, process_theta);
+    cv::Mat Q = cv::Mat::eye(2, 2, CV_64F) * measurement_var;
+    cv::Mat u = cv::Mat::zeros(3, 1, CV_64F);
+    cv::Mat H = cv::Mat::eye(2, 3, CV_64F);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int k = 0; k < steps; ++k) {
+        double zx, zy;
+        measurement(0, k, zx, zy);
+        cv::Mat z = (cv::Mat_<double>(2, 1) << zx, zy);
+        legacy::predict(state, P, u, R);
+        legacy::update(state, P, z, H, Q);
+    }
+    const double legacy_rate = steps / secondsSince(start);
+
+    // 2. Fixed-size filter, one at a time
+    Filter::StateMatrix process_cov = Filter::StateMatrix::zeros();
+    process_cov(0, 0) = process_cov(1, 1) = process_xy;
+    process_cov(2, 2) = process_theta;
+    const Filter::MeasurementMatrix Hf = Filter::MeasurementMatrix::identity();
+    const Filter::MeasurementCov measurement_cov = measurement_var * Filter::MeasurementCov::identity();
+    const Filter::StateVector no_control = Filter::StateVector::zeros();
+
+    Filter filter;
+    filter.initialize(Filter::StateVector::zeros(), 500.0 * Filter::StateMatrix::identity());
+    start = std::chrono::steady_clock::now();
+    for (int k = 0; k < steps; ++k) {
+        Filter::MeasurementVector z;
+        measurement(0, k, z(0, 0), z(1, 0));
+        filter.predict(no_control, process_cov);
+        filter.update(z, Hf, measurement_cov);
+    }
+    const double fixed_rate = steps / secondsSince(start);
+
+    // Both implementations should produce the same estimate
+    const double diff = std::fabs(filter.x(0, 0) - state.at<double>(0)) + std::fabs(filter.x(1, 0) - state.at<double>(1)) +
+        std::fabs(filter.P(0, 0) - P.at<double>(0, 0));
+
+    // 3. Batched updates over a contiguous array of filters
+    std::vector<Filter> filters(batch);
+    for (auto& f : filters) f.initialize(Filter::StateVector::zeros(), 500.0 * Filter::StateMatrix::identity());
+    std::vector<Filter::MeasurementVector> measurements(batch);
+    const int batch_steps = std::max(1, steps / static_cast<int>(batch)) * 16;
+
+    double batch_seconds = 0.0;
+    for (int k = 0; k < batch_steps; ++k) {
+        for (size_t i = 0; i < batch; ++i) measurement(i, k, measurements[i](0, 0), measurements[i](1, 0));
+        start = std::chrono::steady_clock::now();
+        batchPredict(filters.data(), batch, no_control, process_cov);
+        batchUpdate(filters.data(), measurements.data(), batch, Hf, measurement_cov);
+        batch_seconds += secondsSince(start);
+    }
+    const double batch_rate = batch_steps * static_cast<double>(batch) / batch_seconds;
+
+    std::printf("%-28s %14s %10s\n", "implementation", "updates/sec", "speedup");
+    std::printf("%-28s %14.0f %9.1fx\n", "cv::Mat (original)", legacy_rate, 1.0);
+    std::printf("%-28s %14.0f %9.1fx\n", "KalmanFilter<double,3,2>", fixed_rate, fixed_rate / legacy_rate);
+    std::printf("%-28s %14.0f %9.1fx\n", "batchUpdate (4096 filters)", batch_rate, batch_rate / legacy_rate);
+    std::printf("deviation from cv::Mat result (|dx| + |dy| + |dP00|): %g\n", diff);
+    return 0;
+}
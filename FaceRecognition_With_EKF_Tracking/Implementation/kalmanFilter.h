@@ -0,0 +1,222 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// kalmanFilter.h : Fixed-size, allocation-free Kalman / EKF kernels.
+//
+// All matrices have compile-time dimensions and live on the stack, so predict() and
+// update() never touch the heap. The update uses a Cholesky solve of the innovation
+// covariance instead of an explicit inverse and the Joseph form for the covariance,
+// which keeps P symmetric positive definite under round-off.
+//
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+template <typename T, int R, int C>
+struct Matrix {
+    T m[R][C];
+
+    T& operator()(int r, int c) { return m[r][c]; }
+    const T& operator()(int r, int c) const { return m[r][c]; }
+
+    static Matrix zeros() {
+        Matrix out;
+        for (int r = 0; r < R; ++r)
+            for (int c = 0; c < C; ++c) out.m[r][c] = T(0);
+        return out;
+    }
+
+    static Matrix identity() {
+        Matrix out = zeros();
+        for (int i = 0; i < (R < C ? R : C); ++i) out.m[i][i] = T(1);
+        return out;
+    }
+
+    Matrix<T, C, R> t() const {
+        Matrix<T, C, R> out;
+        for (int r = 0; r < R; ++r)
+            for (int c = 0; c < C; ++c) out.m[c][r] = m[r][c];
+        return out;
+    }
+};
+
+template <typename T, int N>
+using Vector = Matrix<T, N, 1>;
+
+template <typename T, int R, int C>
+inline Matrix<T, R, C> operator+(const Matrix<T, R, C>& a, const Matrix<T, R, C>& b) {
+    Matrix<T, R, C> out;
+    for (int r = 0; r < R; ++r)
+        for (int c = 0; c < C; ++c) out.m[r][c] = a.m[r][c] + b.m[r][c];
+    return out;
+}
+
+template <typename T, int R, int C>
+inline Matrix<T, R, C> operator-(const Matrix<T, R, C>& a, const Matrix<T, R, C>& b) {
+    Matrix<T, R, C> out;
+    for (int r = 0; r < R; ++r)
+        for (int c = 0; c < C; ++c) out.m[r][c] = a.m[r][c] - b.m[r][c];
+    return out;
+}
+
+template <typename T, int R, int K, int C>
+inline Matrix<T, R, C> operator*(const Matrix<T, R, K>& a, const Matrix<T, K, C>& b) {
+    Matrix<T, R, C> out;
+    for (int r = 0; r < R; ++r) {
+        for (int c = 0; c < C; ++c) {
+            T sum = T(0);
+            for (int k = 0; k < K; ++k) sum += a.m[r][k] * b.m[k][c];
+            out.m[r][c] = sum;
+        }
+    }
+    return out;
+}
+
+template <typename T, int R, int C>
+inline Matrix<T, R, C> operator*(T s, const Matrix<T, R, C>& a) {
+    Matrix<T, R, C> out;
+    for (int r = 0; r < R; ++r)
+        for (int c = 0; c < C; ++c) out.m[r][c] = s * a.m[r][c];
+    return out;
+}
+
+// In-place Cholesky factorization A = L L^T; the lower triangle of A receives L.
+// Returns false when A is not positive definite.
+template <typename T, int N>
+inline bool cholesky(Matrix<T, N, N>& A) {
+    for (int j = 0; j < N; ++j) {
+        T d = A.m[j][j];
+        for (int k = 0; k < j; ++k) d -= A.m[j][k] * A.m[j][k];
+        if (!(d > T(0))) return false;
+        const T l = std::sqrt(d);
+        A.m[j][j] = l;
+        const T inv_l = T(1) / l;
+        for (int i = j + 1; i < N; ++i) {
+            T s = A.m[i][j];
+            for (int k = 0; k < j; ++k) s -= A.m[i][k] * A.m[j][k];
+            A.m[i][j] = s * inv_l;
+        }
+    }
+    return true;
+}
+
+// Solve L L^T X = B in place (B becomes X) given the factor from cholesky()
+template <typename T, int N, int K>
+inline void choleskySolve(const Matrix<T, N, N>& L, Matrix<T, N, K>& B) {
+    for (int c = 0; c < K; ++c) {
+        // Forward substitution: L y = b
+        for (int i = 0; i < N; ++i) {
+            T s = B.m[i][c];
+            for (int k = 0; k < i; ++k) s -= L.m[i][k] * B.m[k][c];
+            B.m[i][c] = s / L.m[i][i];
+        }
+        // Back substitution: L^T x = y
+        for (int i = N - 1; i >= 0; --i) {
+            T s = B.m[i][c];
+            for (int k = i + 1; k < N; ++k) s -= L.m[k][i] * B.m[k][c];
+            B.m[i][c] = s / L.m[i][i];
+        }
+    }
+}
+
+// Kalman filter with N states and M measurements
+template <typename T, int N, int M>
+class KalmanFilter {
+public:
+    using StateVector = Vector<T, N>;
+    using StateMatrix = Matrix<T, N, N>;
+    using MeasurementVector = Vector<T, M>;
+    using MeasurementMatrix = Matrix<T, M, N>;
+    using MeasurementCov = Matrix<T, M, M>;
+
+    StateVector x;
+    StateMatrix P;
+
+    void initialize(const StateVector& x0, const StateMatrix& P0) {
+        x = x0;
+        P = P0;
+    }
+
+    // Additive motion: x = x + u, P = P + Q
+    void predict(const StateVector& u, const StateMatrix& Q) {
+        x = x + u;
+        P = P + Q;
+    }
+
+    // Linear / linearized motion: x = F x (or f(x) given as fx), P = F P F^T + Q
+    void predict(const StateMatrix& F, const StateMatrix& Q) {
+        predictTo(F * x, F, Q);
+    }
+
+    void predictTo(const StateVector& fx, const StateMatrix& F, const StateMatrix& Q) {
+        x = fx;
+        P = F * P * F.t() + Q;
+    }
+
+    // Innovation covariance S = H P H^T + R
+    MeasurementCov innovationCov(const MeasurementMatrix& H, const MeasurementCov& R) const {
+        return H * P * H.t() + R;
+    }
+
+    // Linear update with predicted measurement H x
+    bool update(const MeasurementVector& z, const MeasurementMatrix& H, const MeasurementCov& R) {
+        return updateWith(z, H * x, H, R);
+    }
+
+    // EKF update: hx is the predicted measurement h(x), H its Jacobian.
+    // Returns false (and leaves the filter untouched) if S is not positive definite.
+    bool updateWith(const MeasurementVector& z, const MeasurementVector& hx,
+        const MeasurementMatrix& H, const MeasurementCov& R) {
+        // K^T = S^-1 (H P), solved with Cholesky since S is symmetric positive definite
+        const Matrix<T, M, N> HP = H * P;
+        MeasurementCov L = HP * H.t() + R;
+        if (!cholesky(L)) return false;
+        Matrix<T, M, N> Kt = HP;
+        choleskySolve(L, Kt);
+        const Matrix<T, N, M> K = Kt.t();
+
+        x = x + K * (z - hx);
+
+        // Joseph form: P = (I - K H) P (I - K H)^T + K R K^T
+        const StateMatrix A = StateMatrix::identity() - K * H;
+        P = A * P * A.t() + K * R * Kt;
+        symmetrize();
+        return true;
+    }
+
+private:
+    void symmetrize() {
+        for (int r = 0; r < N; ++r) {
+            for (int c = r + 1; c < N; ++c) {
+                const T v = T(0.5) * (P.m[r][c] + P.m[c][r]);
+                P.m[r][c] = v;
+                P.m[c][r] = v;
+            }
+        }
+    }
+};
+
+// Batched kernels over a contiguous array of filters sharing the same model matrices
+template <typename T, int N, int M>
+inline void batchPredict(KalmanFilter<T, N, M>* filters, size_t count,
+    const Vector<T, N>& u, const Matrix<T, N, N>& Q) {
+    for (size_t i = 0; i < count; ++i) filters[i].predict(u, Q);
+}
+
+template <typename T, int N, int M>
+inline void batchPredict(KalmanFilter<T, N, M>* filters, size_t count,
+    const Matrix<T, N, N>& F, const Matrix<T, N, N>& Q) {
+    for (size_t i = 0; i < count; ++i) filters[i].predict(F, Q);
+}
+
+// Update filters[i] with measurements[i]; returns the number of successful updates
+template <typename T, int N, int M>
+inline size_t batchUpdate(KalmanFilter<T, N, M>* filters, const Vector<T, M>* measurements, size_t count,
+    const Matrix<T, M, N>& H, const Matrix<T, M, M>& R) {
+    size_t updated = 0;
+    for (size_t i = 0; i < count; ++i) {
+        updated += filters[i].update(measurements[i], H, R) ? 1 : 0;
+    }
+    return updated;
+}
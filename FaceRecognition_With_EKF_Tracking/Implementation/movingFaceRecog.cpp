@@ -6,123 +6,109 @@
 
 #include <opencv2/opencv.hpp>
 #include <dlib/opencv.h>
-#include <dlib/image_processing/frontal_face_detector.h>
-#include <dlib/image_processing.h>
-#include <dlib/dnn.h>
+#include <chrono>
 #include <iostream>
 #include <vector>
 #include <cmath>
 #include <numeric>
 
-// Alias for dlib's face recognition model
+#include "faceEnrollment.h"
+#include "faceModels.h"
+#include "frameSource.h"
+#include "kalmanTrackPool.h"
+#include "latencyMeter.h"
+#include "processStats.h"
+#include "pyramidFeatures.h"
+#include "trackManager.h"
+#include "tracing.h"
 
 using namespace dlib;
 using namespace std;
 
 
-template <template <int, template<typename> class, int, typename> class block, int N, template<typename> class BN, typename SUBNET>
-using residual = dlib::add_prev1<block<N, BN, 1, dlib::tag1<SUBNET>>>;
+int main(int argc, char** argv) {
+    auto program_start = std::chrono::steady_clock::now();
 
-template <template <int, template<typename> class, int, typename> class block, int N, template<typename> class BN, typename SUBNET>
-using residual_down = dlib::add_prev2<dlib::avg_pool<2, 2, 2, 2, dlib::skip1<dlib::tag2<block<N, BN, 2, dlib::tag1<SUBNET>>>>>>;
+    // Per-stage timings, enabled with PERCEPTION_TRACE
+    trace::Session tracing("moving_face_recog");
 
-template <int N, template <typename> class BN, int stride, typename SUBNET>
-using block = BN<dlib::con<N, 3, 3, 1, 1, dlib::relu<BN<dlib::con<N, 3, 3, stride, stride, SUBNET>>>>>;
+    // Load Dlib models in the background while the camera starts up
+    FaceModelLoader model_loader("shape_predictor_68_face_landmarks.dat",
+        "dlib_face_recognition_resnet_model_v1.dat", "face_models.cache");
 
-template <int N, typename SUBNET> using ares = dlib::relu<residual<block, N, dlib::affine, SUBNET>>;
-template <int N, typename SUBNET> using ares_down = dlib::relu<residual_down<block, N, dlib::affine, SUBNET>>;
-
-template <typename SUBNET> using alevel0 = ares_down<256, SUBNET>;
-template <typename SUBNET> using alevel1 = ares<256, ares<256, ares_down<256, SUBNET>>>;
-template <typename SUBNET> using alevel2 = ares<128, ares<128, ares_down<128, SUBNET>>>;
-template <typename SUBNET> using alevel3 = ares<64, ares<64, ares<64, ares_down<64, SUBNET>>>>;
-template <typename SUBNET> using alevel4 = ares<32, ares<32, ares<32, SUBNET>>>;
-
-using anet_type = dlib::loss_metric<dlib::fc_no_bias<128, dlib::avg_pool_everything<
-    alevel0<
-    alevel1<
-    alevel2<
-    alevel3<
-    alevel4<
-    dlib::max_pool<3, 3, 2, 2, dlib::relu<dlib::affine<dlib::con<32, 7, 7, 2, 2,
-    dlib::input_rgb_image_sized<150> >>>>>>>>>>>>;
-
-
-// EKF Predict Step
-void predict(cv::Mat& state, cv::Mat& P, const cv::Mat& u, const cv::Mat& R) {
-    state += u;
-    P = P + R;
-}
-
-// EKF Update Step
-void update(cv::Mat& state, cv::Mat& P, const cv::Mat& z, const cv::Mat& H, const cv::Mat& Q) {
-    cv::Mat predicted_observation = H * state;
-    cv::Mat y = z - predicted_observation(cv::Range(0, 2), cv::Range::all());
-    cv::Mat S = H * P * H.t() + Q;
-    cv::Mat K = P * H.t() * S.inv();
-    state += K * y;
-    cv::Mat I = cv::Mat::eye(3, 3, CV_64F);
-    P = (I - K * H) * P;
-}
-
-int main() {
-    // Initialize video capture
-    cv::VideoCapture cap(0);
-    if (!cap.isOpened()) {
-        std::cerr << "Error: Unable to open the camera." << std::endl;
+    // Initialize video capture: camera index, video file or image directory
+    std::string source_path = argc > 1 ? argv[1] : "0";
+    // The decode thread converts to grayscale once for the detector and landmarks
+    FrameSource source;
+    PyramidConfig gray_only;
+    gray_only.levels = 1;
+    source.setPyramid(gray_only);
+    if (!source.open(source_path)) {
+        std::cerr << "Error: Unable to open " << source_path << std::endl;
         return -1;
     }
-
-    // Load Dlib models
-    dlib::frontal_face_detector face_detector = dlib::get_frontal_face_detector();
-    dlib::shape_predictor shape_predictor;
-    dlib::deserialize("shape_predictor_68_face_landmarks.dat") >> shape_predictor;
-    anet_type face_recognizer;
-    dlib::deserialize("dlib_face_recognition_resnet_model_v1.dat") >> face_recognizer;
-
-    // Capture a reference face encoding
-    dlib::matrix<float, 0, 1> known_face_encoding;
-    bool reference_face_captured = false;
-    while (!reference_face_captured) {
-        cv::Mat frame;
-        cap >> frame;
-        if (frame.empty()) break;
-
-        dlib::cv_image<dlib::bgr_pixel> dlib_frame(frame);
-        std::vector<dlib::rectangle> faces = face_detector(dlib_frame);
-
-        if (!faces.empty()) {
-            dlib::full_object_detection shape = shape_predictor(dlib_frame, faces[0]);
-            // Align face and create a face chip
-            matrix<rgb_pixel> face_chip;
-            extract_image_chip(dlib_frame, get_face_chip_details(shape, 150, 0.25), face_chip);
-
-            known_face_encoding = face_recognizer(face_chip);
-            reference_face_captured = true;
-        }
-
-        cv::imshow("Capture Reference Face", frame);
-        if (cv::waitKey(1) == 'q') break;
+    LatencyMeter latency("moving_face_recog");
+
+    // Show the camera feed while the models finish loading
+    while (!model_loader.ready()) {
+        Frame captured;
+        if (!source.read(captured)) break;
+        cv::Mat& frame = captured.image;
+        cv::putText(frame, "Loading models...", cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 2);
+        cv::imshow("EKF-SLAM with Face Recognition", frame);
+        if (cv::waitKey(1) == 'q') return 0;
     }
 
-    // EKF initialization
-    cv::Mat state = cv::Mat::zeros(3, 1, CV_64F); // [x, y, theta]
-    cv::Mat P = cv::Mat::eye(3, 3, CV_64F) * 500;
+    std::shared_ptr<FaceModels> models;
+    try {
+        models = model_loader.get();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: Unable to load the face models: " << e.what() << std::endl;
+        return -1;
+    }
+    dlib::frontal_face_detector& face_detector = models->face_detector;
+    dlib::shape_predictor& shape_predictor = models->shape_predictor;
+    FaceEncoder face_recognizer(*models);
 
-    cv::Mat R = (cv::Mat_<double>(3, 3) << 0.5, 0, 0,
-        0, 0.5, 0,
-        0, 0, 5.0 * CV_PI / 180.0);
+    // EKF initialization: one [x, y, theta] filter per tracked face. Every track is
+    // predicted once per frame, so the position process noise covers a frame of motion.
+    const size_t max_tracks = 64;
+    KalmanTrackPool track_pool(max_tracks, 100.0, 5.0 * CV_PI / 180.0, 2.0, 500.0);
+    TrackManager<KalmanTrackPool> tracker(track_pool);
 
-    cv::Mat Q = cv::Mat::eye(2, 2, CV_64F) * 2;
+    // Enroll the reference face on a worker thread while tracking already runs
+    FaceEnrollment enrollment(models);
+    bool first_frame_reported = false;
 
     while (true) {
-        cv::Mat frame;
-        cap >> frame;
-        if (frame.empty()) break;
+        Frame captured;
+        if (!source.read(captured)) break;
+        cv::Mat& frame = captured.image;
+        TRACE_SCOPE("frame");
 
         dlib::cv_image<dlib::bgr_pixel> dlib_frame(frame);
-        std::vector<dlib::rectangle> faces = face_detector(dlib_frame);
+        cv::Mat gray = asMat(captured.pyramid->gray());
+        dlib::cv_image<unsigned char> dlib_gray(gray);
+        std::vector<dlib::rectangle> faces;
+        {
+            TRACE_SCOPE("face_detector");
+            faces = face_detector(dlib_gray);
+        }
+        TRACE_COUNTER("faces", faces.size());
+        if (!first_frame_reported) {
+            double ttff_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - program_start).count();
+            std::cout << "Time to first frame: " << ttff_ms << " ms, RSS: " << residentSetBytes() / 1048576.0 << " MB"
+                << (models->from_cache ? " (model cache)" : "") << std::endl;
+            first_frame_reported = true;
+        }
+
+        // Hand the frame to the enrollment worker (skipped while it is busy or done)
+        enrollment.submit(frame, faces);
+        std::shared_ptr<const FaceEmbedding> known_face_encoding = enrollment.reference();
 
+        std::vector<Detection> detections;
+        std::vector<bool> matched;
         for (const auto& face : faces) {
             int x = face.left();
             int y = face.top();
@@ -130,40 +116,75 @@ int main() {
             int h = face.height();
             cv::rectangle(frame, cv::Rect(x, y, w, h), cv::Scalar(255, 0, 0), 2);
 
-            dlib::full_object_detection shape = shape_predictor(dlib_frame, face);
-            matrix<rgb_pixel> face_chip;
-            extract_image_chip(dlib_frame, get_face_chip_details(shape, 150, 0.25), face_chip);
-
-            dlib::matrix<float, 0, 1> current_face_encoding = face_recognizer(face_chip);
+            // The ResNet only runs once there is a reference to compare against
+            bool is_match = false;
+            if (known_face_encoding) {
+                dlib::full_object_detection shape;
+                {
+                    TRACE_SCOPE("shape_predictor");
+                    shape = shape_predictor(dlib_gray, face);
+                }
+                matrix<rgb_pixel> face_chip;
+                extract_image_chip(dlib_frame, get_face_chip_details(shape, 150, 0.25), face_chip);
+
+                dlib::matrix<float, 0, 1> current_face_encoding;
+                {
+                    TRACE_SCOPE("resnet");
+                    current_face_encoding = face_recognizer(face_chip);
+                }
+
+                double match_distance = dlib::length(current_face_encoding - *known_face_encoding);
+                is_match = match_distance < 0.6;
+            }
+            matched.push_back(is_match);
+            detections.push_back({ x + w / 2.0f, y + h / 2.0f });
+        }
 
-            double match_distance = dlib::length(current_face_encoding - known_face_encoding);
-            if (match_distance < 0.6) {
-                cv::putText(frame, "Matched", cv::Point(x, y - 10), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 255, 0), 1);
+        // EKF Predict and Update for all tracks, with gated detection assignment
+        {
+            TRACE_SCOPE("tracker.step");
+            tracker.step(detections);
+        }
 
-                cv::Mat face_center = (cv::Mat_<double>(2, 1) << x + w / 2.0, y + h / 2.0);
+        TRACE_SCOPE("display");
+        int state_row = 0;
+        for (size_t i = 0; i < faces.size(); ++i) {
+            const int slot = tracker.trackForDetection(i);
+            const std::string track_text = slot >= 0 ? " #" + std::to_string(tracker.id(slot)) : "";
+            cv::Point label_origin(faces[i].left(), faces[i].top() - 10);
 
-                // EKF Predict and Update
-                cv::Mat u = cv::Mat::zeros(3, 1, CV_64F); // No control input
-                predict(state, P, u, R);
-                cv::Mat H = cv::Mat::eye(2, 3, CV_64F);
-                update(state, P, face_center, H, Q);
+            if (matched[i]) {
+                cv::putText(frame, "Matched" + track_text, label_origin, cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 255, 0), 1);
+                if (slot < 0) continue;
 
-                std::string state_text = "State: x=" + std::to_string(state.at<double>(0)) + ", y=" +
-                    std::to_string(state.at<double>(1)) + ", theta=" +
-                    std::to_string(state.at<double>(2) * 180.0 / CV_PI);
+                float state_x, state_y;
+                tracker.pool().position(slot, state_x, state_y);
+                std::string state_text = "State" + track_text + ": x=" + std::to_string(state_x) + ", y=" +
+                    std::to_string(state_y) + ", theta=" +
+                    std::to_string(tracker.pool().theta(slot) * 180.0 / CV_PI);
 
-                cv::putText(frame, state_text, cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 255, 255), 1);
+                cv::putText(frame, state_text, cv::Point(10, 30 + 20 * state_row++), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 255, 255), 1);
+            }
+            else if (known_face_encoding) {
+                cv::putText(frame, "Unknown" + track_text, label_origin, cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 255), 1);
             }
             else {
-                cv::putText(frame, "Unknown", cv::Point(x, y - 10), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 255), 1);
+                cv::putText(frame, "Enrolling" + track_text, label_origin, cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 255, 255), 1);
             }
         }
 
+        if (!known_face_encoding) {
+            std::string enroll_text = "Enrolling reference face: " + std::to_string(enrollment.acceptedChips()) + " good frames";
+            cv::putText(frame, enroll_text, cv::Point(10, frame.rows - 10), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 255, 255), 1);
+        }
+
         cv::imshow("EKF-SLAM with Face Recognition", frame);
+        latency.addSince(captured.capture_time);
         if (cv::waitKey(1) == 'q') break;
     }
 
-    cap.release();
+    std::cout << "Dropped frames: " << source.droppedFrames() << std::endl;
+    source.close();
     cv::destroyAllWindows();
 
     return 0;
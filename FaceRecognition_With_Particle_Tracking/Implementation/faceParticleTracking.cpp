@@ -5,178 +5,170 @@
 //
 #include <opencv2/opencv.hpp>
 #include <dlib/opencv.h>
-#include <dlib/image_processing/frontal_face_detector.h>
-#include <dlib/image_processing.h>
-#include <dlib/dnn.h>
+#include <chrono>
 #include <random>
 #include <vector>
 #include <numeric>
 
-// Alias for dlib's face recognition model
+#include "faceModels.h"
+#include "frameSource.h"
+#include "latencyMeter.h"
+#include "particleTrackPool.h"
+#include "processStats.h"
+#include "pyramidFeatures.h"
+#include "trackManager.h"
+#include "tracing.h"
+
 using namespace dlib;
 using namespace std;
 
-
-template <template <int, template<typename> class, int, typename> class block, int N, template<typename> class BN, typename SUBNET>
-using residual = dlib::add_prev1<block<N, BN, 1, dlib::tag1<SUBNET>>>;
-
-template <template <int, template<typename> class, int, typename> class block, int N, template<typename> class BN, typename SUBNET>
-using residual_down = dlib::add_prev2<dlib::avg_pool<2, 2, 2, 2, dlib::skip1<dlib::tag2<block<N, BN, 2, dlib::tag1<SUBNET>>>>>>;
-
-template <int N, template <typename> class BN, int stride, typename SUBNET>
-using block = BN<dlib::con<N, 3, 3, 1, 1, dlib::relu<BN<dlib::con<N, 3, 3, stride, stride, SUBNET>>>>>;
-
-template <int N, typename SUBNET> using ares = dlib::relu<residual<block, N, dlib::affine, SUBNET>>;
-template <int N, typename SUBNET> using ares_down = dlib::relu<residual_down<block, N, dlib::affine, SUBNET>>;
-
-template <typename SUBNET> using alevel0 = ares_down<256, SUBNET>;
-template <typename SUBNET> using alevel1 = ares<256, ares<256, ares_down<256, SUBNET>>>;
-template <typename SUBNET> using alevel2 = ares<128, ares<128, ares_down<128, SUBNET>>>;
-template <typename SUBNET> using alevel3 = ares<64, ares<64, ares<64, ares_down<64, SUBNET>>>>;
-template <typename SUBNET> using alevel4 = ares<32, ares<32, ares<32, SUBNET>>>;
-
-using anet_type = dlib::loss_metric<dlib::fc_no_bias<128, dlib::avg_pool_everything<
-    alevel0<
-    alevel1<
-    alevel2<
-    alevel3<
-    alevel4<
-    dlib::max_pool<3, 3, 2, 2, dlib::relu<dlib::affine<dlib::con<32, 7, 7, 2, 2,
-    dlib::input_rgb_image_sized<150> >>>>>>>>>>>>;
-
 // Particle Filter Parameters
 const int num_particles = 100;
-std::vector<cv::Point2f> particles(num_particles);
-std::vector<float> particle_weights(num_particles, 1.0f / num_particles);
-
-// Particle Filter Functions
-void predict_particles(std::vector<cv::Point2f>& particles, float motion_noise) {
-    std::random_device rd;
-    std::default_random_engine gen(rd());
-    std::normal_distribution<float> dist(0.0f, motion_noise);
-
-    for (auto& particle : particles) {
-        particle.x += dist(gen);
-        particle.y += dist(gen);
-    }
-}
-
-void update_particles(const std::vector<cv::Point2f>& particles, std::vector<float>& weights,
-    const cv::Point2f& measurement, float measurement_noise) {
-    for (size_t i = 0; i < particles.size(); ++i) {
-        float distance = cv::norm(particles[i] - measurement);
-        weights[i] *= exp(-distance * distance / (2 * measurement_noise * measurement_noise));
-    }
-    float sum_weights = std::accumulate(weights.begin(), weights.end(), 0.0f);
-    for (auto& weight : weights) weight /= sum_weights; // Normalize weights
-}
-
-void resample_particles(std::vector<cv::Point2f>& particles, std::vector<float>& weights) {
-    std::vector<cv::Point2f> new_particles(particles.size());
-    std::random_device rd;
-    std::default_random_engine gen(rd());
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-
-    std::vector<float> cumulative_weights(weights.size());
-    std::partial_sum(weights.begin(), weights.end(), cumulative_weights.begin());
-
-    for (size_t i = 0; i < particles.size(); ++i) {
-        float r = dist(gen);
-        auto it = std::lower_bound(cumulative_weights.begin(), cumulative_weights.end(), r);
-        new_particles[i] = particles[it - cumulative_weights.begin()];
-    }
-    particles = new_particles;
-    std::fill(weights.begin(), weights.end(), 1.0f / particles.size());
-}
+const int max_tracks = 32;
+TrackManager<ParticleTrackPool> tracker(ParticleTrackPool(max_tracks, num_particles, 10.0f, 50.0f, 20.0f));
 
 
 // ResNet Definitions (as previously defined)
 // Main Function
 
-int main() {
-    // Initialize video capture
-    cv::VideoCapture cap(0);
-    if (!cap.isOpened()) {
-        std::cerr << "Error: Unable to open the camera.\n";
+int main(int argc, char** argv) {
+    auto program_start = std::chrono::steady_clock::now();
+
+    // Per-stage timings, enabled with PERCEPTION_TRACE
+    trace::Session tracing("face_particle_tracking");
+
+    // Load dlib models in the background while the camera starts up
+    FaceModelLoader model_loader("shape_predictor_68_face_landmarks.dat",
+        "dlib_face_recognition_resnet_model_v1.dat", "face_models.cache");
+
+    // Initialize video capture: camera index, video file or image directory
+    std::string source_path = argc > 1 ? argv[1] : "0";
+    // The decode thread converts to grayscale once for the detector and landmarks
+    FrameSource source;
+    PyramidConfig gray_only;
+    gray_only.levels = 1;
+    source.setPyramid(gray_only);
+    if (!source.open(source_path)) {
+        std::cerr << "Error: Unable to open " << source_path << "\n";
         return -1;
     }
+    LatencyMeter latency("face_particle_tracking");
+
+    // Show the camera feed while the models finish loading
+    while (!model_loader.ready()) {
+        Frame captured;
+        if (!source.read(captured)) break;
+        cv::Mat& frame = captured.image;
+        cv::putText(frame, "Loading models...", cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 2);
+        cv::imshow("Particle Filter Face Tracking", frame);
+        if (cv::waitKey(1) == 'q') return 0;
+    }
 
-    // Initialize dlib models
-    frontal_face_detector face_detector = get_frontal_face_detector();
-    shape_predictor shape_predictor;
-    deserialize("shape_predictor_68_face_landmarks.dat") >> shape_predictor;
-
-    anet_type face_recognizer;
-    deserialize("dlib_face_recognition_resnet_model_v1.dat") >> face_recognizer;
-
-    // Initialize particles
-    for (auto& particle : particles) {
-        particle.x = std::rand() % 640;
-        particle.y = std::rand() % 480;
+    std::shared_ptr<FaceModels> models;
+    try {
+        models = model_loader.get();
     }
+    catch (const std::exception& e) {
+        std::cerr << "Error: Unable to load the face models: " << e.what() << "\n";
+        return -1;
+    }
+    frontal_face_detector& face_detector = models->face_detector;
+    shape_predictor& shape_predictor = models->shape_predictor;
+    FaceEncoder face_recognizer(*models);
 
     // Main loop
-    while (cap.isOpened()) {
-        cv::Mat frame;
-        cap >> frame;
-        if (frame.empty()) break;
+    bool first_frame_reported = false;
+    while (true) {
+        Frame captured;
+        if (!source.read(captured)) break;
+        cv::Mat& frame = captured.image;
+        TRACE_SCOPE("frame");
 
         // Convert frame to dlib format
         cv_image<bgr_pixel> dlib_frame(frame);
+        cv::Mat gray = asMat(captured.pyramid->gray());
+        cv_image<unsigned char> dlib_gray(gray);
 
         // Detect faces
-        std::vector<rectangle> faces = face_detector(dlib_frame);
-        if (!faces.empty()) {
-            for (const auto& face : faces) {
-                // Get face landmarks
-                full_object_detection shape = shape_predictor(dlib_frame, face);
-
-                // Align face and create a face chip
-                matrix<rgb_pixel> face_chip;
-                extract_image_chip(dlib_frame, get_face_chip_details(shape, 150, 0.25), face_chip);
-                // Get face encoding
-                matrix<float, 0, 1> current_face_encoding = face_recognizer(face_chip);
-
-                // Known encoding comparison (placeholder)
-                float match_distance = dlib::length(current_face_encoding);
-
-                // Display descriptor size
-                cout << "Face descriptor size: " << current_face_encoding.size() << "Match distance: "<< match_distance << endl;
-
-                if (match_distance < 1.5) {
-                    // Face matches: Update particle filter
-                    cv::Point2f face_center(face.left() + face.width() / 2.0f, face.top() + face.height() / 2.0f);
-                    predict_particles(particles, 10.0f);
-                    update_particles(particles, particle_weights, face_center, 50.0f);
-                    resample_particles(particles, particle_weights);
-
-                    // Estimate position
-                    cv::Point2f estimated_position(0, 0);
-                    for (size_t i = 0; i < particles.size(); ++i) {
-                        estimated_position += particles[i] * particle_weights[i];
-                    }
-
-                    // Draw particles
-                    for (const auto& particle : particles) {
-                        cv::circle(frame, particle, 1, cv::Scalar(0, 255, 0), -1);
-                    }
-
-                    // Display estimated position
-                    cv::circle(frame, estimated_position, 5, cv::Scalar(0, 255, 255), -1);
-                }
-
-                // Draw face bounding box
-                cv::rectangle(frame, cv::Rect(face.left(), face.top(), face.width(), face.height()),
-                    cv::Scalar(255, 0, 0), 2);
+        std::vector<rectangle> faces;
+        {
+            TRACE_SCOPE("face_detector");
+            faces = face_detector(dlib_gray);
+        }
+        TRACE_COUNTER("faces", faces.size());
+        if (!first_frame_reported) {
+            double ttff_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - program_start).count();
+            std::cout << "Time to first frame: " << ttff_ms << " ms, RSS: " << residentSetBytes() / 1048576.0 << " MB"
+                << (models->from_cache ? " (model cache)" : "") << std::endl;
+            first_frame_reported = true;
+        }
+        std::vector<Detection> detections;
+        for (const auto& face : faces) {
+            // Get face landmarks
+            full_object_detection shape;
+            {
+                TRACE_SCOPE("shape_predictor");
+                shape = shape_predictor(dlib_gray, face);
+            }
+
+            // Align face and create a face chip
+            matrix<rgb_pixel> face_chip;
+            extract_image_chip(dlib_frame, get_face_chip_details(shape, 150, 0.25), face_chip);
+            // Get face encoding
+            matrix<float, 0, 1> current_face_encoding;
+            {
+                TRACE_SCOPE("resnet");
+                current_face_encoding = face_recognizer(face_chip);
             }
+
+            // Known encoding comparison (placeholder)
+            float match_distance = dlib::length(current_face_encoding);
+
+            // Display descriptor size
+            cout << "Face descriptor size: " << current_face_encoding.size() << "Match distance: "<< match_distance << endl;
+
+            if (match_distance < 1.5) {
+                // Face matches: becomes a measurement for the tracker
+                detections.push_back({ face.left() + face.width() / 2.0f, face.top() + face.height() / 2.0f });
+            }
+
+            // Draw face bounding box
+            cv::rectangle(frame, cv::Rect(face.left(), face.top(), face.width(), face.height()),
+                cv::Scalar(255, 0, 0), 2);
+        }
+
+        // Predict all tracks, associate matched faces and update their particle filters
+        {
+            TRACE_SCOPE("tracker.step");
+            tracker.step(detections);
+        }
+
+        TRACE_SCOPE("display");
+        for (int slot : tracker.liveTracks()) {
+            // Draw particles
+            const ParticleFilter& particle_filter = tracker.pool().filter(slot);
+            const float* particle_x = particle_filter.x();
+            const float* particle_y = particle_filter.y();
+            for (size_t i = 0; i < particle_filter.size(); ++i) {
+                cv::circle(frame, cv::Point2f(particle_x[i], particle_y[i]), 1, cv::Scalar(0, 255, 0), -1);
+            }
+
+            // Display estimated position
+            cv::Point2f estimated_position(0, 0);
+            particle_filter.estimate(estimated_position.x, estimated_position.y);
+            cv::circle(frame, estimated_position, 5, cv::Scalar(0, 255, 255), -1);
+            cv::putText(frame, "#" + std::to_string(tracker.id(slot)), estimated_position + cv::Point2f(8, 0),
+                cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 255, 255), 1);
         }
 
         // Display the frame
         cv::imshow("Particle Filter Face Tracking", frame);
+        latency.addSince(captured.capture_time);
         if (cv::waitKey(1) == 'q') break;
     }
 
-    cap.release();
+    std::cout << "Dropped frames: " << source.droppedFrames() << "\n";
+    source.close();
     cv::destroyAllWindows();
     return 0;
 }
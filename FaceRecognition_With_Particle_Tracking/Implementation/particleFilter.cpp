@@ -0,0 +1,266 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// particleFilter.cpp : Structure-of-arrays particle filter engine.
+//
+#include "particleFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const float kTwoPi = 6.28318530717958647692f;
+const float kHalfPi = 1.57079632679489661923f;
+
+uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+inline uint32_t rotl(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// LaneRng
+// ---------------------------------------------------------------------------
+
+LaneRng::LaneRng(uint64_t seed) {
+    for (size_t l = 0; l < kLanes; ++l) {
+        uint64_t a = splitmix64(seed);
+        uint64_t b = splitmix64(seed);
+        s0_[l] = static_cast<uint32_t>(a);
+        s1_[l] = static_cast<uint32_t>(a >> 32);
+        s2_[l] = static_cast<uint32_t>(b);
+        s3_[l] = static_cast<uint32_t>(b >> 32) | 1u; // State must not be all zero
+    }
+}
+
+void LaneRng::nextBlock(float* out) {
+    for (size_t l = 0; l < kLanes; ++l) {
+        uint32_t result = s0_[l] + s3_[l];
+        uint32_t t = s1_[l] << 9;
+        s2_[l] ^= s0_[l];
+        s3_[l] ^= s1_[l];
+        s1_[l] ^= s2_[l];
+        s0_[l] ^= s3_[l];
+        s2_[l] ^= t;
+        s3_[l] = rotl(s3_[l], 11);
+        // Top 24 bits give an exactly representable float in [0, 1)
+        out[l] = static_cast<float>(result >> 8) * (1.0f / 16777216.0f);
+    }
+}
+
+void LaneRng::uniform(float* out, size_t n) {
+    size_t i = 0;
+    for (; i + kLanes <= n; i += kLanes) {
+        nextBlock(out + i);
+    }
+    if (i < n) {
+        float tail[kLanes];
+        nextBlock(tail);
+        std::copy(tail, tail + (n - i), out + i);
+    }
+}
+
+float LaneRng::next() {
+    float block[kLanes];
+    nextBlock(block);
+    return block[0];
+}
+
+void LaneRng::normal(float* out, size_t n, float sigma) {
+    const size_t pairs = (n + 1) / 2;
+    scratch_.resize(2 * pairs);
+    uniform(scratch_.data(), 2 * pairs);
+
+    // Box-Muller, split into separate passes: a fused sin/cos loop is turned into
+    // sincos() by the compiler, which has no vector variant and stays scalar.
+    float* radius = scratch_.data();
+    const float* angle = scratch_.data() + pairs;
+    for (size_t i = 0; i < pairs; ++i) {
+        radius[i] = sigma * std::sqrt(-2.0f * std::log(1.0f - radius[i]));
+    }
+
+    const size_t half = n / 2;
+    for (size_t i = 0; i < half; ++i) {
+        out[i] = radius[i] * std::cos(kTwoPi * angle[i]);
+    }
+    float* second = out + half;
+    for (size_t i = 0; i < half; ++i) {
+        second[i] = radius[i] * std::cos(kTwoPi * angle[i] - kHalfPi);
+    }
+    if (n & 1) {
+        out[n - 1] = radius[half] * std::cos(kTwoPi * angle[half]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ParticleFilter
+// ---------------------------------------------------------------------------
+
+ParticleFilter::ParticleFilter(size_t num_particles, uint64_t seed)
+    : x_(num_particles), y_(num_particles), log_w_(num_particles), w_(num_particles),
+      x_tmp_(num_particles), y_tmp_(num_particles), noise_(num_particles), rng_(seed),
+      ess_(static_cast<float>(num_particles)) {
+    resetWeights();
+}
+
+void ParticleFilter::resetWeights() {
+    const size_t n = size();
+    if (n == 0) return;
+    std::fill(log_w_.begin(), log_w_.end(), -std::log(static_cast<float>(n)));
+    std::fill(w_.begin(), w_.end(), 1.0f / n);
+    ess_ = static_cast<float>(n);
+}
+
+void ParticleFilter::initializeUniform(float width, float height) {
+    const size_t n = size();
+    rng_.uniform(x_.data(), n);
+    rng_.uniform(y_.data(), n);
+    float* x = x_.data();
+    float* y = y_.data();
+    for (size_t i = 0; i < n; ++i) {
+        x[i] *= width;
+        y[i] *= height;
+    }
+    resetWeights();
+}
+
+void ParticleFilter::initializeAround(float cx, float cy, float spread) {
+    const size_t n = size();
+    rng_.normal(x_.data(), n, spread);
+    rng_.normal(y_.data(), n, spread);
+    float* x = x_.data();
+    float* y = y_.data();
+    for (size_t i = 0; i < n; ++i) {
+        x[i] += cx;
+        y[i] += cy;
+    }
+    resetWeights();
+}
+
+void ParticleFilter::predict(float motion_noise) {
+    const size_t n = size();
+    float* noise = noise_.data();
+
+    rng_.normal(noise, n, motion_noise);
+    float* x = x_.data();
+    for (size_t i = 0; i < n; ++i) x[i] += noise[i];
+
+    rng_.normal(noise, n, motion_noise);
+    float* y = y_.data();
+    for (size_t i = 0; i < n; ++i) y[i] += noise[i];
+}
+
+void ParticleFilter::update(float mx, float my, float measurement_noise) {
+    const size_t n = size();
+    if (n == 0) return;
+    // A zero noise would make the likelihood infinite, which -ffast-math does not allow
+    if (!(measurement_noise > 0.0f)) return;
+
+    const float inv_two_var = 1.0f / (2.0f * measurement_noise * measurement_noise);
+    const float* x = x_.data();
+    const float* y = y_.data();
+    float* log_w = log_w_.data();
+    float* w = w_.data();
+
+    // Accumulate the log likelihood and track the maximum for a stable exp()
+    float max_log_w = std::numeric_limits<float>::lowest(); // Not -INFINITY: built with -ffast-math
+    for (size_t i = 0; i < n; ++i) {
+        float dx = x[i] - mx;
+        float dy = y[i] - my;
+        log_w[i] -= (dx * dx + dy * dy) * inv_two_var;
+        max_log_w = std::max(max_log_w, log_w[i]);
+    }
+
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        w[i] = std::exp(log_w[i] - max_log_w);
+        sum += w[i];
+    }
+
+    // Normalize both representations and compute ESS = 1 / sum(w^2)
+    const float inv_sum = 1.0f / sum;
+    const float log_norm = max_log_w + std::log(sum);
+    float sum_sq = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        w[i] *= inv_sum;
+        log_w[i] -= log_norm;
+        sum_sq += w[i] * w[i];
+    }
+    ess_ = 1.0f / sum_sq;
+}
+
+bool ParticleFilter::resampleIfNeeded(float ess_fraction) {
+    if (ess_ >= ess_fraction * size()) {
+        return false;
+    }
+    resample();
+    return true;
+}
+
+void ParticleFilter::resample() {
+    const size_t n = size();
+    if (n == 0) return;
+
+    const double step = 1.0 / n;
+    const double offset = rng_.next() * step;
+    const float* w = w_.data();
+
+    // Walk the cumulative distribution once with N evenly spaced pointers
+    double cumulative = w[0];
+    size_t j = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const double target = offset + i * step;
+        while (target > cumulative && j + 1 < n) {
+            cumulative += w[++j];
+        }
+        x_tmp_[i] = x_[j];
+        y_tmp_[i] = y_[j];
+    }
+
+    x_.swap(x_tmp_);
+    y_.swap(y_tmp_);
+    resetWeights();
+}
+
+void ParticleFilter::estimate(float& ex, float& ey) const {
+    const size_t n = size();
+    const float* x = x_.data();
+    const float* y = y_.data();
+    const float* w = w_.data();
+    float sx = 0.0f, sy = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        sx += w[i] * x[i];
+        sy += w[i] * y[i];
+    }
+    ex = sx;
+    ey = sy;
+}
+
+void ParticleFilter::covariance(float& sxx, float& sxy, float& syy) const {
+    float mx, my;
+    estimate(mx, my);
+    const size_t n = size();
+    const float* x = x_.data();
+    const float* y = y_.data();
+    const float* w = w_.data();
+    float cxx = 0.0f, cxy = 0.0f, cyy = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        float dx = x[i] - mx;
+        float dy = y[i] - my;
+        cxx += w[i] * dx * dx;
+        cxy += w[i] * dx * dy;
+        cyy += w[i] * dy * dy;
+    }
+    sxx = cxx;
+    sxy = cxy;
+    syy = cyy;
+}
@@ -0,0 +1,83 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// particleFilter.h : Structure-of-arrays particle filter engine used by faceParticleTracking.cpp.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Multi-lane xoshiro128+ generator. Each lane owns an independent state so the
+// generation loops below have no cross-iteration dependency and vectorize.
+class LaneRng {
+public:
+    static constexpr size_t kLanes = 8;
+
+    explicit LaneRng(uint64_t seed);
+
+    // Fill out[0..n) with uniform samples in [0, 1)
+    void uniform(float* out, size_t n);
+
+    // Fill out[0..n) with N(0, sigma^2) samples using the Box-Muller transform
+    void normal(float* out, size_t n, float sigma);
+
+    // Single uniform sample in [0, 1)
+    float next();
+
+private:
+    void nextBlock(float* out);
+
+    uint32_t s0_[kLanes], s1_[kLanes], s2_[kLanes], s3_[kLanes];
+    std::vector<float> scratch_;
+};
+
+// 2D position particle filter. Particles are stored as separate x / y arrays,
+// weights are kept in the log domain and resampling is systematic (O(N)).
+class ParticleFilter {
+public:
+    explicit ParticleFilter(size_t num_particles, uint64_t seed = 0x9E3779B97F4A7C15ull);
+
+    // Spread particles uniformly over [0, width) x [0, height)
+    void initializeUniform(float width, float height);
+
+    // Spread particles around (x, y) with the given standard deviation
+    void initializeAround(float x, float y, float spread);
+
+    // Random walk motion model
+    void predict(float motion_noise);
+
+    // Gaussian measurement likelihood around (mx, my); weights are renormalized. A
+    // measurement_noise that is not positive is rejected and leaves the weights unchanged.
+    void update(float mx, float my, float measurement_noise);
+
+    // Resample only when the effective sample size drops below ess_fraction * N.
+    // Returns true when resampling took place.
+    bool resampleIfNeeded(float ess_fraction = 0.5f);
+
+    // Systematic resampling with a single random offset
+    void resample();
+
+    // Weighted mean of the particle positions
+    void estimate(float& x, float& y) const;
+
+    // Weighted covariance of the particle positions around the weighted mean
+    void covariance(float& sxx, float& sxy, float& syy) const;
+
+    float effectiveSampleSize() const { return ess_; }
+    size_t size() const { return x_.size(); }
+    const float* x() const { return x_.data(); }
+    const float* y() const { return y_.data(); }
+    const float* weights() const { return w_.data(); }
+
+private:
+    void resetWeights();
+
+    std::vector<float> x_, y_;
+    std::vector<float> log_w_;  // Log weights, normalized so that sum(exp(log_w_)) == 1
+    std::vector<float> w_;      // Linear normalized weights, refreshed by update()
+    std::vector<float> x_tmp_, y_tmp_, noise_;
+    LaneRng rng_;
+    float ess_;
+};
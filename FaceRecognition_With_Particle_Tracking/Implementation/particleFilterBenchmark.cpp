@@ -0,0 +1,117 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// particleFilterBenchmark.cpp : Compares the SoA particle filter engine with the original
+// vector<cv::Point2f> implementation of faceParticleTracking.cpp.
+//
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "particleFilter.h"
+
+// Original particle filter functions, kept verbatim as the baseline
+namespace legacy {
+
+void predict_particles(std::vector<cv::Point2f>& particles, float motion_noise) {
+    std::random_device rd;
+    std::default_random_engine gen(rd());
+    std::normal_distribution<float> dist(0.0f, motion_noise);
+
+    for (auto& particle : particles) {
+        particle.x += dist(gen);
+        particle.y += dist(gen);
+    }
+}
+
+void update_particles(const std::vector<cv::Point2f>& particles, std::vector<float>& weights,
+    const cv::Point2f& measurement, float measurement_noise) {
+    for (size_t i = 0; i < particles.size(); ++i) {
+        float distance = cv::norm(particles[i] - measurement);
+        weights[i] *= exp(-distance * distance / (2 * measurement_noise * measurement_noise));
+    }
+    float sum_weights = std::accumulate(weights.begin(), weights.end(), 0.0f);
+    for (auto& weight : weights) weight /= sum_weights; // Normalize weights
+}
+
+void resample_particles(std::vector<cv::Point2f>& particles, std::vector<float>& weights) {
+    std::vector<cv::Point2f> new_particles(particles.size());
+    std::random_device rd;
+    std::default_random_engine gen(rd());
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    std::vector<float> cumulative_weights(weights.size());
+    std::partial_sum(weights.begin(), weights.end(), cumulative_weights.begin());
+
+    for (size_t i = 0; i < particles.size(); ++i) {
+        float r = dist(gen);
+        auto it = std::lower_bound(cumulative_weights.begin(), cumulative_weights.end(), r);
+        new_particles[i] = particles[it - cumulative_weights.begin()];
+    }
+    particles = new_particles;
+    std::fill(weights.begin(), weights.end(), 1.0f / particles.size());
+}
+
+} // namespace legacy
+
+// Synthetic face trajectory: a slow circle inside a 640x480 frame
+static cv::Point2f measurementAt(int frame) {
+    float a = frame * 0.05f;
+    return cv::Point2f(320.0f + 100.0f * std::cos(a), 240.0f + 80.0f * std::sin(a));
+}
+
+static double benchmarkLegacy(size_t num_particles, int frames) {
+    std::vector<cv::Point2f> particles(num_particles);
+    std::vector<float> weights(num_particles, 1.0f / num_particles);
+    for (auto& particle : particles) {
+        particle.x = std::rand() % 640;
+        particle.y = std::rand() % 480;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        legacy::predict_particles(particles, 10.0f);
+        legacy::update_particles(particles, weights, measurementAt(f), 50.0f);
+        legacy::resample_particles(particles, weights);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / frames;
+}
+
+static double benchmarkEngine(size_t num_particles, int frames, int& resamples) {
+    ParticleFilter filter(num_particles);
+    filter.initializeUniform(640.0f, 480.0f);
+    resamples = 0;
+
+    float ex = 0.0f, ey = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        cv::Point2f z = measurementAt(f);
+        filter.predict(10.0f);
+        filter.update(z.x, z.y, 50.0f);
+        resamples += filter.resampleIfNeeded() ? 1 : 0;
+        filter.estimate(ex, ey);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / frames;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::atoi(argv[1]) : 100;
+    const size_t sizes[] = { 100, 1000, 10000, 100000 };
+
+    std::printf("%10s %14s %14s %10s %10s\n", "particles", "legacy ms/frm", "engine ms/frm", "speedup", "resamples");
+    for (size_t n : sizes) {
+        int resamples = 0;
+        double legacy_ms = benchmarkLegacy(n, frames);
+        double engine_ms = benchmarkEngine(n, frames, resamples);
+        std::printf("%10zu %14.4f %14.4f %9.1fx %10d\n", n, legacy_ms, engine_ms, legacy_ms / engine_ms, resamples);
+    }
+    return 0;
+}
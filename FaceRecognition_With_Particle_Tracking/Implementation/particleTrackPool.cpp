@@ -0,0 +1,44 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// particleTrackPool.cpp : Pool of particle filters, one per track, for TrackManager.
+//
+#include "particleTrackPool.h"
+
+ParticleTrackPool::ParticleTrackPool(size_t capacity, size_t particles_per_track, float motion_noise,
+    float measurement_noise, float initial_spread)
+    : motion_noise_(motion_noise), measurement_noise_(measurement_noise), initial_spread_(initial_spread) {
+    filters_.reserve(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        // Distinct seeds keep the per-track random streams independent
+        filters_.emplace_back(particles_per_track, 0x9E3779B97F4A7C15ull + i);
+    }
+}
+
+void ParticleTrackPool::initialize(int slot, float x, float y) {
+    filters_[slot].initializeAround(x, y, initial_spread_);
+}
+
+void ParticleTrackPool::predict(const std::vector<int>& slots) {
+    for (int slot : slots) {
+        filters_[slot].predict(motion_noise_);
+    }
+}
+
+void ParticleTrackPool::innovation(int slot, float& zx, float& zy, float& sxx, float& sxy, float& syy) const {
+    // Gaussian approximation of the particle cloud plus measurement noise
+    const float r = measurement_noise_ * measurement_noise_;
+    filters_[slot].estimate(zx, zy);
+    filters_[slot].covariance(sxx, sxy, syy);
+    sxx += r;
+    syy += r;
+}
+
+void ParticleTrackPool::update(int slot, float zx, float zy) {
+    filters_[slot].update(zx, zy, measurement_noise_);
+    filters_[slot].resampleIfNeeded();
+}
+
+void ParticleTrackPool::position(int slot, float& x, float& y) const {
+    filters_[slot].estimate(x, y);
+}
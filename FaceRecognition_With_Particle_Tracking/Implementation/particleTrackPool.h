@@ -0,0 +1,31 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// particleTrackPool.h : Pool of particle filters, one per track, for TrackManager.
+//
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "particleFilter.h"
+
+// All filters are allocated up front with the same particle count and reused as
+// tracks are created and retired, so no allocation happens in the tracking loop.
+class ParticleTrackPool {
+public:
+    ParticleTrackPool(size_t capacity, size_t particles_per_track, float motion_noise,
+        float measurement_noise, float initial_spread);
+
+    size_t capacity() const { return filters_.size(); }
+    void initialize(int slot, float x, float y);
+    void predict(const std::vector<int>& slots);
+    void innovation(int slot, float& zx, float& zy, float& sxx, float& sxy, float& syy) const;
+    void update(int slot, float zx, float zy);
+    void position(int slot, float& x, float& y) const;
+    const ParticleFilter& filter(int slot) const { return filters_[slot]; }
+
+private:
+    std::vector<ParticleFilter> filters_;
+    float motion_noise_, measurement_noise_, initial_spread_;
+};
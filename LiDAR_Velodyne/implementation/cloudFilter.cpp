@@ -0,0 +1,227 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// cloudFilter.cpp : Parallel ground removal and hashed voxel-grid downsampling of LiDAR scans.
+//
+#include "cloudFilter.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const uint64_t kEmptyKey = ~0ull;
+const int kKeyBits = 21;
+const int kKeyBias = 1 << (kKeyBits - 1);
+const int kPartitionBits = 6;
+const int kPartitions = 1 << kPartitionBits;
+const double kPi = 3.14159265358979323846;
+
+inline uint64_t voxelCoordinate(float v, float inverse_size) {
+    int i = static_cast<int>(std::floor(v * inverse_size)) + kKeyBias;
+    i = std::min(std::max(i, 0), (1 << kKeyBits) - 1);
+    return static_cast<uint64_t>(i);
+}
+
+// Full avalanche: the partition comes from the high bits, the table slot from the low bits
+inline uint64_t mixKey(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    return key ^ (key >> 33);
+}
+
+// Contiguous range of n items handled by task t of tasks
+inline void taskRange(size_t n, int tasks, int t, size_t& begin, size_t& end) {
+    begin = n * t / tasks;
+    end = n * (t + 1) / tasks;
+}
+
+} // namespace
+
+CloudFilter::CloudFilter(CloudFilterConfig config, WorkStealingPool* pool)
+    : config_(config),
+      own_pool_(pool ? nullptr : new WorkStealingPool(config.threads)),
+      pool_(pool ? *pool : *own_pool_) {
+    config_.azimuth_bins = std::max(config_.azimuth_bins, 1);
+    tables_.resize(pool_.threads());
+    used_slots_.resize(pool_.threads());
+    partition_voxels_.resize(kPartitions);
+}
+
+void CloudFilter::process(const LidarScan& scan, int rings, std::vector<LidarPoint>& obstacles, std::vector<LidarPoint>& ground) {
+    TRACE_SCOPE("cloudFilter.process");
+    removeGround(scan.points, rings, obstacles_, ground);
+    downsample(obstacles_, obstacles);
+}
+
+void CloudFilter::removeGround(const std::vector<LidarPoint>& points, int rings, std::vector<LidarPoint>& obstacles,
+    std::vector<LidarPoint>& ground) {
+    TRACE_SCOPE("cloudFilter.ground");
+    const int bins = config_.azimuth_bins;
+    const size_t n = points.size();
+    image_.assign(size_t(rings) * bins, -1);
+    labels_.resize(n);
+
+    // Range image, one representative return per cell
+    auto cellOf = [&](const LidarPoint& p) {
+        return size_t(p.ring) * bins + size_t(p.azimuth) * bins / 36000;
+    };
+    for (size_t i = 0; i < n; ++i) {
+        if (points[i].ring < rings) image_[cellOf(points[i])] = static_cast<int32_t>(i);
+    }
+
+    // Walk each column upwards; cell labels are stored in labels_ of the representative
+    const float tan_slope = static_cast<float>(std::tan(config_.max_ground_slope_deg * kPi / 180.0));
+    const float ground_z = -config_.sensor_height_m;
+    const int tasks = pool_.threads() * 4;
+    pool_.parallelFor(tasks, [&](int task, int) {
+        size_t begin, end;
+        taskRange(size_t(bins), tasks, task, begin, end);
+        for (size_t column = begin; column < end; ++column) {
+            bool have_ground = false;
+            float gx = 0.0f, gy = 0.0f, gz = 0.0f;
+            for (int ring = 0; ring < rings; ++ring) {
+                const int32_t index = image_[size_t(ring) * bins + column];
+                if (index < 0) continue;
+                const LidarPoint& p = points[index];
+                bool is_ground = std::fabs(p.z - ground_z) < config_.ground_tolerance_m;
+                if (have_ground) {
+                    const float dxy = std::sqrt((p.x - gx) * (p.x - gx) + (p.y - gy) * (p.y - gy));
+                    is_ground = is_ground || std::fabs(p.z - gz) <= tan_slope * dxy;
+                }
+                labels_[index] = is_ground ? 1 : 0;
+                if (is_ground) {
+                    have_ground = true;
+                    gx = p.x;
+                    gy = p.y;
+                    gz = p.z;
+                }
+            }
+        }
+    });
+
+    // Points that share a cell take the label of its representative
+    pool_.parallelFor(tasks, [&](int task, int) {
+        size_t begin, end;
+        taskRange(n, tasks, task, begin, end);
+        for (size_t i = begin; i < end; ++i) {
+            if (points[i].ring >= rings) {
+                labels_[i] = 0;
+                continue;
+            }
+            const int32_t representative = image_[cellOf(points[i])];
+            if (representative != static_cast<int32_t>(i)) labels_[i] = labels_[representative];
+        }
+    });
+
+    obstacles.clear();
+    ground.clear();
+    for (size_t i = 0; i < n; ++i) {
+        (labels_[i] ? ground : obstacles).push_back(points[i]);
+    }
+}
+
+void CloudFilter::downsample(const std::vector<LidarPoint>& points, std::vector<LidarPoint>& voxels) {
+    TRACE_SCOPE("cloudFilter.voxel");
+    const size_t n = points.size();
+    const float inverse_size = 1.0f / config_.voxel_size_m;
+    const int slices = pool_.threads() * 4;
+    keys_.resize(n);
+    scattered_.resize(n);
+    histogram_.assign(size_t(slices) * kPartitions, 0);
+
+    // 1. Voxel key of every point and per-slice partition histogram
+    pool_.parallelFor(slices, [&](int slice, int) {
+        size_t begin, end;
+        taskRange(n, slices, slice, begin, end);
+        uint32_t* counts = &histogram_[size_t(slice) * kPartitions];
+        for (size_t i = begin; i < end; ++i) {
+            const LidarPoint& p = points[i];
+            const uint64_t key = (voxelCoordinate(p.x, inverse_size) << (2 * kKeyBits)) |
+                (voxelCoordinate(p.y, inverse_size) << kKeyBits) | voxelCoordinate(p.z, inverse_size);
+            keys_[i] = key;
+            counts[mixKey(key) >> (64 - kPartitionBits)]++;
+        }
+    });
+
+    // 2. Prefix sums: partition-major, slices in order, so the scatter is stable
+    partition_start_.assign(kPartitions + 1, 0);
+    uint32_t total = 0;
+    for (int partition = 0; partition < kPartitions; ++partition) {
+        partition_start_[partition] = total;
+        for (int slice = 0; slice < slices; ++slice) {
+            uint32_t& count = histogram_[size_t(slice) * kPartitions + partition];
+            const uint32_t c = count;
+            count = total;
+            total += c;
+        }
+    }
+    partition_start_[kPartitions] = total;
+
+    // 3. Scatter keyed points into their partitions, so the reduction reads sequentially
+    pool_.parallelFor(slices, [&](int slice, int) {
+        size_t begin, end;
+        taskRange(n, slices, slice, begin, end);
+        uint32_t* cursor = &histogram_[size_t(slice) * kPartitions];
+        for (size_t i = begin; i < end; ++i) {
+            const LidarPoint& p = points[i];
+            const uint64_t key = keys_[i];
+            scattered_[cursor[mixKey(key) >> (64 - kPartitionBits)]++] = { key, p.x, p.y, p.z, float(p.intensity), 1 };
+        }
+    });
+
+    // 4. Reduce each partition in its own open-addressing table
+    pool_.parallelFor(kPartitions, [&](int partition, int worker) {
+        const uint32_t begin = partition_start_[partition], end = partition_start_[partition + 1];
+        std::vector<LidarPoint>& out = partition_voxels_[partition];
+        out.clear();
+        if (begin == end) return;
+
+        size_t capacity = 16;
+        while (capacity < 2 * size_t(end - begin)) capacity *= 2;
+        std::vector<VoxelSum>& table = tables_[worker];
+        std::vector<uint32_t>& used = used_slots_[worker];
+        if (table.size() < capacity) table.assign(capacity, VoxelSum{ kEmptyKey, 0.0f, 0.0f, 0.0f, 0.0f, 0 });
+        const size_t mask = capacity - 1;
+
+        used.clear();
+        for (uint32_t k = begin; k < end; ++k) {
+            const VoxelSum& p = scattered_[k];
+            size_t slot = mixKey(p.key) & mask;
+            while (table[slot].key != kEmptyKey && table[slot].key != p.key) slot = (slot + 1) & mask;
+            VoxelSum& voxel = table[slot];
+            if (voxel.key == kEmptyKey) {
+                voxel = p;
+                used.push_back(static_cast<uint32_t>(slot));
+            }
+            else {
+                voxel.x += p.x;
+                voxel.y += p.y;
+                voxel.z += p.z;
+                voxel.intensity += p.intensity;
+                voxel.count++;
+            }
+        }
+
+        // Emit centroids and leave the table empty for the next partition
+        out.resize(used.size());
+        for (size_t i = 0; i < used.size(); ++i) {
+            VoxelSum& voxel = table[used[i]];
+            const float inverse_count = 1.0f / voxel.count;
+            LidarPoint& centroid = out[i];
+            centroid.x = voxel.x * inverse_count;
+            centroid.y = voxel.y * inverse_count;
+            centroid.z = voxel.z * inverse_count;
+            centroid.intensity = static_cast<uint8_t>(voxel.intensity * inverse_count + 0.5f);
+            centroid.ring = 0;
+            centroid.azimuth = 0;
+            voxel.key = kEmptyKey;
+        }
+    });
+
+    voxels.clear();
+    for (const std::vector<LidarPoint>& part : partition_voxels_) voxels.insert(voxels.end(), part.begin(), part.end());
+}
@@ -0,0 +1,75 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// cloudFilter.h : Parallel ground removal and hashed voxel-grid downsampling of LiDAR scans.
+//
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "velodyneDecoder.h"
+#include "workStealingPool.h"
+
+struct CloudFilterConfig {
+    float voxel_size_m = 0.2f;
+    float sensor_height_m = 1.8f;     // Mounting height above the ground
+    float ground_tolerance_m = 0.3f;  // Lowest return counts as ground this close to -sensor_height
+    float max_ground_slope_deg = 10.0f;
+    int azimuth_bins = 1800;          // Columns of the range image used for ground removal
+    int threads = 0;                  // Own pool size when none is passed, 0 = hardware concurrency
+};
+
+// Per-scan filter, all buffers are reused between scans:
+//
+//   ground removal:  the scan is binned into a ring x azimuth range image. Each column is
+//                    walked upwards from the lowest ring; a return continues the ground
+//                    while the slope to the previous ground return stays under
+//                    max_ground_slope_deg. Columns are processed in parallel.
+//   voxel grid:      non-ground points are keyed by voxel, radix-partitioned by key hash
+//                    and each partition is reduced in its own open-addressing table, so
+//                    workers never share a voxel. Each voxel becomes its centroid.
+//
+// Both stages run as fork-join loops on a WorkStealingPool: the one passed in, shared with
+// the rest of the program, or a pool of config.threads of its own.
+class CloudFilter {
+public:
+    explicit CloudFilter(CloudFilterConfig config = CloudFilterConfig(), WorkStealingPool* pool = nullptr);
+
+    // rings: number of lasers of the sensor (VelodyneDecoder::rings())
+    void process(const LidarScan& scan, int rings, std::vector<LidarPoint>& obstacles, std::vector<LidarPoint>& ground);
+
+    // Stages on their own, for benchmarks
+    void removeGround(const std::vector<LidarPoint>& points, int rings, std::vector<LidarPoint>& obstacles,
+        std::vector<LidarPoint>& ground);
+    void downsample(const std::vector<LidarPoint>& points, std::vector<LidarPoint>& voxels);
+
+    const CloudFilterConfig& config() const { return config_; }
+    int threads() const { return pool_.threads(); }
+
+private:
+    struct VoxelSum {
+        uint64_t key;
+        float x, y, z, intensity;
+        uint32_t count;
+    };
+
+    CloudFilterConfig config_;
+    std::unique_ptr<WorkStealingPool> own_pool_;
+    WorkStealingPool& pool_;
+
+    // Ground removal
+    std::vector<int32_t> image_;   // rings x azimuth_bins, point index or -1
+    std::vector<uint8_t> labels_;  // Per point, 1 = ground
+    std::vector<LidarPoint> obstacles_;
+
+    // Voxel grid
+    std::vector<uint64_t> keys_;
+    std::vector<uint32_t> histogram_;  // slices x partitions
+    std::vector<VoxelSum> scattered_;  // Keyed points grouped by partition
+    std::vector<uint32_t> partition_start_;
+    std::vector<std::vector<VoxelSum>> tables_;  // One per worker, reused across partitions
+    std::vector<std::vector<uint32_t>> used_slots_;
+    std::vector<std::vector<LidarPoint>> partition_voxels_;
+};
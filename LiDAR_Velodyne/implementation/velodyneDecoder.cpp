@@ -0,0 +1,230 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// velodyneDecoder.cpp : Velodyne data packet decoding and assembly of full 360 degree scans.
+//
+// Data packet (1206 bytes): 12 blocks of 100 bytes, then a 4-byte timestamp, the return
+// mode and the product id. Each block holds a flag, the azimuth in hundredths of a degree
+// and 32 channels of (distance, intensity). The VLP-16 fires its 16 lasers twice per
+// block, the HDL-32E fires 32 lasers once, and the VLS-128 spreads one firing of 128
+// lasers over 4 blocks whose flags select the bank.
+//
+#include "velodyneDecoder.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+
+namespace {
+
+const int kBlocks = 12;
+const int kBlockBytes = 100;
+const int kChannels = 32;
+const int kFullCircle = 36000;
+const uint8_t kDualReturn = 0x39;
+const double kPi = 3.14159265358979323846;
+
+// Time between firings of the same laser, in microseconds
+double firingPeriodUs(VelodyneModel model) {
+    switch (model) {
+    case VelodyneModel::Vlp16: return 110.592; // Two firing sequences per block
+    case VelodyneModel::Hdl32: return 46.080;
+    default: return 53.3;
+    }
+}
+
+int blocksPerFiring(VelodyneModel model) {
+    return model == VelodyneModel::Vls128 ? 4 : 1;
+}
+
+inline uint16_t littleEndian16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+} // namespace
+
+bool parseVelodyneModel(const std::string& name, VelodyneModel& model) {
+    if (name == "vlp16") model = VelodyneModel::Vlp16;
+    else if (name == "hdl32") model = VelodyneModel::Hdl32;
+    else if (name == "vls128") model = VelodyneModel::Vls128;
+    else return false;
+    return true;
+}
+
+int velodyneLasers(VelodyneModel model) {
+    switch (model) {
+    case VelodyneModel::Vlp16: return 16;
+    case VelodyneModel::Hdl32: return 32;
+    default: return 128;
+    }
+}
+
+VelodyneCalibration defaultCalibration(VelodyneModel model) {
+    VelodyneCalibration calibration;
+    switch (model) {
+    case VelodyneModel::Vlp16:
+        calibration.elevation_deg = { -15, 1, -13, 3, -11, 5, -9, 7, -7, 9, -5, 11, -3, 13, -1, 15 };
+        break;
+    case VelodyneModel::Hdl32:
+        calibration.elevation_deg = { -30.67f, -9.33f, -29.33f, -8.00f, -28.00f, -6.67f, -26.67f, -5.33f,
+            -25.33f, -4.00f, -24.00f, -2.67f, -22.67f, -1.33f, -21.33f, 0.00f,
+            -20.00f, 1.33f, -18.67f, 2.67f, -17.33f, 4.00f, -16.00f, 5.33f,
+            -14.67f, 6.67f, -13.33f, 8.00f, -12.00f, 9.33f, -10.67f, 10.67f };
+        break;
+    case VelodyneModel::Vls128:
+        calibration.distance_resolution_m = 0.004f;
+        for (int i = 0; i < 128; ++i) calibration.elevation_deg.push_back(-25.0f + 40.0f * i / 127.0f);
+        break;
+    }
+    calibration.azimuth_offset_deg.assign(calibration.elevation_deg.size(), 0.0f);
+    return calibration;
+}
+
+bool loadCalibration(const std::string& path, VelodyneModel model, VelodyneCalibration& calibration) {
+    std::ifstream in(path);
+    if (!in) return false;
+    VelodyneCalibration loaded = defaultCalibration(model);
+    loaded.elevation_deg.clear();
+    loaded.azimuth_offset_deg.clear();
+    float elevation, azimuth_offset;
+    while (in >> elevation >> azimuth_offset) {
+        loaded.elevation_deg.push_back(elevation);
+        loaded.azimuth_offset_deg.push_back(azimuth_offset);
+    }
+    if (static_cast<int>(loaded.elevation_deg.size()) != velodyneLasers(model)) return false;
+    calibration = loaded;
+    return true;
+}
+
+VelodyneDecoder::VelodyneDecoder(VelodyneModel model, const VelodyneCalibration& calibration,
+    float min_range_m, float max_range_m)
+    : model_(model), resolution_(calibration.distance_resolution_m), min_range_(min_range_m), max_range_(max_range_m) {
+    const int lasers = static_cast<int>(calibration.elevation_deg.size());
+    cos_elevation_.resize(lasers);
+    sin_elevation_.resize(lasers);
+    azimuth_offset_.resize(lasers);
+    for (int i = 0; i < lasers; ++i) {
+        const double elevation = calibration.elevation_deg[i] * kPi / 180.0;
+        cos_elevation_[i] = static_cast<float>(std::cos(elevation));
+        sin_elevation_[i] = static_cast<float>(std::sin(elevation));
+        const float offset = i < static_cast<int>(calibration.azimuth_offset_deg.size()) ? calibration.azimuth_offset_deg[i] : 0.0f;
+        azimuth_offset_[i] = static_cast<int>(std::lround(offset * 100.0f));
+    }
+
+    // Ring = rank of the laser by elevation
+    std::vector<int> order(lasers);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+        [&](int a, int b) { return calibration.elevation_deg[a] < calibration.elevation_deg[b]; });
+    ring_.resize(lasers);
+    for (int rank = 0; rank < lasers; ++rank) ring_[order[rank]] = static_cast<uint8_t>(rank);
+
+    sin_azimuth_.resize(kFullCircle);
+    cos_azimuth_.resize(kFullCircle);
+    for (int a = 0; a < kFullCircle; ++a) {
+        const double angle = a * kPi / 18000.0;
+        sin_azimuth_[a] = static_cast<float>(std::sin(angle));
+        cos_azimuth_[a] = static_cast<float>(std::cos(angle));
+    }
+
+    // Firing time of each channel after the block azimuth was sampled. The VLS-128
+    // offsets within a firing are below 3 us and are ignored.
+    channel_time_us_.assign(kChannels, 0.0f);
+    for (int channel = 0; channel < kChannels; ++channel) {
+        if (model_ == VelodyneModel::Vlp16) {
+            channel_time_us_[channel] = (channel / 16) * 55.296f + (channel % 16) * 2.304f;
+        }
+        else if (model_ == VelodyneModel::Hdl32) {
+            channel_time_us_[channel] = channel * 1.152f;
+        }
+    }
+}
+
+bool VelodyneDecoder::add(const VelodynePacket& packet, LidarScan& completed) {
+    TRACE_SCOPE("velodyne.decode");
+    if (packet.size < kVelodynePacketBytes || packet.data[0] != 0xff) {
+        bad_packets_++;
+        return false;
+    }
+    const uint8_t* data = packet.data;
+    const bool dual = data[1204] == kDualReturn;
+    const int blocks_per_firing = blocksPerFiring(model_) * (dual ? 2 : 1);
+    const double period = firingPeriodUs(model_);
+
+    // Azimuth rate from the first and last block, for the per-channel interpolation
+    const int first_azimuth = littleEndian16(data + 2);
+    const int last_azimuth = littleEndian16(data + (kBlocks - 1) * kBlockBytes + 2);
+    const int firings = kBlocks / blocks_per_firing;
+    if (firings > 1) {
+        const int span = (last_azimuth - first_azimuth + kFullCircle) % kFullCircle;
+        azimuth_rate_ = static_cast<float>(span / ((firings - 1) * period));
+    }
+
+    bool finished = false;
+    const int lasers = static_cast<int>(ring_.size());
+    for (int block = 0; block < kBlocks; ++block) {
+        const uint8_t* b = data + block * kBlockBytes;
+        if (b[0] != 0xff) {
+            bad_packets_++;
+            break;
+        }
+        int bank = 0;
+        if (model_ == VelodyneModel::Vls128) {
+            switch (b[1]) {
+            case 0xee: bank = 0; break;
+            case 0xdd: bank = 1; break;
+            case 0xcc: bank = 2; break;
+            case 0xbb: bank = 3; break;
+            default: continue;
+            }
+        }
+        const int azimuth = littleEndian16(b + 2);
+        if (azimuth >= kFullCircle) continue;
+
+        // A full turn ends when the azimuth wraps
+        if (last_azimuth_ >= 0 && azimuth < last_azimuth_ && last_azimuth_ - azimuth > kFullCircle / 2 && !current_.points.empty()) {
+            finishScan(completed);
+            finished = true;
+        }
+        last_azimuth_ = azimuth;
+        if (current_.packets == 0) current_.start_us = packet.capture_us;
+
+        for (int channel = 0; channel < kChannels; ++channel) {
+            const uint8_t* c = b + 4 + channel * 3;
+            const uint16_t distance = littleEndian16(c);
+            if (distance == 0) continue;
+            const float range = distance * resolution_;
+            if (range < min_range_ || range > max_range_) continue;
+
+            int laser = channel;
+            if (model_ == VelodyneModel::Vlp16) laser = channel % 16;
+            else if (model_ == VelodyneModel::Vls128) laser = bank * kChannels + channel;
+            if (laser >= lasers) continue;
+
+            int point_azimuth = azimuth + static_cast<int>(azimuth_rate_ * channel_time_us_[channel]) + azimuth_offset_[laser];
+            point_azimuth = (point_azimuth % kFullCircle + kFullCircle) % kFullCircle;
+
+            const float horizontal = range * cos_elevation_[laser];
+            LidarPoint point;
+            point.x = horizontal * sin_azimuth_[point_azimuth];
+            point.y = horizontal * cos_azimuth_[point_azimuth];
+            point.z = range * sin_elevation_[laser];
+            point.intensity = c[2];
+            point.ring = ring_[laser];
+            point.azimuth = static_cast<uint16_t>(point_azimuth);
+            current_.points.push_back(point);
+        }
+    }
+    current_.packets++;
+    return finished;
+}
+
+void VelodyneDecoder::finishScan(LidarScan& completed) {
+    std::swap(current_, completed);
+    completed.index = scans_++;
+    current_.points.clear();
+    current_.packets = 0;
+    current_.start_us = 0;
+}
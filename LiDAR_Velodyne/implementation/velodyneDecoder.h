@@ -0,0 +1,81 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// velodyneDecoder.h : Velodyne data packet decoding and assembly of full 360 degree scans.
+//
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "velodynePcap.h"
+
+enum class VelodyneModel { Vlp16, Hdl32, Vls128 };
+
+// "vlp16", "hdl32" or "vls128"; returns false for anything else
+bool parseVelodyneModel(const std::string& name, VelodyneModel& model);
+int velodyneLasers(VelodyneModel model);
+
+// 16 bytes, so a 128-beam scan of ~240k points stays under 4 MB
+struct LidarPoint {
+    float x, y, z;      // Meters, sensor frame: x right, y forward, z up
+    uint8_t intensity;
+    uint8_t ring;       // Laser index ordered by elevation, 0 = lowest
+    uint16_t azimuth;   // Hundredths of a degree, clockwise from y
+};
+
+struct LidarScan {
+    std::vector<LidarPoint> points;
+    uint64_t index = 0;
+    uint64_t start_us = 0; // Capture time of the first packet
+    uint32_t packets = 0;
+};
+
+struct VelodyneCalibration {
+    std::vector<float> elevation_deg;       // Vertical angle of each laser, in firing order
+    std::vector<float> azimuth_offset_deg;  // Horizontal correction of each laser
+    float distance_resolution_m = 0.002f;
+};
+
+// Datasheet tables for the VLP-16 and HDL-32E. The VLS-128 has per-unit angles; without a
+// calibration file its lasers are spread evenly from -25 to +15 degrees, which is only
+// good enough for throughput measurements.
+VelodyneCalibration defaultCalibration(VelodyneModel model);
+
+// Text file with one "elevation_deg azimuth_offset_deg" line per laser in firing order
+bool loadCalibration(const std::string& path, VelodyneModel model, VelodyneCalibration& calibration);
+
+// Decodes packets straight into the scan under construction. A scan is complete when
+// the azimuth wraps around; the caller passes in a recycled scan that is swapped with
+// the finished one, so steady-state decoding allocates nothing.
+class VelodyneDecoder {
+public:
+    VelodyneDecoder(VelodyneModel model, const VelodyneCalibration& calibration,
+        float min_range_m = 0.5f, float max_range_m = 200.0f);
+
+    // Returns true when this packet completed a scan, which is then swapped into
+    // completed. Malformed packets are counted and ignored.
+    bool add(const VelodynePacket& packet, LidarScan& completed);
+
+    int rings() const { return static_cast<int>(ring_.size()); }
+    uint64_t badPackets() const { return bad_packets_; }
+
+private:
+    void finishScan(LidarScan& completed);
+
+    VelodyneModel model_;
+    float resolution_;
+    float min_range_, max_range_;
+    std::vector<float> cos_elevation_, sin_elevation_;
+    std::vector<int> azimuth_offset_;  // Hundredths of a degree
+    std::vector<uint8_t> ring_;
+    std::vector<float> sin_azimuth_, cos_azimuth_; // 36000 entries
+    std::vector<float> channel_time_us_;          // Firing offset of each block channel
+
+    LidarScan current_;
+    int last_azimuth_ = -1;
+    float azimuth_rate_ = 0.0f; // Hundredths of a degree per microsecond
+    uint64_t scans_ = 0;
+    uint64_t bad_packets_ = 0;
+};
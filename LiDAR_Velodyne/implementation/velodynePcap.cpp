@@ -0,0 +1,101 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// velodynePcap.cpp : Zero-copy reader for Velodyne data packets recorded in pcap files.
+//
+#include "velodynePcap.h"
+
+namespace {
+
+const uint32_t kMagicMicro = 0xa1b2c3d4;
+const uint32_t kMagicNano = 0xa1b23c4d;
+const uint32_t kLinkEthernet = 1;
+const size_t kRecordHeaderBytes = 16;
+
+uint32_t byteSwap(uint32_t v) {
+    return (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+}
+
+uint16_t bigEndian16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+} // namespace
+
+uint32_t VelodynePcapReader::read32(const uint8_t* p) const {
+    uint32_t v = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    return swapped_ ? byteSwap(v) : v;
+}
+
+bool VelodynePcapReader::open(const std::string& path, uint16_t port) {
+    close();
+    if (!file_.open(path) || file_.size() < kGlobalHeaderBytes) return false;
+
+    const uint8_t* header = reinterpret_cast<const uint8_t*>(file_.data());
+    swapped_ = false;
+    uint32_t magic = read32(header);
+    if (magic != kMagicMicro && magic != kMagicNano) {
+        swapped_ = true;
+        magic = read32(header);
+    }
+    if ((magic != kMagicMicro && magic != kMagicNano) || read32(header + 20) != kLinkEthernet) {
+        close();
+        return false;
+    }
+    nanoseconds_ = magic == kMagicNano;
+    port_ = port;
+    offset_ = kGlobalHeaderBytes;
+    skipped_ = 0;
+    return true;
+}
+
+void VelodynePcapReader::close() {
+    file_.close();
+    offset_ = 0;
+}
+
+bool VelodynePcapReader::next(VelodynePacket& packet) {
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(file_.data());
+    while (file_.isOpen() && offset_ + kRecordHeaderBytes <= file_.size()) {
+        const uint8_t* record = base + offset_;
+        const uint32_t seconds = read32(record);
+        const uint32_t fraction = read32(record + 4);
+        const uint32_t captured = read32(record + 8);
+        const uint8_t* frame = record + kRecordHeaderBytes;
+        if (offset_ + kRecordHeaderBytes + captured > file_.size()) break; // Truncated capture
+        offset_ += kRecordHeaderBytes + captured;
+
+        // Ethernet, optional 802.1Q tag, IPv4, UDP
+        size_t at = 14;
+        if (captured < at) {
+            skipped_++;
+            continue;
+        }
+        uint16_t ether_type = bigEndian16(frame + 12);
+        if (ether_type == 0x8100 && captured >= 18) {
+            ether_type = bigEndian16(frame + 16);
+            at = 18;
+        }
+        if (ether_type != 0x0800 || captured < at + 20 || (frame[at] >> 4) != 4 || frame[at + 9] != 17) {
+            skipped_++;
+            continue;
+        }
+        const size_t ip_header = size_t(frame[at] & 0x0f) * 4;
+        const size_t udp = at + ip_header;
+        if (ip_header < 20 || captured < udp + 8 || bigEndian16(frame + udp + 2) != port_) {
+            skipped_++;
+            continue;
+        }
+        const size_t length = bigEndian16(frame + udp + 4);
+        if (length < 8 || udp + length > captured) {
+            skipped_++;
+            continue;
+        }
+
+        packet.data = frame + udp + 8;
+        packet.size = length - 8;
+        packet.capture_us = uint64_t(seconds) * 1000000 + (nanoseconds_ ? fraction / 1000 : fraction);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,52 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// velodynePcap.h : Zero-copy reader for Velodyne data packets recorded in pcap files.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mappedFile.h"
+
+// UDP payload of one Velodyne data packet, pointing into the mapped capture
+struct VelodynePacket {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    uint64_t capture_us = 0; // pcap record time, microseconds since the epoch
+};
+
+const size_t kVelodynePacketBytes = 1206;
+const uint16_t kVelodyneDataPort = 2368;
+
+// Walks the records of a classic pcap file (microsecond or nanosecond, either byte order)
+// with Ethernet framing and returns the UDP payloads sent to the data port. Position
+// packets (port 8308), other traffic and truncated records are skipped. The capture is
+// memory mapped, so packets are never copied.
+class VelodynePcapReader {
+public:
+    bool open(const std::string& path, uint16_t port = kVelodyneDataPort);
+    void close();
+
+    // Next data packet; returns false at the end of the capture
+    bool next(VelodynePacket& packet);
+
+    // Restart from the first packet (replay loops)
+    void rewind() { offset_ = kGlobalHeaderBytes; }
+
+    size_t skippedRecords() const { return skipped_; }
+
+private:
+    static const size_t kGlobalHeaderBytes = 24;
+
+    uint32_t read32(const uint8_t* p) const;
+
+    MappedFile file_;
+    uint16_t port_ = kVelodyneDataPort;
+    size_t offset_ = 0;
+    bool swapped_ = false;
+    bool nanoseconds_ = false;
+    size_t skipped_ = 0;
+};
@@ -0,0 +1,156 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// velodyneReplay.cpp : Replays a Velodyne pcap capture through packet decoding, scan
+// assembly, ground removal and voxel-grid downsampling, and reports the throughput:
+//
+//   velodyneReplay capture.pcap vlp16                 # as fast as possible
+//   velodyneReplay capture.pcap vls128 --realtime     # paced by the capture timestamps
+//   velodyneReplay capture.pcap hdl32 --calibration hdl32.txt --threads 4
+//
+// Decoding runs on its own thread and hands complete scans to the filter through a
+// small queue of recycled scan buffers.
+//
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cloudFilter.h"
+#include "tracing.h"
+#include "velodyneDecoder.h"
+#include "velodynePcap.h"
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <capture.pcap> <vlp16|hdl32|vls128> [--realtime] [--calibration file] [--threads n]" << std::endl;
+        return -1;
+    }
+    trace::Session tracing("velodyne_replay");
+
+    VelodyneModel model;
+    if (!parseVelodyneModel(argv[2], model)) {
+        std::cerr << "Error: Unknown model " << argv[2] << std::endl;
+        return -1;
+    }
+    bool realtime = false;
+    VelodyneCalibration calibration = defaultCalibration(model);
+    CloudFilterConfig filter_config;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        }
+        else if (std::strcmp(argv[i], "--calibration") == 0 && i + 1 < argc) {
+            if (!loadCalibration(argv[++i], model, calibration)) {
+                std::cerr << "Error: Unable to read calibration " << argv[i] << std::endl;
+                return -1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            filter_config.threads = std::atoi(argv[++i]);
+        }
+    }
+
+    VelodynePcapReader reader;
+    if (!reader.open(argv[1])) {
+        std::cerr << "Error: Unable to open " << argv[1] << " as an Ethernet pcap capture" << std::endl;
+        return -1;
+    }
+    VelodyneDecoder decoder(model, calibration);
+    CloudFilter filter(filter_config);
+
+    // Scan buffers circulate between the decoder thread and the filter
+    const size_t kQueueDepth = 4;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<LidarScan> ready, spare(kQueueDepth + 1);
+    bool decoding_done = false;
+    uint64_t packets = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread decode_thread([&] {
+        trace::setThreadName("decode");
+        LidarScan scan;
+        VelodynePacket packet;
+        uint64_t first_capture_us = 0;
+        while (reader.next(packet)) {
+            packets++;
+            if (realtime) {
+                if (first_capture_us == 0) first_capture_us = packet.capture_us;
+                std::this_thread::sleep_until(start + std::chrono::microseconds(packet.capture_us - first_capture_us));
+            }
+            if (!decoder.add(packet, scan)) continue;
+
+            // Hand over the finished scan, take an empty buffer back
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return !spare.empty(); });
+            ready.push_back(std::move(scan));
+            scan = std::move(spare.front());
+            spare.pop_front();
+            changed.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        decoding_done = true;
+        changed.notify_all();
+    });
+
+    std::vector<LidarPoint> obstacles, ground;
+    uint64_t scans = 0, points = 0, obstacle_points = 0, ground_points = 0;
+    double filter_s = 0.0;
+    while (true) {
+        LidarScan scan;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return !ready.empty() || decoding_done; });
+            if (ready.empty()) break;
+            scan = std::move(ready.front());
+            ready.pop_front();
+        }
+
+        auto filter_start = std::chrono::steady_clock::now();
+        filter.process(scan, decoder.rings(), obstacles, ground);
+        filter_s += secondsSince(filter_start);
+
+        scans++;
+        points += scan.points.size();
+        obstacle_points += obstacles.size();
+        ground_points += ground.size();
+        if (scans % 10 == 0) {
+            std::printf("[velodyne] scan %llu: %zu points, %zu ground, %zu obstacle voxels\n",
+                static_cast<unsigned long long>(scan.index), scan.points.size(), ground.size(), obstacles.size());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        spare.push_back(std::move(scan));
+        changed.notify_all();
+    }
+    decode_thread.join();
+    const double elapsed = secondsSince(start);
+
+    if (scans == 0) {
+        std::cerr << "Error: No complete scan in " << argv[1] << " (" << packets << " data packets)" << std::endl;
+        return -1;
+    }
+    std::printf("Packets: %llu (%llu malformed, %zu other records)\n", static_cast<unsigned long long>(packets),
+        static_cast<unsigned long long>(decoder.badPackets()), reader.skippedRecords());
+    std::printf("Scans: %llu, %.0f points per scan, %.0f ground, %.0f obstacle voxels\n", static_cast<unsigned long long>(scans),
+        double(points) / scans, double(ground_points) / scans, double(obstacle_points) / scans);
+    std::printf("Throughput: %.2f M points/s end to end, %.2f M points/s filter (%d threads), %.2f ms per scan\n",
+        points / elapsed / 1e6, points / filter_s / 1e6, filter.threads(), filter_s * 1000.0 / scans);
+    return 0;
+}
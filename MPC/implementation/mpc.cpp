@@ -1,118 +1,332 @@
-#include <Eigen/Dense>
-#include <qpOASES.hpp>
-#include <vector>
-#include <iostream>
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// mpc.cpp : Linear MPC and real-time-iteration nonlinear MPC with input bounds, solved as
+// dense QPs with qpOASES.
+//
+#include "mpc.h"
+#include "workStealingPool.h"
+
+#include <algorithm>
+#include <chrono>
 #include <cmath>
-#include <iomanip>
+
+#include <qpOASES.hpp>
+#include <unsupported/Eigen/AutoDiff>
 
 using namespace Eigen;
-using namespace qpOASES;
 
-int main() {
-    const double dt = 0.1;  // Time step
+LinearMpc::LinearMpc(const MatrixXd& A, const MatrixXd& B, const MatrixXd& Q, const MatrixXd& R,
+    int horizon, double u_min, double u_max)
+    : n_(static_cast<int>(A.rows())), m_(static_cast<int>(B.cols())), N_(horizon), Q_(Q) {
+    const int n = n_, m = m_, N = N_;
+    const int variables = N * (n + m);
 
-    // System dynamics
-    Matrix2d A;
-    A << 1, dt, 0, 1;
+    // qpOASES minimizes 1/2 z^T H z + g^T z, so the quadratic weights are doubled
+    H_ = MatrixXd::Zero(variables, variables);
+    for (int i = 0; i < N; ++i) {
+        H_.block(i * n, i * n, n, n) = 2.0 * Q;
+        H_.block(N * n + i * m, N * n + i * m, m, m) = 2.0 * R;
+    }
+
+    // Equality constraints (dynamics) as lbA == ubA rows, followed by the input bounds
+    constraints_ = RowMajorMatrix::Zero(N * n + N * m, variables);
+    lbA_ = VectorXd::Zero(N * n + N * m);
+    ubA_ = VectorXd::Zero(N * n + N * m);
+    for (int i = 0; i < N; ++i) {
+        constraints_.block(i * n, i * n, n, n) = MatrixXd::Identity(n, n);
+        if (i > 0) {
+            constraints_.block(i * n, (i - 1) * n, n, n) = -A;
+            constraints_.block(i * n, N * n + (i - 1) * m, n, m) = -B;
+        }
+        constraints_.block(N * n + i * m, N * n + i * m, m, m) = MatrixXd::Identity(m, m);
+    }
+    lbA_.tail(N * m).setConstant(u_min);
+    ubA_.tail(N * m).setConstant(u_max);
 
-    Vector2d B;
-    B << 0, dt;
+    g_ = VectorXd::Zero(variables);
+    z_ = VectorXd::Zero(variables);
+}
 
-    const int n = 2;  // Number of states
-    const int m = 1;  // Number of control inputs
+bool LinearMpc::solve(const VectorXd& x, const VectorXd& x_goal, VectorXd& u) {
+    const int n = n_, m = m_, N = N_;
 
-    // MPC parameters
-    const int N = 10;  // Prediction horizon
-    Vector2d x_goal;
-    x_goal << 10, 0;  // Target state
+    // Linear cost term for the states and the initial state constraint
+    const VectorXd state_gradient = -2.0 * Q_ * x_goal;
+    for (int i = 0; i < N; ++i) {
+        g_.segment(i * n, n) = state_gradient;
+    }
+    lbA_.head(n) = x;
+    ubA_.head(n) = x;
 
-    // Cost matrices
-    Matrix2d Q = Matrix2d::Identity();  // State cost matrix
-    MatrixXd R = 0.1 * MatrixXd::Identity(m, m);  // Control input cost matrix
+    qpOASES::QProblem qp(N * (n + m), N * (n + m));
+    qpOASES::Options options;
+    options.setToDefault();
+    options.printLevel = qpOASES::PL_NONE;
+    qp.setOptions(options);
 
-    // Constraints
-    const double u_min = -2, u_max = 2;
+    qpOASES::int_t nWSR = 100;
+    if (qp.init(H_.data(), g_.data(), constraints_.data(), nullptr, nullptr, lbA_.data(), ubA_.data(), nWSR) != qpOASES::SUCCESSFUL_RETURN) {
+        return false;
+    }
+    qp.getPrimalSolution(z_.data());
 
-    // Initial state
-    Vector2d x;
-    x << 0, 0;
+    u = z_.segment(N * n, m);
+    return true;
+}
 
-    // Store state and control trajectories
-    std::vector<Vector2d> x_traj;
-    std::vector<double> u_traj;
-    x_traj.push_back(x);
+namespace {
 
-    // Total simulation time steps
-    const int T = 50;
+// Value and derivatives with respect to the 4 states and 2 inputs
+using Dual = AutoDiffScalar<Matrix<double, 6, 1>>;
 
-    for (int t = 0; t < T; ++t) {
-        // Set up QP problem
-        MatrixXd H = MatrixXd::Zero(N * (n + m), N * (n + m));
-        VectorXd g = VectorXd::Zero(N * (n + m));
+const double kInfinity = 1e20; // qpOASES::INFTY
 
-        // Fill cost matrix and vector
-        for (int i = 0; i < N; ++i) {
-            H.block(i * n, i * n, n, n) = Q;  // State cost
-            H.block(N * n + i * m, N * n + i * m, m, m) = R;  // Input cost
-            g.segment(i * n, n) = -2.0 * Q * x_goal;  // Linear cost term for state
-        }
-        g.segment(N * n, m) = VectorXd::Zero(m);
-
-        // Fill equality constraints (dynamics)
-        MatrixXd Aeq = MatrixXd::Zero(N * n, N * (n + m));
-        VectorXd beq = VectorXd::Zero(N * n);
-
-        for (int i = 0; i < N; ++i) {
-            if (i == 0) {
-                Aeq.block(0, 0, n, n) = MatrixXd::Identity(n, n);
-                beq.segment(0, n) = x;
-            } else {
-                Aeq.block(i * n, (i - 1) * n, n, n) = -A;
-                Aeq.block(i * n, N * n + (i - 1) * m, n, m) = -B;
-                Aeq.block(i * n, i * n, n, n) = MatrixXd::Identity(n, n);
-            }
-        }
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename T>
+Matrix<T, 4, 1> bicycleDerivative(const Matrix<T, 4, 1>& x, const Matrix<T, 2, 1>& u, double wheelbase) {
+    using std::cos;
+    using std::sin;
+    using std::tan;
+    Matrix<T, 4, 1> d;
+    d(0) = x(3) * cos(x(2));
+    d(1) = x(3) * sin(x(2));
+    d(2) = x(3) * tan(u(1)) / wheelbase;
+    d(3) = u(0);
+    return d;
+}
+
+template <typename T>
+Matrix<T, 4, 1> bicycleStep(const Matrix<T, 4, 1>& x, const Matrix<T, 2, 1>& u, double wheelbase, double dt) {
+    const T half(0.5 * dt), full(dt), sixth(dt / 6.0), two(2.0);
+    const Matrix<T, 4, 1> k1 = bicycleDerivative<T>(x, u, wheelbase);
+    const Matrix<T, 4, 1> k2 = bicycleDerivative<T>(x + half * k1, u, wheelbase);
+    const Matrix<T, 4, 1> k3 = bicycleDerivative<T>(x + half * k2, u, wheelbase);
+    const Matrix<T, 4, 1> k4 = bicycleDerivative<T>(x + full * k3, u, wheelbase);
+    return x + sixth * (k1 + two * k2 + two * k3 + k4);
+}
+
+} // namespace
+
+KinematicBicycle::State KinematicBicycle::step(const State& x, const Input& u) const {
+    return bicycleStep<double>(x, u, wheelbase, dt);
+}
+
+void KinematicBicycle::linearize(const State& x, const Input& u, State& next, Matrix4d& A, Matrix<double, 4, 2>& B) const {
+    Matrix<Dual, 4, 1> xd;
+    Matrix<Dual, 2, 1> ud;
+    for (int i = 0; i < kStates; ++i) xd(i) = Dual(x(i), kStates + kInputs, i);
+    for (int i = 0; i < kInputs; ++i) ud(i) = Dual(u(i), kStates + kInputs, kStates + i);
+
+    const Matrix<Dual, 4, 1> result = bicycleStep<Dual>(xd, ud, wheelbase, dt);
+    for (int i = 0; i < kStates; ++i) {
+        next(i) = result(i).value();
+        A.row(i) = result(i).derivatives().head<kStates>().transpose();
+        B.row(i) = result(i).derivatives().tail<kInputs>().transpose();
+    }
+}
+
+NonlinearMpc::NonlinearMpc(const KinematicBicycle& model, const NonlinearMpcOptions& options)
+    : model_(model), options_(options), N_(options.horizon) {
+    const int n = KinematicBicycle::kStates, m = KinematicBicycle::kInputs, N = N_;
+    variables_ = (N + 1) * n + N * m;
+
+    // x_0 is fixed by its bounds, its weight only keeps H positive definite
+    const MatrixXd Q = options.q.asDiagonal();
+    const MatrixXd R = options.r.asDiagonal();
+    H_ = MatrixXd::Zero(variables_, variables_);
+    for (int k = 0; k <= N; ++k) H_.block(k * n, k * n, n, n) = 2.0 * Q;
+    for (int k = 0; k < N; ++k) H_.block((N + 1) * n + k * m, (N + 1) * n + k * m, m, m) = 2.0 * R;
+
+    // Row block k: x_{k+1} - A_k x_k - B_k u_k = c_k
+    constraints_ = RowMajorMatrix::Zero(N * n, variables_);
+    for (int k = 0; k < N; ++k) constraints_.block(k * n, (k + 1) * n, n, n) = MatrixXd::Identity(n, n);
+    lbA_ = VectorXd::Zero(N * n);
+    ubA_ = VectorXd::Zero(N * n);
+
+    lb_ = VectorXd::Constant(variables_, -kInfinity);
+    ub_ = VectorXd::Constant(variables_, kInfinity);
+    for (int k = 0; k < N; ++k) {
+        lb_.segment((N + 1) * n + k * m, m) = options.u_min;
+        ub_.segment((N + 1) * n + k * m, m) = options.u_max;
+    }
+    g_ = VectorXd::Zero(variables_);
+    z_ = VectorXd::Zero(variables_);
 
-        // Input constraints
-        MatrixXd Ain = MatrixXd::Zero(N * m, N * (n + m));
-        VectorXd lb = VectorXd::Constant(N * m, u_min);
-        VectorXd ub = VectorXd::Constant(N * m, u_max);
+    xs_.assign(N + 1, State::Zero());
+    us_.assign(N, Input::Zero());
+    reference_.assign(N, State::Zero());
 
-        for (int i = 0; i < N; ++i) {
-            Ain.block(i * m, N * n + i * m, m, m) = MatrixXd::Identity(m, m);
+    qp_.reset(new qpOASES::SQProblem(variables_, N * n));
+    qpOASES::Options qp_options;
+    qp_options.setToMPC();
+    qp_options.printLevel = qpOASES::PL_NONE;
+    qp_->setOptions(qp_options);
+
+    if (options.threads > 1) pool_.reset(new WorkStealingPool(options.threads));
+}
+
+NonlinearMpc::~NonlinearMpc() = default;
+
+void NonlinearMpc::initialize(const State& x) {
+    xs_[0] = x;
+    for (int k = 0; k < N_; ++k) {
+        us_[k].setZero();
+        xs_[k + 1] = model_.step(xs_[k], us_[k]);
+    }
+    initialized_ = true;
+}
+
+void NonlinearMpc::linearizeStages(int begin, int end) {
+    const int n = KinematicBicycle::kStates, m = KinematicBicycle::kInputs, N = N_;
+    State next;
+    Matrix4d A;
+    Matrix<double, 4, 2> B;
+    for (int k = begin; k < end; ++k) {
+        model_.linearize(xs_[k], us_[k], next, A, B);
+        constraints_.block(k * n, k * n, n, n) = -A;
+        constraints_.block(k * n, (N + 1) * n + k * m, n, m) = -B;
+        const State c = next - A * xs_[k] - B * us_[k];
+        lbA_.segment(k * n, n) = c;
+        ubA_.segment(k * n, n) = c;
+    }
+}
+
+void NonlinearMpc::linearize() {
+    const auto start = std::chrono::steady_clock::now();
+    if (pool_) {
+        // Stages are independent; contiguous chunks keep each worker's rows together
+        const int chunks = std::min(pool_->threads(), N_);
+        for (int i = 0; i < chunks; ++i) {
+            const int begin = N_ * i / chunks, end = N_ * (i + 1) / chunks;
+            pool_->submit([this, begin, end](int) { linearizeStages(begin, end); }, i);
         }
+        pool_->waitIdle();
+    }
+    else {
+        linearizeStages(0, N_);
+    }
+    linearize_s_ += secondsSince(start);
+}
 
-        // Solve QP
-        QProblem qp(N * (n + m), N * m);
-        Options options;
-        options.setToDefault();
-        qp.setOptions(options);
+void NonlinearMpc::setReference(const std::vector<State>& reference) {
+    const int n = KinematicBicycle::kStates;
+    linearize_s_ = 0.0;
+    qp_s_ = 0.0;
+    iterations_ = 0;
 
-        int nWSR = 100;
-        qp.init(H.data(), g.data(), Ain.data(), lb.data(), ub.data(), Aeq.data(), beq.data(), nWSR);
+    // A short reference is extended with its last state
+    for (int k = 0; k < N_; ++k) {
+        reference_[k] = reference.empty() ? xs_[k + 1] : reference[std::min<size_t>(k, reference.size() - 1)];
+        g_.segment((k + 1) * n, n) = -2.0 * options_.q.cwiseProduct(reference_[k]);
+    }
+}
 
-        VectorXd z(N * (n + m));
-        qp.getPrimalSolution(z.data());
+void NonlinearMpc::prepare(const std::vector<State>& reference) {
+    setReference(reference);
+    linearize();
+}
 
-        // Extract control input
-        double u_opt = z[N * n];
+bool NonlinearMpc::solveQp(const State& x) {
+    const int n = KinematicBicycle::kStates, N = N_;
+    const auto start = std::chrono::steady_clock::now();
 
-        // Apply control input to the system
-        x = A * x + B * u_opt;
-        x_traj.push_back(x);
-        u_traj.push_back(u_opt);
+    lb_.head(n) = x;
+    ub_.head(n) = x;
+    g_.head(n) = -2.0 * options_.q.cwiseProduct(x);
+
+    // Hot start from the previous active set; a cold start if that fails
+    qpOASES::int_t nWSR = 200;
+    qpOASES::returnValue status = qpOASES::RET_HOTSTART_FAILED;
+    if (qp_started_) {
+        status = qp_->hotstart(H_.data(), g_.data(), constraints_.data(), lb_.data(), ub_.data(), lbA_.data(), ubA_.data(), nWSR);
+    }
+    if (status != qpOASES::SUCCESSFUL_RETURN) {
+        qpOASES::Options qp_options = qp_->getOptions();
+        qp_.reset(new qpOASES::SQProblem(variables_, N * n));
+        qp_->setOptions(qp_options);
+        nWSR = 200;
+        status = qp_->init(H_.data(), g_.data(), constraints_.data(), lb_.data(), ub_.data(), lbA_.data(), ubA_.data(), nWSR);
     }
+    qp_started_ = status == qpOASES::SUCCESSFUL_RETURN;
+    if (qp_started_) qp_->getPrimalSolution(z_.data());
+    iterations_++;
+    qp_s_ += secondsSince(start);
+    return qp_started_;
+}
 
-    // Print results
-    std::cout << "State Trajectory:\n";
-    for (const auto& state : x_traj) {
-        std::cout << state.transpose() << std::endl;
+double NonlinearMpc::rollout(const State& x, const std::vector<Input>& us, std::vector<State>& xs) const {
+    double cost = 0.0;
+    xs[0] = x;
+    for (int k = 0; k < N_; ++k) {
+        xs[k + 1] = model_.step(xs[k], us[k]);
+        const State error = xs[k + 1] - reference_[k];
+        cost += error.dot(options_.q.cwiseProduct(error)) + us[k].dot(options_.r.cwiseProduct(us[k]));
     }
+    return cost;
+}
 
-    std::cout << "Control Trajectory:\n";
-    for (const auto& u : u_traj) {
-        std::cout << u << std::endl;
+bool NonlinearMpc::feedback(const State& x, Input& u) {
+    if (!initialized_) initialize(x);
+    if (!solveQp(x)) return false;
+
+    // Full step: the QP trajectory becomes the guess
+    const int n = KinematicBicycle::kStates, m = KinematicBicycle::kInputs, N = N_;
+    for (int k = 0; k <= N; ++k) xs_[k] = z_.segment(k * n, n);
+    for (int k = 0; k < N; ++k) us_[k] = z_.segment((N + 1) * n + k * m, m);
+    u = us_[0];
+    shift();
+    return true;
+}
+
+bool NonlinearMpc::solve(const State& x, const std::vector<State>& reference, Input& u) {
+    if (!initialized_) initialize(x);
+    if (options_.max_iterations <= 1) {
+        prepare(reference);
+        return feedback(x, u);
     }
 
-    return 0;
+    // SQP: every iterate is a rollout of its inputs from the measured state, so it is
+    // dynamically feasible. The input step of each QP is halved until the cost decreases.
+    const int n = KinematicBicycle::kStates, m = KinematicBicycle::kInputs, N = N_;
+    setReference(reference);
+    double cost = rollout(x, us_, xs_);
+    std::vector<State> trial_xs(N + 1);
+    std::vector<Input> step(N), trial_us(N);
+    for (int i = 0; i < options_.max_iterations; ++i) {
+        linearize();
+        if (!solveQp(x)) return false;
+
+        double largest = 0.0;
+        for (int k = 0; k < N; ++k) {
+            step[k] = z_.segment((N + 1) * n + k * m, m) - us_[k];
+            largest = std::max(largest, step[k].cwiseAbs().maxCoeff());
+        }
+        if (largest < options_.sqp_tolerance) break;
+
+        bool improved = false;
+        for (double alpha = 1.0; alpha > 1e-3 && !improved; alpha *= 0.5) {
+            for (int k = 0; k < N; ++k) trial_us[k] = us_[k] + alpha * step[k];
+            const double trial_cost = rollout(x, trial_us, trial_xs);
+            if (trial_cost < cost) {
+                us_.swap(trial_us);
+                xs_.swap(trial_xs);
+                cost = trial_cost;
+                improved = true;
+            }
+        }
+        if (!improved) break; // Stationary up to the line search resolution
+    }
+    u = us_[0];
+    shift();
+    return true;
+}
+
+void NonlinearMpc::shift() {
+    for (int k = 0; k < N_; ++k) xs_[k] = xs_[k + 1];
+    for (int k = 0; k + 1 < N_; ++k) us_[k] = us_[k + 1];
+    xs_[N_] = model_.step(xs_[N_ - 1], us_[N_ - 1]);
 }
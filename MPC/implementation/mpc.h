@@ -0,0 +1,145 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// mpc.h : Linear MPC and real-time-iteration nonlinear MPC with input bounds, solved as
+// dense QPs with qpOASES.
+//
+#pragma once
+
+#include <Eigen/Dense>
+
+#include <memory>
+#include <vector>
+
+namespace qpOASES { class SQProblem; }
+class WorkStealingPool;
+
+// Minimizes sum (x_k - x_goal)^T Q (x_k - x_goal) + u_k^T R u_k over the horizon,
+// subject to x_{k+1} = A x_k + B u_k and u_min <= u_k <= u_max. The decision vector is
+// z = [x_0 ... x_{N-1}, u_0 ... u_{N-1}], x_0 is fixed to the measured state.
+class LinearMpc {
+public:
+    LinearMpc(const Eigen::MatrixXd& A, const Eigen::MatrixXd& B, const Eigen::MatrixXd& Q,
+        const Eigen::MatrixXd& R, int horizon, double u_min, double u_max);
+
+    // Solve for the current state x and return the first control input in u.
+    // Returns false if qpOASES does not find a solution.
+    bool solve(const Eigen::VectorXd& x, const Eigen::VectorXd& x_goal, Eigen::VectorXd& u);
+
+    int horizon() const { return N_; }
+
+private:
+    using RowMajorMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    int n_, m_, N_;
+    Eigen::MatrixXd Q_;
+    Eigen::MatrixXd H_;         // Constant Hessian
+    RowMajorMatrix constraints_; // Dynamics rows, then input rows (qpOASES expects row major)
+    Eigen::VectorXd lbA_, ubA_;
+    Eigen::VectorXd g_, z_;
+};
+
+// Kinematic bicycle model: state [x, y, yaw, v], input [acceleration, steering angle].
+// x' = v cos(yaw), y' = v sin(yaw), yaw' = v tan(steering) / wheelbase, v' = acceleration,
+// integrated with one RK4 step per control interval.
+struct KinematicBicycle {
+    static const int kStates = 4;
+    static const int kInputs = 2;
+    using State = Eigen::Matrix<double, kStates, 1>;
+    using Input = Eigen::Matrix<double, kInputs, 1>;
+
+    double wheelbase = 2.7;
+    double dt = 0.1;
+
+    State step(const State& x, const Input& u) const;
+
+    // step() and its Jacobians A = d step / dx, B = d step / du (forward-mode automatic
+    // differentiation)
+    void linearize(const State& x, const Input& u, State& next, Eigen::Matrix4d& A, Eigen::Matrix<double, 4, 2>& B) const;
+};
+
+struct NonlinearMpcOptions {
+    int horizon = 20;
+    Eigen::Vector4d q = Eigen::Vector4d(1.0, 1.0, 0.5, 0.1); // State weights
+    Eigen::Vector2d r = Eigen::Vector2d(0.1, 1.0);           // Input weights
+    KinematicBicycle::Input u_min = KinematicBicycle::Input(-3.0, -0.5);
+    KinematicBicycle::Input u_max = KinematicBicycle::Input(2.0, 0.5);
+
+    // 1 = real-time iteration: one linearization and one full-step QP per step. More
+    // iterations run an SQP with a backtracking line search on the inputs until the
+    // largest input step is below sqp_tolerance (the converged reference).
+    int max_iterations = 1;
+    double sqp_tolerance = 1e-6;
+
+    int threads = 1; // Linearize the horizon stages on this many threads
+};
+
+// Nonlinear MPC for the kinematic bicycle, tracking a reference trajectory:
+//
+//   min  sum_{k=1..N} (x_k - r_k)^T Q (x_k - r_k) + sum_{k=0..N-1} u_k^T R u_k
+//   s.t. x_{k+1} = f(x_k, u_k), u_min <= u_k <= u_max, x_0 = measured state
+//
+// Each iteration linearizes f around the current guess of the trajectory and solves the
+// QP with x_{k+1} - A_k x_k - B_k u_k = f(xg_k, ug_k) - A_k xg_k - B_k ug_k as rows. The
+// decision vector is z = [x_0 ... x_N, u_0 ... u_{N-1}]; x_0 is fixed through its bounds,
+// so the linearization does not need the measurement. The dense Hessian and constraint
+// matrix are allocated once and only the A_k, B_k blocks are rewritten; qpOASES
+// hot-starts from the previous active set. After each step the solution is shifted by
+// one stage as the next guess.
+class NonlinearMpc {
+public:
+    using State = KinematicBicycle::State;
+    using Input = KinematicBicycle::Input;
+
+    NonlinearMpc(const KinematicBicycle& model, const NonlinearMpcOptions& options);
+    ~NonlinearMpc();
+
+    // One control step. reference holds r_1 ... r_N, the states wanted dt ... N dt ahead.
+    // Returns false if qpOASES does not find a solution.
+    bool solve(const State& x, const std::vector<State>& reference, Input& u);
+
+    // The real-time iteration split in two: prepare() linearizes around the shifted guess
+    // before the measurement is available, feedback() only solves the QP. solve() with
+    // max_iterations = 1 is prepare() followed by feedback(). The first step must be a
+    // solve(), prepare() needs the guess it leaves behind.
+    void prepare(const std::vector<State>& reference);
+    bool feedback(const State& x, Input& u);
+
+    // Forget the guess; the next step starts from a rollout with zero input
+    void reset() { initialized_ = false; }
+
+    int horizon() const { return N_; }
+    int iterations() const { return iterations_; }          // SQP iterations of the last step
+    double linearizeSeconds() const { return linearize_s_; } // Of the last step
+    double qpSeconds() const { return qp_s_; }
+    const std::vector<State>& predictedStates() const { return xs_; }
+
+private:
+    using RowMajorMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    void initialize(const State& x);
+    void setReference(const std::vector<State>& reference);
+    void linearize();
+    void linearizeStages(int begin, int end);
+    bool solveQp(const State& x);
+    double rollout(const State& x, const std::vector<Input>& us, std::vector<State>& xs) const;
+    void shift();
+
+    KinematicBicycle model_;
+    NonlinearMpcOptions options_;
+    int N_, variables_;
+
+    std::vector<State> xs_;     // Guess x_0 ... x_N
+    std::vector<Input> us_;     // Guess u_0 ... u_{N-1}
+    std::vector<State> reference_;
+    bool initialized_ = false;
+    int iterations_ = 0;
+    double linearize_s_ = 0.0, qp_s_ = 0.0;
+
+    Eigen::MatrixXd H_;            // Constant Hessian
+    RowMajorMatrix constraints_;   // Dynamics rows, only the A_k, B_k blocks change
+    Eigen::VectorXd g_, lb_, ub_, lbA_, ubA_, z_;
+    std::unique_ptr<qpOASES::SQProblem> qp_;
+    bool qp_started_ = false;
+    std::unique_ptr<WorkStealingPool> pool_;
+};
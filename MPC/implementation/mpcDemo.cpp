@@ -0,0 +1,79 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// mpcDemo.cpp : This file contains the 'main' function. Program execution begins and ends there.
+//
+#include <Eigen/Dense>
+#include <vector>
+#include <iostream>
+
+#include "mpc.h"
+
+using namespace Eigen;
+
+int main() {
+    const double dt = 0.1;  // Time step
+
+    // System dynamics
+    Matrix2d A;
+    A << 1, dt, 0, 1;
+
+    Vector2d B;
+    B << 0, dt;
+
+    const int m = 1;  // Number of control inputs
+
+    // MPC parameters
+    const int N = 10;  // Prediction horizon
+    Vector2d x_goal;
+    x_goal << 10, 0;  // Target state
+
+    // Cost matrices
+    Matrix2d Q = Matrix2d::Identity();  // State cost matrix
+    MatrixXd R = 0.1 * MatrixXd::Identity(m, m);  // Control input cost matrix
+
+    // Constraints
+    const double u_min = -2, u_max = 2;
+
+    LinearMpc mpc(A, B, Q, R, N, u_min, u_max);
+
+    // Initial state
+    Vector2d x;
+    x << 0, 0;
+
+    // Store state and control trajectories
+    std::vector<Vector2d> x_traj;
+    std::vector<double> u_traj;
+    x_traj.push_back(x);
+
+    // Total simulation time steps
+    const int T = 50;
+
+    for (int t = 0; t < T; ++t) {
+        // Solve QP
+        VectorXd u(m);
+        if (!mpc.solve(x, x_goal, u)) {
+            std::cerr << "Error: QP failed at step " << t << std::endl;
+            return -1;
+        }
+        double u_opt = u[0];
+
+        // Apply control input to the system
+        x = A * x + B * u_opt;
+        x_traj.push_back(x);
+        u_traj.push_back(u_opt);
+    }
+
+    // Print results
+    std::cout << "State Trajectory:\n";
+    for (const auto& state : x_traj) {
+        std::cout << state.transpose() << std::endl;
+    }
+
+    std::cout << "Control Trajectory:\n";
+    for (const auto& u : u_traj) {
+        std::cout << u << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// associationBenchmark.cpp : Measures data association cost of TrackManager with many
+// simultaneous targets, detection noise, missed detections and clutter.
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "kalmanTrackPool.h"
+#include "trackManager.h"
+
+struct Target {
+    float x, y, vx, vy;
+};
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(p * (values.size() - 1));
+    return values[index];
+}
+
+int main(int argc, char** argv) {
+    const int num_targets = argc > 1 ? std::atoi(argv[1]) : 50;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 2000;
+    const int clutter = num_targets / 5;
+    const float width = 1280.0f, height = 720.0f;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> ux(0.0f, width), uy(0.0f, height), uv(-4.0f, 4.0f), u01(0.0f, 1.0f);
+    std::normal_distribution<float> noise(0.0f, 2.0f);
+
+    std::vector<Target> targets(num_targets);
+    for (auto& target : targets) target = { ux(gen), uy(gen), uv(gen), uv(gen) };
+
+    KalmanTrackPool pool(4 * num_targets, 25.0, 0.01, 4.0, 500.0);
+    TrackManager<KalmanTrackPool> tracker(pool);
+
+    std::vector<Detection> detections;
+    std::vector<double> predict_us, associate_us, update_us, step_us;
+    predict_us.reserve(frames);
+    associate_us.reserve(frames);
+    update_us.reserve(frames);
+    step_us.reserve(frames);
+
+    for (int f = 0; f < frames; ++f) {
+        // Move targets, bouncing off the frame border
+        detections.clear();
+        for (auto& target : targets) {
+            target.x += target.vx;
+            target.y += target.vy;
+            if (target.x < 0.0f || target.x > width) target.vx = -target.vx;
+            if (target.y < 0.0f || target.y > height) target.vy = -target.vy;
+            if (u01(gen) < 0.9f) detections.push_back({ target.x + noise(gen), target.y + noise(gen) });
+        }
+        for (int c = 0; c < clutter; ++c) detections.push_back({ ux(gen), uy(gen) });
+        std::shuffle(detections.begin(), detections.end(), gen);
+
+        // The phases of tracker.step(), timed one by one
+        auto t0 = std::chrono::steady_clock::now();
+        tracker.predict();
+        auto t1 = std::chrono::steady_clock::now();
+        tracker.associate(detections);
+        auto t2 = std::chrono::steady_clock::now();
+        tracker.update(detections);
+        auto t3 = std::chrono::steady_clock::now();
+
+        if (f >= 20) { // Skip track initialization
+            predict_us.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+            associate_us.push_back(std::chrono::duration<double, std::micro>(t2 - t1).count());
+            update_us.push_back(std::chrono::duration<double, std::micro>(t3 - t2).count());
+            step_us.push_back(std::chrono::duration<double, std::micro>(t3 - t0).count());
+        }
+    }
+
+    int confirmed = 0;
+    for (int slot : tracker.liveTracks()) {
+        if (tracker.status(slot) == TrackStatus::Confirmed) confirmed++;
+    }
+
+    std::printf("targets %d, detections/frame ~%zu, live tracks %zu, confirmed %d\n",
+        num_targets, detections.size(), tracker.liveTracks().size(), confirmed);
+    std::printf("%-10s %10s %10s %10s %10s\n", "stage", "p50 us", "p90 us", "p99 us", "max us");
+    const std::pair<const char*, const std::vector<double>*> stages[] = {
+        { "predict", &predict_us }, { "associate", &associate_us }, { "update", &update_us }, { "step", &step_us } };
+    for (const auto& stage : stages) {
+        const std::vector<double>& us = *stage.second;
+        std::printf("%-10s %10.2f %10.2f %10.2f %10.2f\n", stage.first,
+            percentile(us, 0.5), percentile(us, 0.9), percentile(us, 0.99), percentile(us, 1.0));
+    }
+    return 0;
+}
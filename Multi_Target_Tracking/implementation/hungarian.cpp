@@ -0,0 +1,101 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// hungarian.cpp : O(n^2 m) Hungarian algorithm with row/column potentials.
+//
+#include "hungarian.h"
+
+#include <algorithm>
+#include <limits>
+
+double HungarianSolver::solve(const float* cost, int rows, int cols, int* row_to_col) {
+    if (rows <= 0 || cols <= 0) {
+        std::fill(row_to_col, row_to_col + std::max(rows, 0), -1);
+        return 0.0;
+    }
+    if (rows <= cols) {
+        return solveWide(cost, rows, cols, row_to_col);
+    }
+
+    // More rows than columns: solve the transposed problem and invert the mapping
+    transposed_.resize(static_cast<size_t>(rows) * cols);
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            transposed_[static_cast<size_t>(c) * rows + r] = cost[static_cast<size_t>(r) * cols + c];
+        }
+    }
+    col_to_row_.resize(cols);
+    double total = solveWide(transposed_.data(), cols, rows, col_to_row_.data());
+    std::fill(row_to_col, row_to_col + rows, -1);
+    for (int c = 0; c < cols; ++c) {
+        row_to_col[col_to_row_[c]] = c;
+    }
+    return total;
+}
+
+double HungarianSolver::solveWide(const float* cost, int rows, int cols, int* row_to_col) {
+    const double inf = std::numeric_limits<double>::infinity();
+    const int n = rows, m = cols;
+
+    // 1-based arrays, index 0 is the virtual source column
+    u_.assign(n + 1, 0.0);
+    v_.assign(m + 1, 0.0);
+    p_.assign(m + 1, 0);
+    way_.assign(m + 1, 0);
+    min_v_.resize(m + 1);
+    used_.resize(m + 1);
+
+    for (int i = 1; i <= n; ++i) {
+        p_[0] = i;
+        int j0 = 0;
+        std::fill(min_v_.begin(), min_v_.end(), inf);
+        std::fill(used_.begin(), used_.end(), 0);
+
+        // Grow an alternating tree from row i until a free column is reached
+        do {
+            used_[j0] = 1;
+            const int i0 = p_[j0];
+            const float* row = cost + static_cast<size_t>(i0 - 1) * m;
+            double delta = inf;
+            int j1 = 0;
+            for (int j = 1; j <= m; ++j) {
+                if (used_[j]) continue;
+                double cur = row[j - 1] - u_[i0] - v_[j];
+                if (cur < min_v_[j]) {
+                    min_v_[j] = cur;
+                    way_[j] = j0;
+                }
+                if (min_v_[j] < delta) {
+                    delta = min_v_[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= m; ++j) {
+                if (used_[j]) {
+                    u_[p_[j]] += delta;
+                    v_[j] -= delta;
+                }
+                else {
+                    min_v_[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p_[j0] != 0);
+
+        // Augment along the path back to the source
+        do {
+            int j1 = way_[j0];
+            p_[j0] = p_[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    double total = 0.0;
+    for (int j = 1; j <= m; ++j) {
+        if (p_[j] != 0) {
+            row_to_col[p_[j] - 1] = j - 1;
+            total += cost[static_cast<size_t>(p_[j] - 1) * m + (j - 1)];
+        }
+    }
+    return total;
+}
@@ -0,0 +1,25 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// hungarian.h : Rectangular linear assignment (Hungarian / shortest augmenting path).
+//
+#pragma once
+
+#include <vector>
+
+class HungarianSolver {
+public:
+    // Solve min-cost assignment for a row-major rows x cols cost matrix.
+    // row_to_col[r] receives the assigned column or -1 when rows > cols leaves r unassigned.
+    // Returns the total cost of the assignment. Internal buffers are reused between calls.
+    double solve(const float* cost, int rows, int cols, int* row_to_col);
+
+private:
+    double solveWide(const float* cost, int rows, int cols, int* row_to_col);
+
+    std::vector<double> u_, v_, min_v_;
+    std::vector<int> p_, way_;
+    std::vector<char> used_;
+    std::vector<float> transposed_;
+    std::vector<int> col_to_row_;
+};
@@ -0,0 +1,55 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// kalmanTrackPool.cpp : Contiguous pool of [x, y, theta] Kalman filters for TrackManager.
+//
+#include "kalmanTrackPool.h"
+
+KalmanTrackPool::KalmanTrackPool(size_t capacity, double process_xy, double process_theta,
+    double measurement_var, double initial_var)
+    : filters_(capacity) {
+    process_cov_ = Filter::StateMatrix::zeros();
+    process_cov_(0, 0) = process_xy;
+    process_cov_(1, 1) = process_xy;
+    process_cov_(2, 2) = process_theta;
+    initial_cov_ = initial_var * Filter::StateMatrix::identity();
+    H_ = Filter::MeasurementMatrix::identity();
+    measurement_cov_ = measurement_var * Filter::MeasurementCov::identity();
+    no_control_ = Filter::StateVector::zeros();
+}
+
+void KalmanTrackPool::initialize(int slot, float x, float y) {
+    Filter::StateVector x0 = Filter::StateVector::zeros();
+    x0(0, 0) = x;
+    x0(1, 0) = y;
+    filters_[slot].initialize(x0, initial_cov_);
+}
+
+void KalmanTrackPool::predict(const std::vector<int>& slots) {
+    // No control input: the state is unchanged and P = P + Q
+    for (int slot : slots) {
+        filters_[slot].predict(no_control_, process_cov_);
+    }
+}
+
+void KalmanTrackPool::innovation(int slot, float& zx, float& zy, float& sxx, float& sxy, float& syy) const {
+    const Filter& filter = filters_[slot];
+    const Filter::MeasurementCov S = filter.innovationCov(H_, measurement_cov_);
+    zx = static_cast<float>(filter.x(0, 0));
+    zy = static_cast<float>(filter.x(1, 0));
+    sxx = static_cast<float>(S(0, 0));
+    sxy = static_cast<float>(S(0, 1));
+    syy = static_cast<float>(S(1, 1));
+}
+
+void KalmanTrackPool::update(int slot, float zx, float zy) {
+    Filter::MeasurementVector z;
+    z(0, 0) = zx;
+    z(1, 0) = zy;
+    filters_[slot].update(z, H_, measurement_cov_);
+}
+
+void KalmanTrackPool::position(int slot, float& x, float& y) const {
+    x = static_cast<float>(filters_[slot].x(0, 0));
+    y = static_cast<float>(filters_[slot].x(1, 0));
+}
@@ -0,0 +1,36 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// kalmanTrackPool.h : Contiguous pool of [x, y, theta] Kalman filters for TrackManager.
+//
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "kalmanFilter.h"
+
+// Same model as movingFaceRecog.cpp: random-walk state [x, y, theta] observed through
+// H = [I2 0]. The fixed-size filters are stored back to back in one allocation.
+class KalmanTrackPool {
+public:
+    using Filter = KalmanFilter<double, 3, 2>;
+
+    KalmanTrackPool(size_t capacity, double process_xy, double process_theta,
+        double measurement_var, double initial_var);
+
+    size_t capacity() const { return filters_.size(); }
+    void initialize(int slot, float x, float y);
+    void predict(const std::vector<int>& slots);
+    void innovation(int slot, float& zx, float& zy, float& sxx, float& sxy, float& syy) const;
+    void update(int slot, float zx, float zy);
+    void position(int slot, float& x, float& y) const;
+    double theta(int slot) const { return filters_[slot].x(2, 0); }
+
+private:
+    std::vector<Filter> filters_;
+    Filter::StateMatrix process_cov_, initial_cov_;
+    Filter::MeasurementMatrix H_;
+    Filter::MeasurementCov measurement_cov_;
+    Filter::StateVector no_control_;
+};
@@ -0,0 +1,186 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// trackManager.h : Multi-target track management with gated Hungarian data association.
+//
+// The manager owns track bookkeeping (ids, hit/miss counters, free slots) while the
+// per-track filters live in a Pool that stores all tracks contiguously. A Pool provides:
+//
+//   size_t capacity() const;
+//   void initialize(int slot, float x, float y);
+//   void predict(const std::vector<int>& slots);
+//   void innovation(int slot, float& zx, float& zy, float& sxx, float& sxy, float& syy) const;
+//   void update(int slot, float zx, float zy);
+//   void position(int slot, float& x, float& y) const;
+//
+// innovation() returns the predicted measurement and its 2x2 covariance S.
+//
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "hungarian.h"
+
+struct Detection {
+    float x, y;
+};
+
+struct TrackManagerConfig {
+    float gate = 9.21f;    // Squared Mahalanobis gate (chi-square, 2 DOF, 99%)
+    int confirm_hits = 3;  // Hits needed to promote a tentative track
+    int max_misses = 5;    // Consecutive misses before a confirmed track is retired
+};
+
+enum class TrackStatus : uint8_t { Free, Tentative, Confirmed };
+
+template <typename Pool>
+class TrackManager {
+public:
+    TrackManager(Pool pool, TrackManagerConfig config = TrackManagerConfig())
+        : pool_(std::move(pool)), config_(config),
+          status_(pool_.capacity(), TrackStatus::Free), id_(pool_.capacity(), -1),
+          hits_(pool_.capacity(), 0), misses_(pool_.capacity(), 0) {
+        for (int slot = static_cast<int>(pool_.capacity()) - 1; slot >= 0; --slot) {
+            free_.push_back(slot);
+        }
+    }
+
+    // Predict all live tracks, associate the detections, update matched tracks,
+    // then create tracks for unmatched detections and retire stale ones
+    void step(const std::vector<Detection>& detections) {
+        predict();
+        associate(detections);
+        update(detections);
+    }
+
+    // The phases of step(), public so that they can be timed separately
+    void predict() { pool_.predict(live_); }
+
+    // Gated global-nearest-neighbour association of detections to the live tracks.
+    // Fills the detection -> track slot mapping; does not modify any track.
+    void associate(const std::vector<Detection>& detections) {
+        const int num_tracks = static_cast<int>(live_.size());
+        const int num_detections = static_cast<int>(detections.size());
+        detection_track_.assign(num_detections, -1);
+        if (num_tracks == 0 || num_detections == 0) return;
+
+        // Squared Mahalanobis distance for every track / detection pair
+        distance_.resize(static_cast<size_t>(num_tracks) * num_detections);
+        row_valid_.assign(num_tracks, 0);
+        col_valid_.assign(num_detections, 0);
+        for (int t = 0; t < num_tracks; ++t) {
+            float zx, zy, sxx, sxy, syy;
+            pool_.innovation(live_[t], zx, zy, sxx, sxy, syy);
+            const float inv_det = 1.0f / (sxx * syy - sxy * sxy);
+            const float ixx = syy * inv_det, ixy = -sxy * inv_det, iyy = sxx * inv_det;
+
+            float* row = &distance_[static_cast<size_t>(t) * num_detections];
+            for (int d = 0; d < num_detections; ++d) {
+                const float dx = detections[d].x - zx;
+                const float dy = detections[d].y - zy;
+                row[d] = dx * dx * ixx + 2.0f * dx * dy * ixy + dy * dy * iyy;
+                if (row[d] <= config_.gate) {
+                    row_valid_[t] = 1;
+                    col_valid_[d] = 1;
+                }
+            }
+        }
+
+        // Only tracks and detections with at least one in-gate partner enter the solver
+        rows_.clear();
+        cols_.clear();
+        for (int t = 0; t < num_tracks; ++t) if (row_valid_[t]) rows_.push_back(t);
+        for (int d = 0; d < num_detections; ++d) if (col_valid_[d]) cols_.push_back(d);
+        if (rows_.empty()) return;
+
+        const int rows = static_cast<int>(rows_.size());
+        const int cols = static_cast<int>(cols_.size());
+        const float gated_cost = 1e6f;
+        cost_.resize(static_cast<size_t>(rows) * cols);
+        for (int r = 0; r < rows; ++r) {
+            const float* row = &distance_[static_cast<size_t>(rows_[r]) * num_detections];
+            for (int c = 0; c < cols; ++c) {
+                const float d2 = row[cols_[c]];
+                cost_[static_cast<size_t>(r) * cols + c] = d2 <= config_.gate ? d2 : gated_cost;
+            }
+        }
+
+        assignment_.resize(rows);
+        solver_.solve(cost_.data(), rows, cols, assignment_.data());
+        for (int r = 0; r < rows; ++r) {
+            const int c = assignment_[r];
+            if (c < 0 || cost_[static_cast<size_t>(r) * cols + c] >= gated_cost) continue;
+            detection_track_[cols_[c]] = live_[rows_[r]];
+        }
+    }
+
+    // Track slot assigned to detection d by the last step() (new tracks included), or -1
+    int trackForDetection(size_t d) const { return detection_track_[d]; }
+
+    const std::vector<int>& liveTracks() const { return live_; }
+    TrackStatus status(int slot) const { return status_[slot]; }
+    int id(int slot) const { return id_[slot]; }
+    int hits(int slot) const { return hits_[slot]; }
+    int misses(int slot) const { return misses_[slot]; }
+    Pool& pool() { return pool_; }
+    const Pool& pool() const { return pool_; }
+
+    // Applies the association of the last associate() call to the same detections
+    void update(const std::vector<Detection>& detections) {
+        // Matched tracks take their measurement
+        for (int slot : live_) misses_[slot]++;
+        for (size_t d = 0; d < detections.size(); ++d) {
+            const int slot = detection_track_[d];
+            if (slot < 0) continue;
+            pool_.update(slot, detections[d].x, detections[d].y);
+            misses_[slot] = 0;
+            if (++hits_[slot] >= config_.confirm_hits) status_[slot] = TrackStatus::Confirmed;
+        }
+
+        // Retire tentative tracks on their first miss, confirmed tracks after max_misses
+        size_t kept = 0;
+        for (int slot : live_) {
+            const int allowed = status_[slot] == TrackStatus::Confirmed ? config_.max_misses : 0;
+            if (misses_[slot] > allowed) {
+                status_[slot] = TrackStatus::Free;
+                id_[slot] = -1;
+                free_.push_back(slot);
+            }
+            else {
+                live_[kept++] = slot;
+            }
+        }
+        live_.resize(kept);
+
+        // Unmatched detections start new tentative tracks while slots are available
+        for (size_t d = 0; d < detections.size(); ++d) {
+            if (detection_track_[d] >= 0 || free_.empty()) continue;
+            const int slot = free_.back();
+            free_.pop_back();
+            pool_.initialize(slot, detections[d].x, detections[d].y);
+            status_[slot] = TrackStatus::Tentative;
+            id_[slot] = next_id_++;
+            hits_[slot] = 1;
+            misses_[slot] = 0;
+            live_.push_back(slot);
+            detection_track_[d] = slot;
+        }
+    }
+
+private:
+    Pool pool_;
+    TrackManagerConfig config_;
+
+    std::vector<TrackStatus> status_;
+    std::vector<int> id_, hits_, misses_;
+    std::vector<int> live_, free_;
+    int next_id_ = 0;
+
+    // Association scratch buffers, reused every frame
+    HungarianSolver solver_;
+    std::vector<float> distance_, cost_;
+    std::vector<char> row_valid_, col_valid_;
+    std::vector<int> rows_, cols_, assignment_, detection_track_;
+};
@@ -9,89 +9,83 @@
 #include <iostream>
 #include <vector>
 
-// Function to compute matches using brute-force matcher
-std::vector<cv::DMatch> computeMatches(const cv::Mat& descriptors1, const cv::Mat& descriptors2) {
-    cv::BFMatcher bf(cv::NORM_HAMMING, true);
-
-    std::vector<cv::DMatch> matches;
-    bf.match(descriptors1, descriptors2, matches);
-
-    // Sort matches by distance
-    std::sort(matches.begin(), matches.end(), [](const cv::DMatch& a, const cv::DMatch& b) {
-        return a.distance < b.distance;
-        });
-
-    return matches;
-}
-
-// Function to estimate camera pose (rotation and translation)
-void findPose(const std::vector<cv::DMatch>& matches, const std::vector<cv::KeyPoint>& keypoints1, const std::vector<cv::KeyPoint>& keypoints2, const cv::Mat& K, cv::Mat& R, cv::Mat& t, cv::Mat& mask) {
-    std::vector<cv::Point2f> pts1, pts2;
-    for (const auto& match : matches) {
-        pts1.push_back(keypoints1[match.queryIdx].pt);
-        pts2.push_back(keypoints2[match.trainIdx].pt);
-    }
-
-    // Find essential matrix
-    cv::Mat E = cv::findEssentialMat(pts1, pts2, K, cv::RANSAC, 0.999, 1.0, mask);
-
-    // Recover pose (R, t)
-    cv::recoverPose(E, pts1, pts2, K, R, t, mask);
-}
+#include "featureLogCv.h"
+#include "frameSource.h"
+#include "latencyMeter.h"
+#include "pyramidFeatures.h"
+#include "tracing.h"
+#include "visualOdometry.h"
 
 // Main Visual SLAM function
-void visualSLAM(const std::string& videoPath, const cv::Mat& K) {
-    cv::VideoCapture cap;
-
-    if (videoPath == "0") {
-        cap.open(0); // Open default camera
-    }
-    else {
-        cap.open(videoPath); // Open video file
+void visualSLAM(const std::string& videoPath, const std::string& logPath, const cv::Mat& K) {
+    // Live cameras drop stale frames, video files and image directories replay every frame
+    // The decode thread also converts to grayscale and builds the ORB pyramid
+    FrameSource source;
+    source.setPyramid(PyramidConfig());
+    if (!source.open(videoPath)) {
+        std::cerr << "Error: Unable to open video." << std::endl;
+        return;
     }
+    LatencyMeter latency("orb_slam");
 
-    if (!cap.isOpened()) {
-        std::cerr << "Error: Unable to open video." << std::endl;
+    // Keypoints, descriptors and poses go to a binary log instead of the console when a
+    // log path is given, so offline tools can reuse them without re-running detection
+    FeatureLogWriter featureLog;
+    if (!logPath.empty() && !featureLog.open(logPath)) {
+        std::cerr << "Error: Unable to create " << logPath << std::endl;
         return;
     }
+    std::vector<LogKeypoint> logKeypoints;
 
-    // Create an ORB detector
-    cv::Ptr<cv::ORB> orb = cv::ORB::create();
+    // Create an ORB detector, run on the shared pyramid
+    const int max_features = 500;
+    cv::Ptr<cv::ORB> orb = cv::ORB::create(max_features);
 
     cv::Mat prevFrame, prevDescriptors;
     std::vector<cv::KeyPoint> prevKeypoints;
 
     while (true) {
-        cv::Mat frame;
-        cap >> frame;
-        if (frame.empty()) {
+        Frame captured;
+        if (!source.read(captured)) {
             break;
         }
-
-        cv::Mat gray;
-        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+        cv::Mat& frame = captured.image;
+        TRACE_SCOPE("frame");
 
         // Detect ORB keypoints and descriptors
         std::vector<cv::KeyPoint> keypoints;
         cv::Mat descriptors;
-        orb->detectAndCompute(gray, cv::noArray(), keypoints, descriptors);
+        {
+            TRACE_SCOPE("detectAndCompute");
+            detectOrbOnPyramid(*orb, *captured.pyramid, max_features, keypoints, descriptors);
+        }
+        TRACE_COUNTER("keypoints", keypoints.size());
 
+        cv::Mat R, t;
         if (!prevFrame.empty()) {
             // Match features with the previous frame
             std::vector<cv::DMatch> matches = computeMatches(prevDescriptors, descriptors);
+            TRACE_COUNTER("matches", matches.size());
 
             // Estimate pose
-            cv::Mat R, t, mask;
+            cv::Mat mask;
             findPose(matches, prevKeypoints, keypoints, K, R, t, mask);
 
             // Display matches
+            TRACE_SCOPE("display");
             cv::Mat matchImg;
             cv::drawMatches(prevFrame, prevKeypoints, frame, keypoints, matches, matchImg, cv::Scalar::all(-1), cv::Scalar::all(-1), std::vector<char>(), cv::DrawMatchesFlags::NOT_DRAW_SINGLE_POINTS);
             cv::imshow("Feature Matches", matchImg);
 
-            std::cout << "Rotation Matrix:\n" << R << std::endl;
-            std::cout << "Translation Vector:\n" << t << std::endl;
+            if (!featureLog.isOpen()) {
+                std::cout << "Rotation Matrix:\n" << R << std::endl;
+                std::cout << "Translation Vector:\n" << t << std::endl;
+            }
         }
+        if (featureLog.isOpen()) {
+            appendFeatureLog(featureLog, captured, keypoints, descriptors, R, t, logKeypoints);
+        }
+        latency.addSince(captured.capture_time);
 
         prevFrame = frame.clone();
         prevKeypoints = keypoints;
@@ -102,18 +96,33 @@ void visualSLAM(const std::string& videoPath, const cv::Mat& K) {
         }
     }
 
-    cap.release();
+    std::cout << "Dropped frames: " << source.droppedFrames() << std::endl;
+    if (featureLog.isOpen()) {
+        const uint64_t frames = featureLog.frames();
+        if (featureLog.close()) {
+            std::cout << "Feature log: " << frames << " frames written to " << logPath << std::endl;
+        }
+        else {
+            std::cerr << "Error: Writing " << logPath << " failed" << std::endl;
+        }
+    }
+    source.close();
     cv::destroyAllWindows();
 }
 
-int main() {
+int main(int argc, char** argv) {
     // Camera intrinsic parameters (example values)
     cv::Mat K = (cv::Mat_<double>(3, 3) << 718.856, 0, 607.1928, 0, 718.856, 185.2157, 0, 0, 1);
 
-    // Path to video or live camera feed (use "0" for default camera)
-    std::string videoPath = "0"; // Replace with your video path or "0" for live feed
+    // Camera index, video file or image directory (use "0" for default camera), then an
+    // optional feature log path
+    std::string videoPath = argc > 1 ? argv[1] : "0";
+    std::string logPath = argc > 2 ? argv[2] : "";
+
+    // Per-stage timings, enabled with PERCEPTION_TRACE
+    trace::Session tracing("orb_slam");
 
-    visualSLAM(videoPath, K);
+    visualSLAM(videoPath, logPath, K);
 
     return 0;
 }
@@ -0,0 +1,158 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// faceEnrollment.cpp : Background reference-face enrollment with quality gating.
+//
+#include "faceEnrollment.h"
+#include "tracing.h"
+
+#include <opencv2/imgproc.hpp>
+#include <dlib/opencv.h>
+
+#include <algorithm>
+#include <cmath>
+
+FaceQuality assessFaceQuality(const cv::Mat& gray, const dlib::rectangle& face,
+    const dlib::full_object_detection& shape, const EnrollmentConfig& config) {
+    FaceQuality quality;
+    quality.size = static_cast<double>(face.width());
+
+    // Sharpness: variance of the Laplacian inside the face box
+    cv::Rect roi = cv::Rect(face.left(), face.top(), face.width(), face.height()) & cv::Rect(0, 0, gray.cols, gray.rows);
+    if (roi.area() > 0) {
+        cv::Mat laplacian;
+        cv::Laplacian(gray(roi), laplacian, CV_32F);
+        cv::Scalar mean, stddev;
+        cv::meanStdDev(laplacian, mean, stddev);
+        quality.sharpness = stddev[0] * stddev[0];
+    }
+
+    // Pose from the 68-point landmarks: outer eye corners (36, 45) and nose tip (30)
+    if (shape.num_parts() == 68) {
+        const dlib::point left_eye = shape.part(36), right_eye = shape.part(45), nose = shape.part(30);
+        const double ex = right_eye.x() - left_eye.x();
+        const double ey = right_eye.y() - left_eye.y();
+        const double eye_distance = std::sqrt(ex * ex + ey * ey);
+        if (eye_distance > 0.0) {
+            const double mx = 0.5 * (left_eye.x() + right_eye.x());
+            const double my = 0.5 * (left_eye.y() + right_eye.y());
+            // Offset of the nose along the eye axis approximates yaw
+            quality.yaw = ((nose.x() - mx) * ex + (nose.y() - my) * ey) / (eye_distance * eye_distance);
+            quality.roll_deg = std::atan2(ey, ex) * 180.0 / CV_PI;
+        }
+    }
+    else {
+        quality.yaw = config.max_yaw;
+    }
+
+    quality.accepted = quality.size >= config.min_face_size && quality.sharpness >= config.min_sharpness &&
+        std::fabs(quality.yaw) < config.max_yaw && std::fabs(quality.roll_deg) < config.max_roll_deg;
+    if (quality.accepted) {
+        quality.score = std::min(quality.sharpness / config.min_sharpness, 3.0) *
+            std::min(quality.size / config.min_face_size, 2.0) *
+            (1.0 - std::fabs(quality.yaw) / config.max_yaw) *
+            (1.0 - std::fabs(quality.roll_deg) / config.max_roll_deg);
+    }
+    return quality;
+}
+
+FaceEnrollment::FaceEnrollment(std::shared_ptr<FaceModels> models, EnrollmentConfig config)
+    : models_(std::move(models)), config_(config), net_(*models_) {
+    config_.samples = std::max<size_t>(config_.samples, 1);
+    config_.candidates = std::max(config_.candidates, config_.samples);
+    worker_ = std::thread(&FaceEnrollment::run, this);
+}
+
+FaceEnrollment::~FaceEnrollment() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    worker_.join();
+}
+
+void FaceEnrollment::submit(const cv::Mat& frame, const std::vector<dlib::rectangle>& faces) {
+    if (faces.empty() || complete_.load() || busy_.load()) return;
+
+    auto largest = std::max_element(faces.begin(), faces.end(),
+        [](const dlib::rectangle& a, const dlib::rectangle& b) { return a.area() < b.area(); });
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (has_pending_) return;
+        pending_frame_ = frame.clone();
+        pending_face_ = *largest;
+        has_pending_ = true;
+        busy_ = true;
+    }
+    wake_.notify_one();
+}
+
+std::shared_ptr<const FaceEmbedding> FaceEnrollment::reference() const {
+    return std::atomic_load(&reference_);
+}
+
+void FaceEnrollment::run() {
+    trace::setThreadName("enrollment");
+    while (true) {
+        cv::Mat frame;
+        dlib::rectangle face;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stop_ || has_pending_; });
+            if (stop_) return;
+            frame = pending_frame_;
+            face = pending_face_;
+            has_pending_ = false;
+        }
+        process(frame, face);
+        busy_ = false;
+    }
+}
+
+void FaceEnrollment::process(const cv::Mat& frame, const dlib::rectangle& face) {
+    TRACE_SCOPE("enrollment.process");
+    dlib::cv_image<dlib::bgr_pixel> dlib_frame(frame);
+    dlib::full_object_detection shape = models_->shape_predictor(dlib_frame, face);
+
+    cv::Mat gray;
+    cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+    FaceQuality quality = assessFaceQuality(gray, face, shape, config_);
+    if (!quality.accepted) return;
+
+    // Keep the aligned chip only; the ResNet runs once per selected sample in publish()
+    Candidate candidate;
+    candidate.score = quality.score;
+    dlib::extract_image_chip(dlib_frame, dlib::get_face_chip_details(shape, 150, 0.25), candidate.chip);
+    candidates_.push_back(std::move(candidate));
+    accepted_ = candidates_.size();
+
+    if (candidates_.size() >= config_.candidates) {
+        publish();
+    }
+}
+
+void FaceEnrollment::publish() {
+    std::sort(candidates_.begin(), candidates_.end(),
+        [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+    std::vector<dlib::matrix<dlib::rgb_pixel>> chips;
+    for (size_t i = 0; i < config_.samples; ++i) {
+        chips.push_back(std::move(candidates_[i].chip));
+    }
+    std::vector<FaceEmbedding> embeddings;
+    {
+        TRACE_SCOPE("enrollment.resnet");
+        embeddings = net_(chips);
+    }
+
+    auto reference = std::make_shared<FaceEmbedding>(embeddings[0]);
+    for (size_t i = 1; i < embeddings.size(); ++i) {
+        *reference += embeddings[i];
+    }
+    *reference /= static_cast<float>(embeddings.size());
+
+    std::atomic_store(&reference_, std::shared_ptr<const FaceEmbedding>(reference));
+    candidates_.clear();
+    complete_ = true;
+}
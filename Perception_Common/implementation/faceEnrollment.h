@@ -0,0 +1,92 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// faceEnrollment.h : Background reference-face enrollment with quality gating.
+//
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <dlib/image_processing.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "faceModels.h"
+
+using FaceEmbedding = dlib::matrix<float, 0, 1>;
+
+struct EnrollmentConfig {
+    size_t samples = 5;          // Embeddings averaged into the reference
+    size_t candidates = 15;      // Accepted chips considered before picking the best samples
+    double min_face_size = 80.0; // Face box width in pixels
+    double min_sharpness = 60.0; // Variance of the Laplacian over the face region
+    double max_yaw = 0.2;        // Nose offset from the eye midpoint, in eye distances
+    double max_roll_deg = 15.0;  // Tilt of the eye line
+};
+
+struct FaceQuality {
+    double size = 0.0;
+    double sharpness = 0.0;
+    double yaw = 0.0;
+    double roll_deg = 0.0;
+    double score = 0.0; // Higher is better, 0 when rejected
+    bool accepted = false;
+};
+
+// Score a detected face for blur, pose and size. gray is the full grayscale frame.
+FaceQuality assessFaceQuality(const cv::Mat& gray, const dlib::rectangle& face,
+    const dlib::full_object_detection& shape, const EnrollmentConfig& config);
+
+// Collects reference chips on a worker thread while the caller keeps tracking. Frames
+// offered while the worker is busy are skipped, so submit() never blocks on the ResNet.
+// Once enough good chips are seen, the embeddings of the best ones are averaged and the
+// reference is published atomically.
+class FaceEnrollment {
+public:
+    FaceEnrollment(std::shared_ptr<FaceModels> models, EnrollmentConfig config = EnrollmentConfig());
+    ~FaceEnrollment();
+
+    FaceEnrollment(const FaceEnrollment&) = delete;
+    FaceEnrollment& operator=(const FaceEnrollment&) = delete;
+
+    // Offer a frame and its detections (the largest face is enrolled). Returns immediately.
+    void submit(const cv::Mat& frame, const std::vector<dlib::rectangle>& faces);
+
+    // Published reference embedding, or nullptr while enrollment is running
+    std::shared_ptr<const FaceEmbedding> reference() const;
+
+    bool complete() const { return complete_.load(); }
+    size_t acceptedChips() const { return accepted_.load(); }
+
+private:
+    struct Candidate {
+        double score;
+        dlib::matrix<dlib::rgb_pixel> chip;
+    };
+
+    void run();
+    void process(const cv::Mat& frame, const dlib::rectangle& face);
+    void publish();
+
+    std::shared_ptr<FaceModels> models_;
+    EnrollmentConfig config_;
+    FaceEncoder net_; // Private copy: the networks are not safe to run from two threads
+
+    std::vector<Candidate> candidates_;
+    std::shared_ptr<const FaceEmbedding> reference_; // Accessed with std::atomic_load / atomic_store
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    cv::Mat pending_frame_;
+    dlib::rectangle pending_face_;
+    bool has_pending_ = false;
+    bool stop_ = false;
+    std::atomic<bool> busy_{ false };
+    std::atomic<bool> complete_{ false };
+    std::atomic<size_t> accepted_{ 0 };
+    std::thread worker_;
+};
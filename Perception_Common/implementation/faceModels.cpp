@@ -0,0 +1,362 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// faceModels.cpp : Background loading and memory-mapped cache for the dlib face models.
+//
+// Cache layout (all offsets are absolute, little endian, native float):
+//
+//   CacheHeader
+//   shape_predictor      dlib serialization
+//   ResNet weights       packFaceNetFloat() floats, 64-byte aligned
+//
+// The shape predictor is deserialized into the process. The ResNet is not restored into
+// dlib at all: FaceNetFloat runs on the weights inside the mapping, so every process
+// mapping the cache uses the same page cache pages.
+//
+#include "faceModels.h"
+#include "mappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+#include <vector>
+
+namespace {
+
+const char kCacheMagic[8] = { 'D', 'W', 'F', 'A', 'C', 'E', 'M', 'C' };
+const uint32_t kCacheVersion = 2;
+const uint64_t kWeightAlignment = 64;
+
+// Largest descriptor element difference accepted between FaceNetFloat and dlib before a
+// cache is written (faceNetBenchmark uses the same bound)
+const float kFloatTolerance = 1e-3f;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t shape_source_size;
+    int64_t shape_source_time;
+    uint64_t net_source_size;
+    int64_t net_source_time;
+    uint64_t shape_offset, shape_bytes;
+    uint64_t net_offset, net_floats;
+};
+
+// Visits the layers from the top of the net down: every affine layer is seen right before
+// the convolution it follows, so it is folded into that convolution. Collects the fc
+// weights and the folded convolutions, top first.
+struct FaceNetCollector {
+    std::vector<FaceNetConv> convs;
+    std::vector<float> fc;
+    std::vector<float> gamma, beta;
+    bool valid = true;
+
+    void operator()(dlib::affine_& layer) {
+        auto gamma_tensor = layer.get_gamma();
+        auto beta_tensor = layer.get_beta();
+        gamma.assign(gamma_tensor.host(), gamma_tensor.host() + gamma_tensor.size());
+        beta.assign(beta_tensor.host(), beta_tensor.host() + beta_tensor.size());
+    }
+
+    template <long nf, long nr, long nc, int sy, int sx, int py, int px>
+    void operator()(dlib::con_<nf, nr, nc, sy, sx, py, px>& layer) {
+        const dlib::tensor& params = layer.get_layer_params();
+        const size_t filter = static_cast<size_t>(nf) * nr * nc;
+        const size_t inputs = params.size() / filter;
+        if (gamma.size() != static_cast<size_t>(nf) || beta.size() != gamma.size() || nr != nc) {
+            valid = false;
+            return;
+        }
+
+        // dlib filters are [nf][inputs][nr][nc], followed by the biases if the layer has them
+        const float* p = params.host();
+        const bool has_bias = params.size() > filter * inputs;
+        FaceNetConv conv;
+        conv.inputs = static_cast<int>(inputs);
+        conv.outputs = static_cast<int>(nf);
+        conv.kernel = static_cast<int>(nr);
+        conv.stride = sy;
+        conv.weights.resize(filter * inputs);
+        conv.bias.resize(nf);
+        for (long o = 0; o < nf; ++o) {
+            for (long ky = 0; ky < nr; ++ky)
+                for (long kx = 0; kx < nc; ++kx)
+                    for (size_t i = 0; i < inputs; ++i)
+                        conv.weights[((o * nr + ky) * nc + kx) * inputs + i] = gamma[o] * p[((o * inputs + i) * nr + ky) * nc + kx];
+            conv.bias[o] = gamma[o] * (has_bias ? p[filter * inputs + o] : 0.0f) + beta[o];
+        }
+        gamma.clear();
+        beta.clear();
+        convs.push_back(std::move(conv));
+    }
+
+    template <unsigned long outputs>
+    void operator()(dlib::fc_<outputs, dlib::FC_NO_BIAS>& layer) {
+        const dlib::tensor& params = layer.get_layer_params();
+        fc.assign(params.host(), params.host() + params.size());
+    }
+
+    template <typename Layer>
+    void operator()(Layer&) {}
+};
+
+// Size and modification time identify the .dat file a cache was built from
+bool sourceStamp(const std::string& path, uint64_t& size, int64_t& time) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    auto write_time = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    time = static_cast<int64_t>(write_time.time_since_epoch().count());
+    return true;
+}
+
+// Read-only std::streambuf over a memory range, so dlib can deserialize in place
+class MemoryStreamBuf : public std::streambuf {
+public:
+    MemoryStreamBuf(const char* data, size_t size) {
+        char* begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+};
+
+void writePadding(std::ofstream& out, uint64_t alignment) {
+    static const char zeros[kWeightAlignment] = {};
+    uint64_t position = static_cast<uint64_t>(out.tellp());
+    uint64_t padding = (alignment - position % alignment) % alignment;
+    out.write(zeros, static_cast<std::streamsize>(padding));
+}
+
+} // namespace
+
+bool writeFaceModelCache(const FaceModels& models, const std::string& shape_predictor_path,
+    const std::string& face_recognizer_path, const std::string& cache_path) {
+    CacheHeader header = {};
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.version = kCacheVersion;
+    if (!sourceStamp(shape_predictor_path, header.shape_source_size, header.shape_source_time) ||
+        !sourceStamp(face_recognizer_path, header.net_source_size, header.net_source_time)) {
+        return false;
+    }
+
+    // The cached network replaces dlib's, so it has to give the same descriptors
+    std::vector<float> packed;
+    if (models.cached_net) {
+        packed = packFaceNetFloat(models.cached_net->weights());
+    }
+    else {
+        anet_type net = models.face_recognizer;
+        FaceNetWeights weights;
+        if (!extractFaceNetWeights(net, weights)) return false;
+        dlib::matrix<dlib::rgb_pixel> chip(kFaceChipSize, kFaceChipSize);
+        for (long r = 0; r < chip.nr(); ++r)
+            for (long c = 0; c < chip.nc(); ++c)
+                chip(r, c) = dlib::rgb_pixel(static_cast<unsigned char>(r + c), static_cast<unsigned char>(2 * r),
+                    static_cast<unsigned char>(255 - c));
+        std::vector<uint8_t> rgb(static_cast<size_t>(kFaceChipSize) * kFaceChipSize * 3);
+        faceChipBytes(chip, rgb.data());
+        dlib::matrix<float, 0, 1> expected = net(chip), descriptor(kFaceDescriptorSize);
+        FaceNetFloat(weights).embed(rgb.data(), &descriptor(0));
+        if (dlib::max(dlib::abs(descriptor - expected)) > kFloatTolerance) return false;
+        packed = packFaceNetFloat(weights);
+    }
+
+    const std::string tmp_path = cache_path + ".tmp";
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    header.shape_offset = static_cast<uint64_t>(out.tellp());
+    dlib::serialize(models.shape_predictor, out);
+    header.shape_bytes = static_cast<uint64_t>(out.tellp()) - header.shape_offset;
+
+    writePadding(out, kWeightAlignment);
+    header.net_offset = static_cast<uint64_t>(out.tellp());
+    header.net_floats = packed.size();
+    out.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size() * sizeof(float)));
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) return false;
+
+    // Publish atomically so concurrent readers never see a partial cache
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, cache_path, ec);
+    return !ec;
+}
+
+namespace {
+
+// Maps the cache and checks it against the .dat files. Returns nullptr if the cache is
+// missing, corrupt or stale.
+std::shared_ptr<const MappedFile> openFaceModelCache(const std::string& shape_predictor_path,
+    const std::string& face_recognizer_path, const std::string& cache_path, CacheHeader& header) {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(cache_path) || file->size() < sizeof(CacheHeader)) return nullptr;
+
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || header.version != kCacheVersion) {
+        return nullptr;
+    }
+
+    // Rebuild the cache whenever the source models change
+    uint64_t shape_size, net_size;
+    int64_t shape_time, net_time;
+    if (!sourceStamp(shape_predictor_path, shape_size, shape_time) ||
+        !sourceStamp(face_recognizer_path, net_size, net_time) ||
+        shape_size != header.shape_source_size || shape_time != header.shape_source_time ||
+        net_size != header.net_source_size || net_time != header.net_source_time) {
+        return nullptr;
+    }
+
+    if (header.shape_offset + header.shape_bytes > file->size() || header.net_floats != faceNetFloatPackedSize() ||
+        header.net_offset % kWeightAlignment != 0 || header.net_offset + header.net_floats * sizeof(float) > file->size()) {
+        return nullptr;
+    }
+    return file;
+}
+
+// Runs the ResNet of models from the mapped cache and drops dlib's copy of it
+void attachCachedNet(FaceModels& models, std::shared_ptr<const MappedFile> file, const CacheHeader& header) {
+    const float* packed = reinterpret_cast<const float*>(file->data() + header.net_offset);
+    models.cached_net = std::make_shared<const FaceNetFloat>(packed, std::move(file));
+    models.face_recognizer = anet_type();
+    models.from_cache = true;
+}
+
+} // namespace
+
+std::shared_ptr<FaceModels> readFaceModelCache(const std::string& shape_predictor_path,
+    const std::string& face_recognizer_path, const std::string& cache_path) {
+    CacheHeader header;
+    std::shared_ptr<const MappedFile> file = openFaceModelCache(shape_predictor_path, face_recognizer_path, cache_path, header);
+    if (!file) return nullptr;
+
+    auto models = std::make_shared<FaceModels>();
+    try {
+        MemoryStreamBuf shape_buf(file->data() + header.shape_offset, header.shape_bytes);
+        std::istream shape_in(&shape_buf);
+        dlib::deserialize(models->shape_predictor, shape_in);
+    }
+    catch (const dlib::serialization_error&) {
+        return nullptr;
+    }
+
+    models->face_detector = dlib::get_frontal_face_detector();
+    attachCachedNet(*models, std::move(file), header);
+    return models;
+}
+
+std::shared_ptr<FaceModels> loadFaceModels(const std::string& shape_predictor_path,
+    const std::string& face_recognizer_path, const std::string& cache_path) {
+    if (!cache_path.empty()) {
+        if (auto cached = readFaceModelCache(shape_predictor_path, face_recognizer_path, cache_path)) {
+            return cached;
+        }
+    }
+
+    auto models = std::make_shared<FaceModels>();
+    models->face_detector = dlib::get_frontal_face_detector();
+    dlib::deserialize(shape_predictor_path) >> models->shape_predictor;
+    dlib::deserialize(face_recognizer_path) >> models->face_recognizer;
+
+    if (!cache_path.empty()) {
+        // Switch to the cached ResNet right away, so the first process shares it too
+        CacheHeader header;
+        std::shared_ptr<const MappedFile> file;
+        if (writeFaceModelCache(*models, shape_predictor_path, face_recognizer_path, cache_path)) {
+            file = openFaceModelCache(shape_predictor_path, face_recognizer_path, cache_path, header);
+        }
+        if (file) attachCachedNet(*models, std::move(file), header);
+        else std::cerr << "Warning: Could not write model cache " << cache_path << std::endl;
+    }
+    return models;
+}
+
+FaceModelLoader::FaceModelLoader(const std::string& shape_predictor_path, const std::string& face_recognizer_path,
+    const std::string& cache_path)
+    : future_(std::async(std::launch::async, loadFaceModels, shape_predictor_path, face_recognizer_path,
+        cache_path).share()) {
+}
+
+bool FaceModelLoader::ready() const {
+    return future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+std::shared_ptr<FaceModels> FaceModelLoader::get() const {
+    return future_.get();
+}
+
+bool extractFaceNetWeights(anet_type& net, FaceNetWeights& weights) {
+    FaceNetCollector collector;
+    dlib::visit_computational_layers(net, collector);
+    if (!collector.valid || collector.convs.empty()) return false;
+
+    std::reverse(collector.convs.begin(), collector.convs.end());
+    FaceNetWeights result = FaceNetWeights::shapes();
+    if (collector.convs.size() != 1 + 2 * result.blocks.size()) return false;
+    result.stem = collector.convs[0];
+    for (size_t i = 0; i < result.blocks.size(); ++i) {
+        result.blocks[i].conv1 = collector.convs[1 + 2 * i];
+        result.blocks[i].conv2 = collector.convs[2 + 2 * i];
+    }
+    result.fc = collector.fc;
+    if (!result.valid()) return false;
+    weights = std::move(result);
+    return true;
+}
+
+void faceChipBytes(const dlib::matrix<dlib::rgb_pixel>& chip, uint8_t* rgb) {
+    for (long r = 0; r < chip.nr(); ++r) {
+        for (long c = 0; c < chip.nc(); ++c, rgb += 3) {
+            const dlib::rgb_pixel& pixel = chip(r, c);
+            rgb[0] = pixel.red;
+            rgb[1] = pixel.green;
+            rgb[2] = pixel.blue;
+        }
+    }
+}
+
+dlib::matrix<float, 0, 1> quantizedDescriptor(QuantizedFaceNet& net, const dlib::matrix<dlib::rgb_pixel>& chip) {
+    std::vector<uint8_t> rgb(static_cast<size_t>(kFaceChipSize) * kFaceChipSize * 3);
+    faceChipBytes(chip, rgb.data());
+    dlib::matrix<float, 0, 1> descriptor(kFaceDescriptorSize);
+    net.embed(rgb.data(), &descriptor(0));
+    return descriptor;
+}
+
+bool faceNetWeights(FaceModels& models, FaceNetWeights& weights) {
+    if (models.cached_net) {
+        weights = models.cached_net->weights();
+        return true;
+    }
+    return extractFaceNetWeights(models.face_recognizer, weights);
+}
+
+FaceEncoder::FaceEncoder(const FaceModels& models)
+    : rgb_(static_cast<size_t>(kFaceChipSize) * kFaceChipSize * 3) {
+    if (models.cached_net) cached_net_.emplace(*models.cached_net);
+    else net_ = models.face_recognizer;
+}
+
+dlib::matrix<float, 0, 1> FaceEncoder::operator()(const dlib::matrix<dlib::rgb_pixel>& chip) {
+    if (!cached_net_) return net_(chip);
+    faceChipBytes(chip, rgb_.data());
+    dlib::matrix<float, 0, 1> descriptor(kFaceDescriptorSize);
+    cached_net_->embed(rgb_.data(), &descriptor(0));
+    return descriptor;
+}
+
+std::vector<dlib::matrix<float, 0, 1>> FaceEncoder::operator()(const std::vector<dlib::matrix<dlib::rgb_pixel>>& chips) {
+    if (!cached_net_) return net_(chips);
+    std::vector<dlib::matrix<float, 0, 1>> descriptors;
+    for (const auto& chip : chips) descriptors.push_back((*this)(chip));
+    return descriptors;
+}
@@ -0,0 +1,122 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// faceModels.h : dlib face models shared by the face programs, with background loading
+// and a memory-mapped model cache.
+//
+#pragma once
+
+#include <dlib/dnn.h>
+#include <dlib/image_processing.h>
+#include <dlib/image_processing/frontal_face_detector.h>
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "quantizedFaceNet.h"
+
+// Alias for dlib's face recognition model
+template <template <int, template<typename> class, int, typename> class block, int N, template<typename> class BN, typename SUBNET>
+using residual = dlib::add_prev1<block<N, BN, 1, dlib::tag1<SUBNET>>>;
+
+template <template <int, template<typename> class, int, typename> class block, int N, template<typename> class BN, typename SUBNET>
+using residual_down = dlib::add_prev2<dlib::avg_pool<2, 2, 2, 2, dlib::skip1<dlib::tag2<block<N, BN, 2, dlib::tag1<SUBNET>>>>>>;
+
+template <int N, template <typename> class BN, int stride, typename SUBNET>
+using block = BN<dlib::con<N, 3, 3, 1, 1, dlib::relu<BN<dlib::con<N, 3, 3, stride, stride, SUBNET>>>>>;
+
+template <int N, typename SUBNET> using ares = dlib::relu<residual<block, N, dlib::affine, SUBNET>>;
+template <int N, typename SUBNET> using ares_down = dlib::relu<residual_down<block, N, dlib::affine, SUBNET>>;
+
+template <typename SUBNET> using alevel0 = ares_down<256, SUBNET>;
+template <typename SUBNET> using alevel1 = ares<256, ares<256, ares_down<256, SUBNET>>>;
+template <typename SUBNET> using alevel2 = ares<128, ares<128, ares_down<128, SUBNET>>>;
+template <typename SUBNET> using alevel3 = ares<64, ares<64, ares<64, ares_down<64, SUBNET>>>>;
+template <typename SUBNET> using alevel4 = ares<32, ares<32, ares<32, SUBNET>>>;
+
+using anet_type = dlib::loss_metric<dlib::fc_no_bias<128, dlib::avg_pool_everything<
+    alevel0<
+    alevel1<
+    alevel2<
+    alevel3<
+    alevel4<
+    dlib::max_pool<3, 3, 2, 2, dlib::relu<dlib::affine<dlib::con<32, 7, 7, 2, 2,
+    dlib::input_rgb_image_sized<150> >>>>>>>>>>>>;
+
+// The ResNet is either dlib's network deserialized from the .dat file, or cached_net on the
+// weights in the mapped cache, in which case face_recognizer is left empty. Use
+// FaceEncoder to run whichever is loaded.
+struct FaceModels {
+    dlib::frontal_face_detector face_detector;
+    dlib::shape_predictor shape_predictor;
+    anet_type face_recognizer;
+    std::shared_ptr<const FaceNetFloat> cached_net;
+    bool from_cache = false;
+};
+
+// Load the detector, landmark predictor and ResNet. When cache_path is not empty the
+// models are read from the cache if it matches the .dat files, otherwise the .dat files
+// are deserialized and the cache is (re)written. Throws dlib::serialization_error if the
+// .dat files cannot be read. With the cache the ResNet runs on the mapped weights, which
+// all processes share; the shape predictor is still deserialized into every process.
+std::shared_ptr<FaceModels> loadFaceModels(const std::string& shape_predictor_path,
+    const std::string& face_recognizer_path, const std::string& cache_path);
+
+// Write the cache file for already loaded models. Returns false on I/O failure, or if
+// FaceNetFloat does not reproduce dlib's descriptors on a test chip.
+bool writeFaceModelCache(const FaceModels& models, const std::string& shape_predictor_path,
+    const std::string& face_recognizer_path, const std::string& cache_path);
+
+// Read models from the cache. Returns nullptr if the cache is missing, corrupt or stale.
+std::shared_ptr<FaceModels> readFaceModelCache(const std::string& shape_predictor_path,
+    const std::string& face_recognizer_path, const std::string& cache_path);
+
+// Copy the ResNet weights of loaded models into the layout of quantizedFaceNet.h
+bool faceNetWeights(FaceModels& models, FaceNetWeights& weights);
+
+// Copy the ResNet weights into the layout of quantizedFaceNet.h, with every affine layer
+// folded into the convolution before it. Returns false if the net does not have the
+// shapes of anet_type.
+bool extractFaceNetWeights(anet_type& net, FaceNetWeights& weights);
+
+// Interleaved RGB bytes of a 150x150 face chip, the input of FaceNetFloat and QuantizedFaceNet
+void faceChipBytes(const dlib::matrix<dlib::rgb_pixel>& chip, uint8_t* rgb);
+
+// Descriptor of a 150x150 chip from the int8 network, comparable with the ResNet output
+dlib::matrix<float, 0, 1> quantizedDescriptor(QuantizedFaceNet& net, const dlib::matrix<dlib::rgb_pixel>& chip);
+
+// Face descriptors from the ResNet of loaded models, dlib's network or the cached one.
+// Not thread-safe: use one copy per thread. Copies of a cached network share its weights.
+class FaceEncoder {
+public:
+    explicit FaceEncoder(const FaceModels& models);
+
+    dlib::matrix<float, 0, 1> operator()(const dlib::matrix<dlib::rgb_pixel>& chip);
+    std::vector<dlib::matrix<float, 0, 1>> operator()(const std::vector<dlib::matrix<dlib::rgb_pixel>>& chips);
+
+private:
+    anet_type net_;
+    std::optional<FaceNetFloat> cached_net_;
+    std::vector<uint8_t> rgb_;
+};
+
+// Runs loadFaceModels() on a background thread so the caller can open and warm up the
+// camera in the meantime.
+class FaceModelLoader {
+public:
+    FaceModelLoader(const std::string& shape_predictor_path, const std::string& face_recognizer_path,
+        const std::string& cache_path = "");
+
+    // True once loading has finished (successfully or not)
+    bool ready() const;
+
+    // Wait for the models; rethrows any loading error
+    std::shared_ptr<FaceModels> get() const;
+
+private:
+    std::shared_future<std::shared_ptr<FaceModels>> future_;
+};
@@ -0,0 +1,248 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// faceNetBenchmark.cpp : Throughput and verification accuracy of the int8 face ResNet
+// (quantizedFaceNet.h) against dlib's float network (anet_type) on a labeled pair list:
+//
+//   faceNetBenchmark pairs.txt [--calibration n] [--scales scales.txt] [shape_predictor.dat] [resnet.dat]
+//
+// Each line of pairs.txt is "<image> <image> <1 if same person, else 0>" (LFW style).
+// The first n images (default 64) calibrate the activation scales and every pair that
+// uses one of them is left out of the evaluation. --scales writes the calibrated scales
+// for faceStreamServer --int8.
+//
+#include <opencv2/opencv.hpp>
+#include <dlib/opencv.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "faceModels.h"
+#include "quantizedFaceNet.h"
+
+namespace {
+
+// Largest descriptor element difference accepted between FaceNetFloat and dlib
+const double kFloatTolerance = 1e-3;
+
+struct Pair {
+    int a, b;
+    bool same;
+};
+
+struct Verification {
+    double accuracy = 0.0;      // At the 0.6 threshold used by the face programs
+    double best_accuracy = 0.0;
+    double best_threshold = 0.0;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+Verification verify(const std::vector<Pair>& pairs, const std::vector<dlib::matrix<float, 0, 1>>& descriptors) {
+    std::vector<std::pair<double, bool>> scored;
+    for (const Pair& pair : pairs) scored.push_back({ dlib::length(descriptors[pair.a] - descriptors[pair.b]), pair.same });
+    std::sort(scored.begin(), scored.end());
+
+    Verification result;
+    size_t correct = 0;
+    for (const auto& s : scored) correct += (s.first < 0.6) == s.second;
+    result.accuracy = static_cast<double>(correct) / scored.size();
+
+    // Sweep the threshold: below it every pair is "same"
+    size_t different = 0;
+    for (const auto& s : scored) different += !s.second;
+    size_t same_below = 0, different_below = 0;
+    for (size_t i = 0; i <= scored.size(); ++i) {
+        const double accuracy = static_cast<double>(same_below + different - different_below) / scored.size();
+        if (accuracy > result.best_accuracy) {
+            result.best_accuracy = accuracy;
+            result.best_threshold = i < scored.size() ? scored[i].first : scored.back().first + 1e-6;
+        }
+        if (i < scored.size()) {
+            if (scored[i].second) same_below++;
+            else different_below++;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string pairs_path, scales_path;
+    int calibration_count = 64;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--calibration") == 0 && i + 1 < argc) calibration_count = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--scales") == 0 && i + 1 < argc) scales_path = argv[++i];
+        else paths.push_back(argv[i]);
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " pairs.txt [--calibration n] [--scales scales.txt] [shape_predictor.dat] [resnet.dat]" << std::endl;
+        return -1;
+    }
+    pairs_path = paths[0];
+    const std::string shape_path = paths.size() > 1 ? paths[1] : "shape_predictor_68_face_landmarks.dat";
+    const std::string net_path = paths.size() > 2 ? paths[2] : "dlib_face_recognition_resnet_model_v1.dat";
+
+    std::shared_ptr<FaceModels> models;
+    try {
+        models = loadFaceModels(shape_path, net_path, "");
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: Unable to load the face models: " << e.what() << std::endl;
+        return -1;
+    }
+    FaceNetWeights weights;
+    if (!extractFaceNetWeights(models->face_recognizer, weights)) {
+        std::cerr << "Error: " << net_path << " does not have the layout of anet_type" << std::endl;
+        return -1;
+    }
+
+    // Pair list; every image is read and aligned once
+    std::ifstream in(pairs_path);
+    if (!in) {
+        std::cerr << "Error: Unable to read " << pairs_path << std::endl;
+        return -1;
+    }
+    std::map<std::string, int> image_index;
+    std::vector<std::string> images;
+    std::vector<Pair> all_pairs;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string a, b;
+        int same = 0;
+        if (!(fields >> a) || a[0] == '#') continue;
+        if (!(fields >> b >> same)) {
+            std::cerr << "Error: Malformed line in " << pairs_path << ": " << line << std::endl;
+            return -1;
+        }
+        for (const std::string* name : { &a, &b }) {
+            if (image_index.emplace(*name, static_cast<int>(images.size())).second) images.push_back(*name);
+        }
+        all_pairs.push_back({ image_index[a], image_index[b], same != 0 });
+    }
+
+    std::vector<dlib::matrix<dlib::rgb_pixel>> chips(images.size());
+    std::vector<bool> has_face(images.size(), false);
+    for (size_t i = 0; i < images.size(); ++i) {
+        cv::Mat image = cv::imread(images[i], cv::IMREAD_COLOR);
+        if (image.empty()) continue;
+        dlib::cv_image<dlib::bgr_pixel> dlib_image(image);
+        std::vector<dlib::rectangle> faces = models->face_detector(dlib_image);
+        if (faces.empty()) continue;
+        const dlib::rectangle face = *std::max_element(faces.begin(), faces.end(),
+            [](const dlib::rectangle& l, const dlib::rectangle& r) { return l.area() < r.area(); });
+        dlib::extract_image_chip(dlib_image, dlib::get_face_chip_details(models->shape_predictor(dlib_image, face), 150, 0.25), chips[i]);
+        has_face[i] = true;
+    }
+
+    // Calibration images, then the pairs that use none of them
+    std::vector<std::vector<uint8_t>> calibration_bytes;
+    std::vector<bool> calibration(images.size(), false);
+    for (size_t i = 0; i < images.size() && static_cast<int>(calibration_bytes.size()) < calibration_count; ++i) {
+        if (!has_face[i]) continue;
+        calibration_bytes.emplace_back(static_cast<size_t>(kFaceChipSize) * kFaceChipSize * 3);
+        faceChipBytes(chips[i], calibration_bytes.back().data());
+        calibration[i] = true;
+    }
+    std::vector<Pair> pairs;
+    size_t no_face = 0;
+    for (const Pair& pair : all_pairs) {
+        if (!has_face[pair.a] || !has_face[pair.b]) no_face++;
+        else if (!calibration[pair.a] && !calibration[pair.b]) pairs.push_back(pair);
+    }
+    if (calibration_bytes.empty() || pairs.empty()) {
+        std::cerr << "Error: Need faces for calibration and at least one pair left to evaluate" << std::endl;
+        return -1;
+    }
+
+    std::vector<const uint8_t*> calibration_chips;
+    for (const auto& bytes : calibration_bytes) calibration_chips.push_back(bytes.data());
+    auto start = std::chrono::steady_clock::now();
+    const FaceNetScales scales = calibrateFaceNet(weights, calibration_chips);
+    const double calibration_s = secondsSince(start);
+    if (!scales_path.empty() && !scales.save(scales_path)) {
+        std::cerr << "Error: Unable to write " << scales_path << std::endl;
+        return -1;
+    }
+
+    // Descriptors of every evaluated image, one chip at a time on one thread
+    std::vector<int> evaluated;
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (has_face[i] && !calibration[i]) evaluated.push_back(static_cast<int>(i));
+    }
+    std::vector<dlib::matrix<float, 0, 1>> reference(images.size()), quantized(images.size());
+    start = std::chrono::steady_clock::now();
+    for (int i : evaluated) reference[i] = models->face_recognizer(chips[i]);
+    const double reference_s = secondsSince(start);
+
+    QuantizedFaceNet net(weights, scales);
+    start = std::chrono::steady_clock::now();
+    for (int i : evaluated) quantized[i] = quantizedDescriptor(net, chips[i]);
+    const double quantized_s = secondsSince(start);
+
+    // The float reference of quantizedFaceNet.cpp must reproduce dlib on every evaluated
+    // face; otherwise the weights were not extracted correctly and the int8 figures below
+    // would not describe dlib's network. It is also the network the face programs run from
+    // the model cache, so its throughput is reported as well.
+    FaceNetFloat float_net(weights);
+    double float_error = 0.0;
+    std::vector<uint8_t> bytes(static_cast<size_t>(kFaceChipSize) * kFaceChipSize * 3);
+    dlib::matrix<float, 0, 1> descriptor(kFaceDescriptorSize);
+    start = std::chrono::steady_clock::now();
+    for (int i : evaluated) {
+        faceChipBytes(chips[i], bytes.data());
+        float_net.embed(bytes.data(), &descriptor(0));
+        float_error = std::max(float_error, static_cast<double>(dlib::max(dlib::abs(descriptor - reference[i]))));
+    }
+    const double float_s = secondsSince(start);
+    if (float_error > kFloatTolerance) {
+        std::cerr << "Error: The float reference differs from dlib by " << float_error << " (max |diff| over "
+                  << evaluated.size() << " faces); the weights of " << net_path << " were not extracted correctly" << std::endl;
+        return -1;
+    }
+
+    double error = 0.0, norm = 0.0;
+    for (int i : evaluated) {
+        error += dlib::length(quantized[i] - reference[i]);
+        norm += dlib::length(reference[i]);
+    }
+    size_t flipped = 0;
+    for (const Pair& pair : pairs) {
+        const bool a = dlib::length(reference[pair.a] - reference[pair.b]) < 0.6;
+        const bool b = dlib::length(quantized[pair.a] - quantized[pair.b]) < 0.6;
+        flipped += a != b;
+    }
+    const Verification fp32 = verify(pairs, reference);
+    const Verification int8 = verify(pairs, quantized);
+
+    std::printf("%zu images (%zu without a face), %zu calibration, %zu pairs evaluated, int8 kernel %s\n",
+        images.size(), static_cast<size_t>(std::count(has_face.begin(), has_face.end(), false)),
+        calibration_bytes.size(), pairs.size(), QuantizedFaceNet::kernel());
+    std::printf("calibration %.1f s, float reference vs dlib max |diff| %.2e over %zu faces, %zu pairs skipped for missing faces\n",
+        calibration_s, float_error, evaluated.size(), no_face);
+    std::printf("fp32  %8.1f embeddings/s   accuracy %.4f at 0.6, best %.4f at %.3f\n",
+        evaluated.size() / reference_s, fp32.accuracy, fp32.best_accuracy, fp32.best_threshold);
+    std::printf("cache %8.1f embeddings/s   (FaceNetFloat, the network run from the model cache)\n",
+        evaluated.size() / float_s);
+    std::printf("int8  %8.1f embeddings/s   accuracy %.4f at 0.6, best %.4f at %.3f\n",
+        evaluated.size() / quantized_s, int8.accuracy, int8.best_accuracy, int8.best_threshold);
+    std::printf("int8 vs dlib fp32: %.2fx faster, accuracy %+.2f points at 0.6 and %+.2f at the best threshold, %zu of %zu decisions at 0.6 changed\n",
+        reference_s / quantized_s, 100.0 * (int8.accuracy - fp32.accuracy), 100.0 * (int8.best_accuracy - fp32.best_accuracy),
+        flipped, pairs.size());
+    std::printf("descriptor error %.2f%% (relative L2 to dlib)\n", 100.0 * error / norm);
+    return 0;
+}
@@ -0,0 +1,209 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// faceNetShareBenchmark.cpp : Resident memory and time to the first descriptor of N
+// concurrent processes running the face ResNet (FaceNetFloat), with the weights either
+// read into each process ("copy", what the dlib tensors of a .dat load amount to) or
+// used in place from one shared read-only mapping ("map", the face model cache):
+//
+//   faceNetShareBenchmark [processes] [weights]
+//
+// weights holds packFaceNetFloat() floats; it is written with random weights of the
+// anet_type shapes if it does not exist. The timing and memory do not depend on the
+// values. POSIX only (fork).
+//
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mappedFile.h"
+#include "processStats.h"
+#include "quantizedFaceNet.h"
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct ChildReport {
+    double first_ms;        // Start of the load to the first descriptor
+    double resident_mb;
+    double shared_mb;
+    float descriptor0;
+};
+
+bool writeRandomWeights(const std::string& path) {
+    std::mt19937 rng(1);
+    FaceNetWeights weights = FaceNetWeights::shapes();
+    auto fill = [&](FaceNetConv& conv, float gain) {
+        std::normal_distribution<float> weight(0.0f, gain * std::sqrt(2.0f / (conv.kernel * conv.kernel * conv.inputs)));
+        for (float& w : conv.weights) w = weight(rng);
+    };
+    fill(weights.stem, 8.0f);
+    for (FaceNetBlock& block : weights.blocks) {
+        fill(block.conv1, 1.0f);
+        fill(block.conv2, 0.3f);
+    }
+    std::normal_distribution<float> fc(0.0f, 0.1f);
+    for (float& w : weights.fc) w = fc(rng);
+
+    const std::vector<float> packed = packFaceNetFloat(weights);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size() * sizeof(float)));
+    return static_cast<bool>(out);
+}
+
+// Loads the weights, computes one descriptor and reports on result_fd, then holds the
+// weights until release_fd is closed. Returns the exit code of the child.
+int runChild(const std::string& path, bool map, int result_fd, int release_fd) {
+    std::vector<uint8_t> chip(static_cast<size_t>(kFaceChipSize) * kFaceChipSize * 3);
+    for (size_t i = 0; i < chip.size(); ++i) chip[i] = static_cast<uint8_t>((i * 7) % 251);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<FaceNetFloat> net;
+    if (map) {
+        auto file = std::make_shared<MappedFile>();
+        if (!file->open(path) || file->size() != faceNetFloatPackedSize() * sizeof(float)) return 2;
+        const float* packed = reinterpret_cast<const float*>(file->data());
+        net.reset(new FaceNetFloat(packed, file));
+    }
+    else {
+        auto weights = std::make_shared<std::vector<float>>(faceNetFloatPackedSize());
+        std::ifstream in(path, std::ios::binary);
+        if (!in.read(reinterpret_cast<char*>(weights->data()), static_cast<std::streamsize>(weights->size() * sizeof(float)))) return 2;
+        net.reset(new FaceNetFloat(weights->data(), weights));
+    }
+    float descriptor[kFaceDescriptorSize];
+    net->embed(chip.data(), descriptor);
+
+    ChildReport report;
+    report.first_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    report.resident_mb = residentSetBytes() / 1048576.0;
+    report.shared_mb = sharedResidentBytes() / 1048576.0;
+    report.descriptor0 = descriptor[0];
+    if (write(result_fd, &report, sizeof(report)) != static_cast<ssize_t>(sizeof(report))) return 3;
+
+    char byte;
+    while (read(release_fd, &byte, 1) > 0) {}
+    return 0;
+}
+
+// Proportional set size of a process in MB: every shared page is divided by the number of
+// processes mapping it, so the sum over processes is the memory they use together. 0 if
+// unavailable (Linux 4.14 and later).
+double proportionalMb(pid_t pid) {
+    std::ifstream in("/proc/" + std::to_string(pid) + "/smaps_rollup");
+    std::string key, unit;
+    double kb = 0.0;
+    while (in >> key) {
+        if (key == "Pss:" && in >> kb >> unit) return kb / 1024.0;
+        in.ignore(1 << 16, '\n');
+    }
+    return 0.0;
+}
+
+// Starts the children and measures their PSS once every one has reported and still holds
+// its weights, then lets them exit. Returns false if a child failed.
+bool runMode(const std::string& path, bool map, int processes, std::vector<ChildReport>& reports, double& total_pss_mb) {
+    int results[2], release[2];
+    if (pipe(results) != 0 || pipe(release) != 0) return false;
+
+    std::vector<pid_t> children;
+    for (int i = 0; i < processes; ++i) {
+        const pid_t pid = fork();
+        if (pid < 0) return false;
+        if (pid == 0) {
+            close(results[0]);
+            close(release[1]);
+            _exit(runChild(path, map, results[1], release[0]));
+        }
+        children.push_back(pid);
+    }
+    close(results[1]);
+    close(release[0]);
+
+    reports.clear();
+    ChildReport report;
+    while (static_cast<int>(reports.size()) < processes && read(results[0], &report, sizeof(report)) == static_cast<ssize_t>(sizeof(report))) {
+        reports.push_back(report);
+    }
+    // Every child is alive here and holds its weights
+    total_pss_mb = 0.0;
+    for (pid_t pid : children) total_pss_mb += proportionalMb(pid);
+    close(release[1]);
+    close(results[0]);
+
+    bool ok = static_cast<int>(reports.size()) == processes;
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int processes = argc > 1 ? std::max(1, std::atoi(argv[1])) : 8;
+    const std::string path = argc > 2 ? argv[2] : "face_net.weights";
+
+    // Written by a child, so the children measured below do not inherit its heap
+    std::ifstream existing(path, std::ios::binary | std::ios::ate);
+    if (!existing || static_cast<size_t>(existing.tellg()) != faceNetFloatPackedSize() * sizeof(float)) {
+        const pid_t pid = fork();
+        if (pid == 0) _exit(writeRandomWeights(path) ? 0 : 1);
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "Error: Unable to write " << path << std::endl;
+            return -1;
+        }
+    }
+    const double weights_mb = faceNetFloatPackedSize() * sizeof(float) / 1048576.0;
+    std::printf("%d processes, %.1f MB of weights\n", processes, weights_mb);
+
+    float descriptor0[2] = {};
+    for (int mode = 0; mode < 2; ++mode) {
+        const bool map = mode == 1;
+        std::vector<ChildReport> reports;
+        double total_pss_mb = 0.0;
+        if (!runMode(path, map, processes, reports, total_pss_mb)) {
+            std::cerr << "Error: A " << (map ? "map" : "copy") << " process failed" << std::endl;
+            return -1;
+        }
+        double first_ms = 0.0, resident = 0.0, shared = 0.0;
+        for (const ChildReport& r : reports) {
+            first_ms += r.first_ms;
+            resident += r.resident_mb;
+            shared += r.shared_mb;
+        }
+        const double n = static_cast<double>(reports.size());
+        std::printf("%-4s  first descriptor %6.1f ms   RSS %5.1f MB   shared %5.1f MB   private %5.1f MB per process   PSS %6.1f MB for all\n",
+            map ? "map" : "copy", first_ms / n, resident / n, shared / n, (resident - shared) / n, total_pss_mb);
+        descriptor0[mode] = reports[0].descriptor0;
+    }
+    if (descriptor0[0] != descriptor0[1]) {
+        std::cerr << "Error: The mapped weights give a different descriptor" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+#else
+
+int main() {
+    std::cerr << "Error: faceNetShareBenchmark needs fork()" << std::endl;
+    return -1;
+}
+
+#endif
@@ -0,0 +1,202 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// featureFrontEnd.cpp : Runtime-selected ORB / SIFT / FAST+BRIEF detection with a feature
+// budget adapted to a per-frame time budget.
+//
+#include "featureFrontEnd.h"
+#include "pyramidFeatures.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+const double kSmoothing = 0.2;   // Weight of the newest frame in the smoothed time
+const double kHeadroom = 0.75;   // Grow only below this fraction of the budget
+const int kSettleFrames = 3;     // Frames to wait after a change
+
+double nowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename T>
+T percentile(std::vector<T> values, double p) {
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(values.size() * p))];
+}
+
+} // namespace
+
+bool parseDetectorType(const std::string& name, DetectorType& type) {
+    if (name == "orb") type = DetectorType::Orb;
+    else if (name == "sift") type = DetectorType::Sift;
+    else if (name == "fast") type = DetectorType::FastBrief;
+    else return false;
+    return true;
+}
+
+const char* detectorName(DetectorType type) {
+    switch (type) {
+    case DetectorType::Orb: return "ORB";
+    case DetectorType::Sift: return "SIFT";
+    default: return "FAST+BRIEF";
+    }
+}
+
+PyramidConfig pyramidConfigFor(DetectorType type) {
+    PyramidConfig config;
+    if (type == DetectorType::Sift) config.levels = 1;
+    return config;
+}
+
+FeatureFrontEnd::FeatureFrontEnd(FrontEndConfig config) : config_(config) {
+    config_.min_features = std::max(config_.min_features, 1);
+    config_.max_features = std::max(config_.max_features, config_.min_features);
+    params_.features = std::min(std::max(config_.initial_features, config_.min_features), config_.max_features);
+
+    if (config_.type == DetectorType::Sift) {
+        // OpenCV defaults: 3 layers per octave, contrast threshold 0.04
+        params_.levels = 3;
+        params_.threshold = 40;
+        threshold_step_ = 10;
+        max_threshold_ = 120;
+    }
+    else {
+        // ORB defaults: 8 levels, FAST threshold 20
+        params_.levels = 8;
+        params_.threshold = 20;
+        threshold_step_ = 5;
+        max_threshold_ = 60;
+    }
+    defaults_ = params_;
+    max_levels_ = params_.levels;
+    orb_ = cv::ORB::create(params_.features);
+}
+
+void FeatureFrontEnd::detect(const ImagePyramid& pyramid, std::vector<cv::KeyPoint>& keypoints, cv::Mat& descriptors) {
+    if (config_.type != DetectorType::Sift) {
+        // Never ask for more levels than the frame source builds
+        max_levels_ = std::min(defaults_.levels, pyramid.levels());
+        params_.levels = std::min(params_.levels, max_levels_);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    switch (config_.type) {
+    case DetectorType::Orb:
+        orb_->setFastThreshold(params_.threshold);
+        detectOrbOnPyramid(*orb_, pyramid, params_.features, keypoints, descriptors, params_.levels);
+        break;
+    case DetectorType::Sift:
+        if (!sift_ || sift_params_.features != params_.features || sift_params_.levels != params_.levels ||
+            sift_params_.threshold != params_.threshold) {
+            sift_ = cv::SIFT::create(params_.features, params_.levels, params_.threshold / 1000.0);
+            sift_params_ = params_;
+        }
+        sift_->detectAndCompute(asMat(pyramid.gray()), cv::noArray(), keypoints, descriptors);
+        break;
+    case DetectorType::FastBrief:
+        detectFastBriefOnPyramid(pyramid, params_.features, params_.threshold, keypoints, descriptors, params_.levels);
+        break;
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    TRACE_COUNTER("feature_budget", params_.features);
+    if (config_.budget_ms > 0.0) adapt(ms);
+
+    if (config_.report_every > 0) {
+        if (frames_ == 0) window_start_s_ = nowSeconds();
+        frames_++;
+        keypoint_counts_.push_back(keypoints.size());
+        detect_ms_.push_back(ms);
+        if (frames_ > config_.report_every) report();
+    }
+}
+
+void FeatureFrontEnd::adapt(double ms) {
+    smoothed_ms_ = smoothed_ms_ == 0.0 ? ms : smoothed_ms_ + kSmoothing * (ms - smoothed_ms_);
+    if (settle_ > 0) {
+        settle_--;
+        return;
+    }
+
+    // Parameters in the order they are cut; restored in reverse order
+    static const Knob kPyramidOrder[] = { Knob::Features, Knob::Levels, Knob::Threshold };
+    static const Knob kSiftOrder[] = { Knob::Threshold, Knob::Levels, Knob::Features };
+    const Knob* order = config_.type == DetectorType::Sift ? kSiftOrder : kPyramidOrder;
+
+    const FrontEndParams before = params_;
+    const double ratio = config_.budget_ms / smoothed_ms_;
+    if (smoothed_ms_ > config_.budget_ms) {
+        for (int i = 0; i < 3 && !cut(order[i], ratio); ++i) {}
+    }
+    else if (smoothed_ms_ < kHeadroom * config_.budget_ms) {
+        bool restored = false;
+        for (int i = 2; i >= 0 && !restored; --i) restored = restore(order[i]);
+        if (!restored && params_.features < config_.max_features) {
+            const double grow = std::min(1.25, ratio);
+            params_.features = std::min(config_.max_features, static_cast<int>(params_.features * grow) + 1);
+        }
+    }
+
+    if (params_.features != before.features || params_.levels != before.levels || params_.threshold != before.threshold) {
+        settle_ = kSettleFrames;
+    }
+}
+
+bool FeatureFrontEnd::cut(Knob knob, double ratio) {
+    switch (knob) {
+    case Knob::Features:
+        if (params_.features <= config_.min_features) return false;
+        params_.features = std::max(config_.min_features, static_cast<int>(params_.features * std::max(0.5, 0.95 * ratio)));
+        return true;
+    case Knob::Levels:
+        if (params_.levels <= 1) return false;
+        params_.levels--;
+        return true;
+    default:
+        if (params_.threshold >= max_threshold_) return false;
+        params_.threshold = std::min(max_threshold_, params_.threshold + threshold_step_);
+        return true;
+    }
+}
+
+bool FeatureFrontEnd::restore(Knob knob) {
+    switch (knob) {
+    case Knob::Features:
+        // Back to the initial count only; growing beyond it comes after every other restore
+        if (params_.features >= defaults_.features) return false;
+        params_.features = std::min(defaults_.features, static_cast<int>(params_.features * 1.25) + 1);
+        return true;
+    case Knob::Levels:
+        if (params_.levels >= max_levels_) return false;
+        params_.levels++;
+        return true;
+    default:
+        if (params_.threshold <= defaults_.threshold) return false;
+        params_.threshold = std::max(defaults_.threshold, params_.threshold - threshold_step_);
+        return true;
+    }
+}
+
+std::string FeatureFrontEnd::describe() const {
+    char text[128];
+    std::snprintf(text, sizeof(text), "%s: %d features, %d levels, threshold %d, %.1f ms",
+        detectorName(config_.type), params_.features, params_.levels, params_.threshold, smoothed_ms_);
+    return text;
+}
+
+void FeatureFrontEnd::report() {
+    // The first frame only starts the clock
+    const double elapsed = nowSeconds() - window_start_s_;
+    const size_t frames = keypoint_counts_.size() - 1;
+    std::printf("[%s] %.1f fps, keypoints p50 %zu min %zu, detect p50 %.1f ms p99 %.1f ms (budget %.1f ms), %d features, %d levels, threshold %d\n",
+        detectorName(config_.type), elapsed > 0.0 ? frames / elapsed : 0.0, percentile(keypoint_counts_, 0.5),
+        percentile(keypoint_counts_, 0.0), percentile(detect_ms_, 0.5), percentile(detect_ms_, 0.99), config_.budget_ms,
+        params_.features, params_.levels, params_.threshold);
+    frames_ = 0;
+    keypoint_counts_.clear();
+    detect_ms_.clear();
+}
@@ -0,0 +1,101 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// featureFrontEnd.h : Runtime-selected ORB / SIFT / FAST+BRIEF detection with a feature
+// budget adapted to a per-frame time budget.
+//
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+#include <string>
+#include <vector>
+
+#include "imagePyramid.h"
+
+enum class DetectorType { Orb, Sift, FastBrief };
+
+// "orb", "sift" or "fast"; returns false for anything else
+bool parseDetectorType(const std::string& name, DetectorType& type);
+const char* detectorName(DetectorType type);
+
+// Pyramid a FrameSource should build for the detector: ORB and FAST+BRIEF detect on the
+// ORB default 8 levels at scale 1.2, SIFT builds its own scale space from the gray level
+PyramidConfig pyramidConfigFor(DetectorType type);
+
+struct FrontEndConfig {
+    DetectorType type = DetectorType::Orb;
+    double budget_ms = 15.0;    // Target detect + describe time per frame; 0 disables adaptation
+    int initial_features = 500;
+    int min_features = 150;     // Below this, levels and thresholds are traded instead
+    int max_features = 2000;
+    size_t report_every = 100;  // Frames between fps / keypoint reports, 0 for none
+};
+
+// Current detector parameters. levels is the number of shared pyramid levels for ORB and
+// FAST+BRIEF and the octave layers for SIFT; threshold is the FAST threshold for ORB and
+// FAST+BRIEF and the contrast threshold x 1000 for SIFT.
+struct FrontEndParams {
+    int features = 0;
+    int levels = 0;
+    int threshold = 0;
+};
+
+// Detects on the shared pyramid of a frame and tunes the detector from the measured
+// detection time. The control loop works on a smoothed frame time:
+//
+//   over budget:        cut the first parameter in the detector's order that can still
+//                       be cut. ORB, FAST+BRIEF: the feature count (in proportion to
+//                       the overrun, down to min_features), pyramid levels, then the
+//                       threshold. SIFT: the contrast threshold, octave layers, then the
+//                       feature count; cv::SIFT applies nfeatures after detecting every
+//                       keypoint, so the count barely changes its cost.
+//   under 75% budget:   undo the cuts in reverse order, then grow the feature count up
+//                       to max_features
+//
+// Each change waits a few frames for the smoothed time to settle, so the loop does not
+// oscillate on single slow frames.
+class FeatureFrontEnd {
+public:
+    explicit FeatureFrontEnd(FrontEndConfig config = FrontEndConfig());
+
+    // Detect and describe; SIFT runs on the grayscale level, ORB and FAST+BRIEF on the
+    // pyramid levels selected by params().levels
+    void detect(const ImagePyramid& pyramid, std::vector<cv::KeyPoint>& keypoints, cv::Mat& descriptors);
+
+    const FrontEndConfig& config() const { return config_; }
+    const FrontEndParams& params() const { return params_; }
+    double smoothedMs() const { return smoothed_ms_; }
+
+    // One line of the current parameters, for overlays and reports
+    std::string describe() const;
+
+private:
+    enum class Knob { Features, Levels, Threshold };
+
+    void adapt(double ms);
+    bool cut(Knob knob, double ratio);
+    bool restore(Knob knob);
+    void report();
+
+    FrontEndConfig config_;
+    FrontEndParams params_;
+    FrontEndParams defaults_;
+    int max_levels_ = 0;
+    int max_threshold_ = 0;
+    int threshold_step_ = 0;
+
+    cv::Ptr<cv::ORB> orb_;
+    cv::Ptr<cv::SIFT> sift_;
+    FrontEndParams sift_params_; // Parameters sift_ was created with
+
+    double smoothed_ms_ = 0.0;
+    int settle_ = 0;
+
+    // Report window
+    size_t frames_ = 0;
+    double window_start_s_ = 0.0;
+    std::vector<size_t> keypoint_counts_;
+    std::vector<double> detect_ms_;
+};
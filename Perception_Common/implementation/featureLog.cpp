@@ -0,0 +1,285 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// featureLog.cpp : Chunked binary log of per-frame timestamps, poses, keypoints and
+// descriptors, with a memory-mapped reader for random access.
+//
+#include "featureLog.h"
+#include "tracing.h"
+
+#include <cstring>
+
+namespace {
+
+const char kFileMagic[8] = { 'D', 'W', 'F', 'E', 'A', 'T', 'L', 'G' };
+const char kChunkMagic[4] = { 'C', 'H', 'N', 'K' };
+const char kFooterMagic[8] = { 'D', 'W', 'F', 'L', 'G', 'I', 'D', 'X' };
+const uint32_t kVersion = 1;
+const size_t kMaxPendingChunks = 4;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct ChunkHeader {
+    char magic[4];
+    uint32_t frame_count;
+    uint64_t bytes; // Including this header
+};
+
+struct Footer {
+    uint64_t index_offset;
+    uint64_t frame_count;
+    char magic[8];
+};
+
+size_t padded(size_t bytes) {
+    return (bytes + 7) / 8 * 8;
+}
+
+// A frame record at offset must fit before end and hold its keypoints and descriptors
+bool recordFits(const char* data, uint64_t offset, uint64_t end) {
+    if (offset % 8 != 0 || offset + sizeof(FeatureLogFrameHeader) > end) return false;
+    FeatureLogFrameHeader header;
+    std::memcpy(&header, data + offset, sizeof(header));
+    const uint64_t payload = uint64_t(header.keypoint_count) * (sizeof(LogKeypoint) + header.descriptor_bytes);
+    return header.record_bytes >= sizeof(header) + payload && offset + header.record_bytes <= end;
+}
+
+} // namespace
+
+FeatureLogWriter::~FeatureLogWriter() {
+    close();
+}
+
+bool FeatureLogWriter::open(const std::string& path, size_t chunk_bytes) {
+    close();
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) return false;
+
+    FileHeader header = {};
+    std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+    header.version = kVersion;
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    open_ = true;
+    chunk_bytes_ = chunk_bytes;
+    chunk_.clear();
+    chunk_.resize(sizeof(ChunkHeader));
+    chunk_frames_ = 0;
+    file_offset_ = sizeof(header);
+    index_.clear();
+    stop_ = false;
+    failed_ = false;
+    writer_ = std::thread(&FeatureLogWriter::run, this);
+    return true;
+}
+
+void FeatureLogWriter::append(const FeatureLogRecord& record) {
+    if (!open_) return;
+    TRACE_SCOPE("featureLog.append");
+
+    const size_t keypoint_bytes = record.keypoint_count * sizeof(LogKeypoint);
+    const size_t descriptor_bytes = record.descriptors ? size_t(record.keypoint_count) * record.descriptor_bytes : 0;
+    const size_t record_bytes = padded(sizeof(FeatureLogFrameHeader) + keypoint_bytes + descriptor_bytes);
+    if (chunk_frames_ > 0 && chunk_.size() + record_bytes > chunk_bytes_) {
+        sealChunk();
+    }
+
+    FeatureLogFrameHeader header = {};
+    header.record_bytes = static_cast<uint32_t>(record_bytes);
+    header.keypoint_count = record.keypoint_count;
+    header.index = record.index;
+    header.capture_ns = record.capture_ns;
+    header.media_time_ms = record.media_time_ms;
+    std::memcpy(header.rotation, record.rotation, sizeof(header.rotation));
+    std::memcpy(header.translation, record.translation, sizeof(header.translation));
+    header.flags = record.has_pose ? kFeatureLogHasPose : 0;
+    header.descriptor_type = record.descriptors ? record.descriptor_type : DescriptorType::None;
+    header.descriptor_bytes = record.descriptors ? record.descriptor_bytes : 0;
+
+    const size_t offset = chunk_.size();
+    index_.push_back(file_offset_ + offset);
+    chunk_.resize(offset + record_bytes);
+    uint8_t* p = chunk_.data() + offset;
+    std::memcpy(p, &header, sizeof(header));
+    if (keypoint_bytes > 0) std::memcpy(p + sizeof(header), record.keypoints, keypoint_bytes);
+    if (descriptor_bytes > 0) std::memcpy(p + sizeof(header) + keypoint_bytes, record.descriptors, descriptor_bytes);
+    std::memset(p + sizeof(header) + keypoint_bytes + descriptor_bytes, 0,
+        record_bytes - sizeof(header) - keypoint_bytes - descriptor_bytes);
+    chunk_frames_++;
+}
+
+void FeatureLogWriter::sealChunk() {
+    ChunkHeader header = {};
+    std::memcpy(header.magic, kChunkMagic, sizeof(kChunkMagic));
+    header.frame_count = chunk_frames_;
+    header.bytes = chunk_.size();
+    std::memcpy(chunk_.data(), &header, sizeof(header));
+    file_offset_ += chunk_.size();
+
+    // Hand the chunk to the writer thread and continue in a recycled buffer
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [this] { return pending_.size() < kMaxPendingChunks; });
+    pending_.push_back(std::move(chunk_));
+    if (!spare_.empty()) {
+        chunk_ = std::move(spare_.back());
+        spare_.pop_back();
+    }
+    else {
+        chunk_ = std::vector<uint8_t>();
+        chunk_.reserve(chunk_bytes_);
+    }
+    lock.unlock();
+    wake_.notify_one();
+
+    chunk_.resize(sizeof(ChunkHeader));
+    chunk_frames_ = 0;
+}
+
+void FeatureLogWriter::run() {
+    trace::setThreadName("featureLog");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+        if (pending_.empty()) return;
+
+        std::vector<uint8_t> chunk = std::move(pending_.front());
+        pending_.pop_front();
+        lock.unlock();
+        {
+            TRACE_SCOPE("featureLog.write");
+            out_.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+        }
+        lock.lock();
+        if (!out_) failed_ = true;
+        spare_.push_back(std::move(chunk));
+        drained_.notify_one();
+    }
+}
+
+bool FeatureLogWriter::close() {
+    if (!open_) return false;
+    if (chunk_frames_ > 0) sealChunk();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+
+    // The writer thread has drained every chunk, the index follows the last one
+    Footer footer = {};
+    footer.index_offset = file_offset_;
+    footer.frame_count = index_.size();
+    std::memcpy(footer.magic, kFooterMagic, sizeof(kFooterMagic));
+    out_.write(reinterpret_cast<const char*>(index_.data()), static_cast<std::streamsize>(index_.size() * sizeof(uint64_t)));
+    out_.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+    out_.close();
+
+    const bool ok = !failed_ && !out_.fail();
+    open_ = false;
+    pending_.clear();
+    spare_.clear();
+    chunk_.clear();
+    return ok;
+}
+
+void ChainedPose::add(const FeatureLogFrameHeader& frame) {
+    if (!(frame.flags & kFeatureLogHasPose)) return;
+    const double* R = frame.rotation;
+    const double* t = frame.translation;
+    double step[3], next[9];
+    for (int r = 0; r < 3; ++r) {
+        step[r] = -(R[0 * 3 + r] * t[0] + R[1 * 3 + r] * t[1] + R[2 * 3 + r] * t[2]);
+    }
+    for (int r = 0; r < 3; ++r) {
+        position[r] += rotation[r * 3 + 0] * step[0] + rotation[r * 3 + 1] * step[1] + rotation[r * 3 + 2] * step[2];
+        for (int c = 0; c < 3; ++c) {
+            // rotation * R^T
+            next[r * 3 + c] = rotation[r * 3 + 0] * R[c * 3 + 0] + rotation[r * 3 + 1] * R[c * 3 + 1] +
+                rotation[r * 3 + 2] * R[c * 3 + 2];
+        }
+    }
+    std::memcpy(rotation, next, sizeof(rotation));
+}
+
+bool FeatureLogReader::open(const std::string& path) {
+    close();
+    if (!file_.open(path) || file_.size() < sizeof(FileHeader)) return false;
+
+    FileHeader header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 || header.version != kVersion) {
+        close();
+        return false;
+    }
+
+    // Index from the footer when the writer closed the log
+    if (file_.size() >= sizeof(FileHeader) + sizeof(Footer)) {
+        Footer footer;
+        std::memcpy(&footer, file_.data() + file_.size() - sizeof(Footer), sizeof(footer));
+        const uint64_t index_end = footer.index_offset + footer.frame_count * sizeof(uint64_t);
+        if (std::memcmp(footer.magic, kFooterMagic, sizeof(kFooterMagic)) == 0 && footer.frame_count <= file_.size() / sizeof(uint64_t) &&
+            footer.index_offset >= sizeof(FileHeader) && index_end == file_.size() - sizeof(Footer)) {
+            offsets_.resize(footer.frame_count);
+            std::memcpy(offsets_.data(), file_.data() + footer.index_offset, offsets_.size() * sizeof(uint64_t));
+            bool valid = true;
+            for (uint64_t offset : offsets_) {
+                valid = valid && recordFits(file_.data(), offset, footer.index_offset);
+            }
+            if (valid) return true;
+            offsets_.clear();
+        }
+    }
+
+    recovered_ = true;
+    return scanChunks();
+}
+
+bool FeatureLogReader::scanChunks() {
+    uint64_t offset = sizeof(FileHeader);
+    const uint64_t size = file_.size();
+    while (offset + sizeof(ChunkHeader) <= size) {
+        ChunkHeader chunk;
+        std::memcpy(&chunk, file_.data() + offset, sizeof(chunk));
+        if (std::memcmp(chunk.magic, kChunkMagic, sizeof(kChunkMagic)) != 0 || chunk.bytes < sizeof(ChunkHeader) ||
+            offset + chunk.bytes > size) {
+            break;
+        }
+
+        // Frame records are walked by their sizes; a chunk that does not add up is corrupt
+        const uint64_t chunk_end = offset + chunk.bytes;
+        uint64_t record = offset + sizeof(ChunkHeader);
+        std::vector<uint64_t> records;
+        for (uint32_t i = 0; i < chunk.frame_count && recordFits(file_.data(), record, chunk_end); ++i) {
+            FeatureLogFrameHeader header;
+            std::memcpy(&header, file_.data() + record, sizeof(header));
+            records.push_back(record);
+            record += header.record_bytes;
+        }
+        if (records.size() != chunk.frame_count) break;
+        offsets_.insert(offsets_.end(), records.begin(), records.end());
+        offset = chunk_end;
+    }
+    return true;
+}
+
+void FeatureLogReader::close() {
+    file_.close();
+    offsets_.clear();
+    recovered_ = false;
+}
+
+FeatureLogFrame FeatureLogReader::frame(size_t i) const {
+    FeatureLogFrame view;
+    const uint8_t* record = reinterpret_cast<const uint8_t*>(file_.data()) + offsets_[i];
+    view.header = reinterpret_cast<const FeatureLogFrameHeader*>(record);
+    view.keypoints = reinterpret_cast<const LogKeypoint*>(record + sizeof(FeatureLogFrameHeader));
+    if (view.header->descriptor_type != DescriptorType::None) {
+        view.descriptors = record + sizeof(FeatureLogFrameHeader) + view.header->keypoint_count * sizeof(LogKeypoint);
+    }
+    return view;
+}
@@ -0,0 +1,151 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// featureLog.h : Chunked binary log of per-frame timestamps, poses, keypoints and
+// descriptors, with a memory-mapped reader for random access.
+//
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mappedFile.h"
+
+// Same fields as cv::KeyPoint (class_id dropped)
+struct LogKeypoint {
+    float x, y;
+    float size;
+    float angle;
+    float response;
+    int32_t octave;
+};
+
+enum class DescriptorType : uint16_t { None = 0, Binary = 1, Float = 2 };
+
+// Fixed part of every frame record, followed by keypoint_count LogKeypoints and
+// keypoint_count descriptor rows of descriptor_bytes each, padded to 8 bytes
+struct FeatureLogFrameHeader {
+    uint32_t record_bytes;      // Header, keypoints, descriptors and padding
+    uint32_t keypoint_count;
+    uint64_t index;             // Frame index in the source
+    int64_t capture_ns;         // steady_clock time the frame was grabbed
+    double media_time_ms;       // Timestamp inside a video file, 0 otherwise
+    double rotation[9];         // Row-major R of the motion from the previous frame
+    double translation[3];      // t of that motion (unit length from recoverPose)
+    uint32_t flags;             // kFeatureLogHasPose
+    DescriptorType descriptor_type;
+    uint16_t descriptor_bytes;  // Bytes per descriptor row
+};
+
+const uint32_t kFeatureLogHasPose = 1;
+
+// One frame to append; the pointers only need to stay valid for the append() call
+struct FeatureLogRecord {
+    uint64_t index = 0;
+    int64_t capture_ns = 0;
+    double media_time_ms = 0.0;
+    bool has_pose = false;
+    double rotation[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+    double translation[3] = { 0, 0, 0 };
+    const LogKeypoint* keypoints = nullptr;
+    uint32_t keypoint_count = 0;
+    DescriptorType descriptor_type = DescriptorType::None;
+    uint16_t descriptor_bytes = 0;
+    const uint8_t* descriptors = nullptr; // keypoint_count rows, contiguous
+};
+
+// File layout (native endianness, all records 8-byte aligned):
+//
+//   file header          magic "DWFEATLG", version
+//   chunk*               chunk header (magic "CHNK", frame count, bytes), frame records
+//   frame index          file offset of every frame record
+//   footer               index offset, frame count, magic "DWFLGIDX"
+//
+// append() copies the frame into the open chunk; full chunks are written by a background
+// thread. When four sealed chunks are queued, append() blocks until the disk catches up. A log
+// cut short by a crash has no index; the reader then recovers every complete chunk.
+class FeatureLogWriter {
+public:
+    FeatureLogWriter() = default;
+    ~FeatureLogWriter();
+
+    FeatureLogWriter(const FeatureLogWriter&) = delete;
+    FeatureLogWriter& operator=(const FeatureLogWriter&) = delete;
+
+    bool open(const std::string& path, size_t chunk_bytes = 1 << 20);
+    void append(const FeatureLogRecord& record);
+
+    // Writes the last chunk, the index and the footer. Returns false if any write failed.
+    bool close();
+
+    bool isOpen() const { return open_; }
+    uint64_t frames() const { return index_.size(); }
+    uint64_t bytesWritten() const { return file_offset_; }
+
+private:
+    void sealChunk();
+    void run();
+
+    std::ofstream out_;
+    bool open_ = false;
+    size_t chunk_bytes_ = 0;
+    std::vector<uint8_t> chunk_;
+    uint32_t chunk_frames_ = 0;
+    uint64_t file_offset_ = 0;    // Offset of the open chunk
+    std::vector<uint64_t> index_;
+
+    // Sealed chunks waiting for the writer thread
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable drained_;
+    std::deque<std::vector<uint8_t>> pending_;
+    std::vector<std::vector<uint8_t>> spare_;
+    bool stop_ = false;
+    bool failed_ = false;
+    std::thread writer_;
+};
+
+// Zero-copy view of one logged frame, valid while the reader is open
+struct FeatureLogFrame {
+    const FeatureLogFrameHeader* header = nullptr;
+    const LogKeypoint* keypoints = nullptr;
+    const uint8_t* descriptors = nullptr;
+};
+
+// Camera pose relative to the first frame, chained from the logged motions. Each motion
+// maps points of the previous camera into the current one (x_k = R x_k-1 + t), so the
+// camera moves by -R^T t in the previous frame. Positions have the scale of t.
+struct ChainedPose {
+    double rotation[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+    double position[3] = { 0, 0, 0 };
+
+    // Applies the motion of frame; frames without a pose leave the pose unchanged
+    void add(const FeatureLogFrameHeader& frame);
+};
+
+class FeatureLogReader {
+public:
+    // Map the log and load (or, for a truncated log, rebuild) the frame index
+    bool open(const std::string& path);
+    void close();
+
+    size_t frames() const { return offsets_.size(); }
+    FeatureLogFrame frame(size_t i) const;
+
+    // True when the index was rebuilt from the chunks of a log without footer
+    bool recovered() const { return recovered_; }
+
+private:
+    bool scanChunks();
+
+    MappedFile file_;
+    std::vector<uint64_t> offsets_;
+    bool recovered_ = false;
+};
@@ -0,0 +1,66 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// featureLogCv.h : Conversions between OpenCV keypoints / descriptors / poses and the
+// feature log.
+//
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <chrono>
+#include <vector>
+
+#include "featureLog.h"
+#include "frameSource.h"
+
+// Append a frame with its features and, when R and t are set, its pose. keypoint_buffer is
+// reused between calls to avoid an allocation per frame.
+inline void appendFeatureLog(FeatureLogWriter& log, const Frame& frame, const std::vector<cv::KeyPoint>& keypoints,
+    const cv::Mat& descriptors, const cv::Mat& R, const cv::Mat& t, std::vector<LogKeypoint>& keypoint_buffer) {
+    FeatureLogRecord record;
+    record.index = static_cast<uint64_t>(frame.index);
+    record.capture_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(frame.capture_time.time_since_epoch()).count();
+    record.media_time_ms = frame.media_time_ms;
+    if (!R.empty() && !t.empty()) {
+        record.has_pose = true;
+        for (int i = 0; i < 9; ++i) record.rotation[i] = R.at<double>(i / 3, i % 3);
+        for (int i = 0; i < 3; ++i) record.translation[i] = t.at<double>(i);
+    }
+
+    keypoint_buffer.resize(keypoints.size());
+    for (size_t i = 0; i < keypoints.size(); ++i) {
+        const cv::KeyPoint& k = keypoints[i];
+        keypoint_buffer[i] = { k.pt.x, k.pt.y, k.size, k.angle, k.response, k.octave };
+    }
+    record.keypoints = keypoint_buffer.data();
+    record.keypoint_count = static_cast<uint32_t>(keypoints.size());
+
+    // Descriptors are stored only when there is one row per keypoint
+    cv::Mat rows = descriptors.isContinuous() ? descriptors : descriptors.clone();
+    if (!rows.empty() && rows.rows == static_cast<int>(keypoints.size()) &&
+        (rows.depth() == CV_8U || rows.depth() == CV_32F)) {
+        record.descriptor_type = rows.depth() == CV_8U ? DescriptorType::Binary : DescriptorType::Float;
+        record.descriptor_bytes = static_cast<uint16_t>(rows.cols * rows.elemSize());
+        record.descriptors = rows.data;
+    }
+    log.append(record);
+}
+
+inline std::vector<cv::KeyPoint> logKeypoints(const FeatureLogFrame& frame) {
+    std::vector<cv::KeyPoint> keypoints(frame.header->keypoint_count);
+    for (size_t i = 0; i < keypoints.size(); ++i) {
+        const LogKeypoint& k = frame.keypoints[i];
+        keypoints[i] = cv::KeyPoint(k.x, k.y, k.size, k.angle, k.response, k.octave);
+    }
+    return keypoints;
+}
+
+// cv::Mat header over the mapped descriptors (no copy, valid while the reader is open)
+inline cv::Mat logDescriptors(const FeatureLogFrame& frame) {
+    if (!frame.descriptors) return cv::Mat();
+    const bool binary = frame.header->descriptor_type == DescriptorType::Binary;
+    const int element = binary ? 1 : static_cast<int>(sizeof(float));
+    return cv::Mat(static_cast<int>(frame.header->keypoint_count), frame.header->descriptor_bytes / element,
+        binary ? CV_8U : CV_32F, const_cast<uint8_t*>(frame.descriptors));
+}
@@ -0,0 +1,59 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// featureLogTool.cpp : Summary and trajectory of a feature log written by the SLAM
+// programs:
+//
+//   featureLogTool orb_slam.flog              # frames, keypoints, descriptors, duration
+//   featureLogTool orb_slam.flog trajectory   # index, time [s], x y z of the chained poses
+//
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "featureLog.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <log> [trajectory]" << std::endl;
+        return -1;
+    }
+    FeatureLogReader log;
+    if (!log.open(argv[1])) {
+        std::cerr << "Error: Unable to read " << argv[1] << std::endl;
+        return -1;
+    }
+    if (log.frames() == 0) {
+        std::cout << "Empty log" << std::endl;
+        return 0;
+    }
+    const int64_t start_ns = log.frame(0).header->capture_ns;
+
+    if (argc > 2 && std::strcmp(argv[2], "trajectory") == 0) {
+        ChainedPose pose;
+        for (size_t i = 0; i < log.frames(); ++i) {
+            const FeatureLogFrameHeader& frame = *log.frame(i).header;
+            pose.add(frame);
+            std::printf("%llu %.6f %.6f %.6f %.6f\n", static_cast<unsigned long long>(frame.index),
+                (frame.capture_ns - start_ns) * 1e-9, pose.position[0], pose.position[1], pose.position[2]);
+        }
+        return 0;
+    }
+
+    uint64_t keypoints = 0, descriptor_bytes = 0, poses = 0;
+    for (size_t i = 0; i < log.frames(); ++i) {
+        const FeatureLogFrameHeader& frame = *log.frame(i).header;
+        keypoints += frame.keypoint_count;
+        descriptor_bytes += uint64_t(frame.keypoint_count) * frame.descriptor_bytes;
+        poses += (frame.flags & kFeatureLogHasPose) ? 1 : 0;
+    }
+    const FeatureLogFrameHeader& last = *log.frame(log.frames() - 1).header;
+    std::printf("Frames:      %zu%s\n", log.frames(), log.recovered() ? " (index rebuilt, log was not closed)" : "");
+    std::printf("Duration:    %.2f s\n", (last.capture_ns - start_ns) * 1e-9);
+    std::printf("Poses:       %llu\n", static_cast<unsigned long long>(poses));
+    std::printf("Keypoints:   %llu (%.1f per frame)\n", static_cast<unsigned long long>(keypoints),
+        static_cast<double>(keypoints) / log.frames());
+    std::printf("Descriptors: %.1f MB\n", descriptor_bytes / 1048576.0);
+    return 0;
+}
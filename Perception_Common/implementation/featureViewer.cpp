@@ -0,0 +1,90 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// featureViewer.cpp : Live keypoint viewer shared by the ORB and SIFT programs.
+//
+#include "featureViewer.h"
+
+#include <opencv2/opencv.hpp>
+#include <cstdlib>
+#include <iostream>
+
+#include "frameSource.h"
+#include "latencyMeter.h"
+#include "tracing.h"
+
+int runFeatureViewer(int argc, char** argv, DetectorType default_type, const char* program) {
+    // Camera index (default camera 0), video file or image directory, then the detector
+    // (orb, sift or fast) and the per-frame detection budget in ms (0 = fixed parameters)
+    std::string source_path = argc > 1 ? argv[1] : "0";
+    FrontEndConfig front_end_config;
+    front_end_config.type = default_type;
+    if (argc > 2 && !parseDetectorType(argv[2], front_end_config.type)) {
+        std::cerr << "Error: Unknown detector " << argv[2] << " (use orb, sift or fast)" << std::endl;
+        return -1;
+    }
+    if (argc > 3) front_end_config.budget_ms = std::atof(argv[3]);
+
+    // Per-stage timings, enabled with PERCEPTION_TRACE
+    trace::Session tracing(program);
+
+    // Frames are decoded on a background thread; live cameras keep only the newest frame
+    // The decode thread also converts to grayscale and builds the pyramid the detector needs
+    FrameSource source;
+    source.setPyramid(pyramidConfigFor(front_end_config.type));
+    if (!source.open(source_path)) {
+        std::cerr << "Error: Could not open " << source_path << std::endl;
+        return -1;
+    }
+    LatencyMeter latency(program);
+
+    // Detector on the shared pyramid, tuned to stay within the frame budget
+    FeatureFrontEnd front_end(front_end_config);
+    const std::string window_name = std::string(detectorName(front_end_config.type)) + " with Camera";
+
+    while (true) {
+        // Capture a frame from the source, stop at the end of a replay
+        Frame captured;
+        if (!source.read(captured)) {
+            break;
+        }
+        cv::Mat& frame = captured.image;
+        TRACE_SCOPE("frame");
+
+        // Detect keypoints and compute descriptors
+        std::vector<cv::KeyPoint> keypoints;
+        cv::Mat descriptors;
+        {
+            TRACE_SCOPE("detectAndCompute");
+            front_end.detect(*captured.pyramid, keypoints, descriptors);
+        }
+        TRACE_COUNTER("keypoints", keypoints.size());
+
+        // Draw keypoints on the original frame
+        cv::Mat frame_with_keypoints;
+        {
+            TRACE_SCOPE("drawKeypoints");
+            cv::drawKeypoints(frame, keypoints, frame_with_keypoints, cv::Scalar::all(-1), cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
+            cv::putText(frame_with_keypoints, front_end.describe(), cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 255, 255), 1);
+        }
+
+        // Display the frame with keypoints
+        {
+            TRACE_SCOPE("imshow");
+            cv::imshow(window_name, frame_with_keypoints);
+        }
+        latency.addSince(captured.capture_time);
+
+        // Break the loop on pressing 'q'
+        if (cv::waitKey(1) == 'q') {
+            break;
+        }
+    }
+
+    // Release the camera and close windows
+    std::cout << "Dropped frames: " << source.droppedFrames() << std::endl;
+    source.close();
+    cv::destroyAllWindows();
+
+    return 0;
+}
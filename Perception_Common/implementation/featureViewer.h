@@ -0,0 +1,17 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// featureViewer.h : Live keypoint viewer shared by the ORB and SIFT programs.
+//
+#pragma once
+
+#include "featureFrontEnd.h"
+
+// Shows the keypoints of every frame of a source until q is pressed or a replay ends:
+//
+//   program [source] [orb|sift|fast] [budget_ms]
+//
+// source is a camera index (default 0), a video file or an image directory. The detector
+// defaults to default_type; program names the trace session and the latency reports.
+// Returns the exit code of the program.
+int runFeatureViewer(int argc, char** argv, DetectorType default_type, const char* program);
@@ -0,0 +1,177 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// frameSource.cpp : Threaded frame source for cameras, video files and image directories.
+//
+#include "frameSource.h"
+#include "tracing.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+namespace {
+
+bool isCameraIndex(const std::string& source) {
+    return !source.empty() && std::all_of(source.begin(), source.end(),
+        [](unsigned char c) { return std::isdigit(c) != 0; });
+}
+
+bool isImageFile(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tif" || ext == ".tiff" || ext == ".pgm" || ext == ".ppm";
+}
+
+} // namespace
+
+FrameSource::~FrameSource() {
+    close();
+}
+
+void FrameSource::setPyramid(const PyramidConfig& config) {
+    pyramid_pool_.reset(new PyramidPool(config));
+}
+
+void FrameSource::setRealtime(bool realtime, double fallback_fps) {
+    realtime_ = realtime;
+    fallback_fps_ = fallback_fps > 0.0 ? fallback_fps : 30.0;
+}
+
+bool FrameSource::open(const std::string& source, FrameSourceMode mode, size_t queue_depth) {
+    close();
+
+    const bool camera = isCameraIndex(source);
+    std::error_code ec;
+    if (camera) {
+        capture_.open(std::stoi(source));
+        if (!capture_.isOpened()) return false;
+    }
+    else if (std::filesystem::is_directory(source, ec)) {
+        for (const auto& entry : std::filesystem::directory_iterator(source, ec)) {
+            if (entry.is_regular_file() && isImageFile(entry.path())) images_.push_back(entry.path().string());
+        }
+        std::sort(images_.begin(), images_.end());
+        if (images_.empty()) return false;
+    }
+    else {
+        capture_.open(source);
+        if (!capture_.isOpened()) return false;
+    }
+
+    mode_ = mode != FrameSourceMode::Auto ? mode : (camera ? FrameSourceMode::LatestOnly : FrameSourceMode::Lossless);
+    capacity_ = mode_ == FrameSourceMode::LatestOnly ? 1 : std::max<size_t>(queue_depth, 1);
+    pace_ = realtime_ && !camera;
+    replay_start_ = std::chrono::steady_clock::now();
+    opened_ = true;
+    running_ = true;
+    thread_ = std::thread(&FrameSource::decodeLoop, this);
+    return true;
+}
+
+void FrameSource::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    space_ready_.notify_all();
+    frame_ready_.notify_all();
+    if (thread_.joinable()) thread_.join();
+
+    capture_.release();
+    images_.clear();
+    queue_.clear();
+    next_image_ = 0;
+    next_index_ = 0;
+    end_of_stream_ = false;
+    opened_ = false;
+    dropped_ = 0;
+}
+
+bool FrameSource::grab(Frame& frame) {
+    if (!images_.empty()) {
+        TRACE_SCOPE("imread");
+        // Unreadable files are skipped rather than ending the replay
+        while (next_image_ < images_.size()) {
+            frame.image = cv::imread(images_[next_image_++], cv::IMREAD_COLOR);
+            if (pace_) std::this_thread::sleep_until(replay_start_ + std::chrono::microseconds(static_cast<int64_t>(next_index_ * 1e6 / fallback_fps_)));
+            frame.capture_time = std::chrono::steady_clock::now();
+            frame.index = next_index_++;
+            if (!frame.image.empty()) return true;
+        }
+        return false;
+    }
+
+    // Timestamp right after grab(), before the (slower) decode in retrieve()
+    {
+        TRACE_SCOPE("grab");
+        if (!capture_.grab()) return false;
+    }
+    frame.media_time_ms = capture_.get(cv::CAP_PROP_POS_MSEC);
+    if (pace_) std::this_thread::sleep_until(replay_start_ + std::chrono::microseconds(static_cast<int64_t>(frame.media_time_ms * 1000.0)));
+    frame.capture_time = std::chrono::steady_clock::now();
+    frame.index = next_index_++;
+    TRACE_SCOPE("retrieve");
+    return capture_.retrieve(frame.image) && !frame.image.empty();
+}
+
+void FrameSource::decodeLoop() {
+    trace::setThreadName("decode");
+    while (true) {
+        Frame frame;
+        const bool ok = grab(frame);
+
+        // Convert and build the pyramid here, off the consumer's critical path
+        if (ok && pyramid_pool_ && frame.image.type() == CV_8UC3) {
+            frame.pyramid = pyramid_pool_->build(frame.image.data, frame.image.cols, frame.image.rows, frame.image.step);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!running_) return;
+        if (!ok) {
+            end_of_stream_ = true;
+            frame_ready_.notify_all();
+            return;
+        }
+
+        if (mode_ == FrameSourceMode::Lossless) {
+            space_ready_.wait(lock, [this] { return !running_ || queue_.size() < capacity_; });
+            if (!running_) return;
+        }
+        else if (queue_.size() >= capacity_) {
+            queue_.pop_front(); // Latest frame wins
+            dropped_++;
+            TRACE_COUNTER("dropped_frames", dropped_.load());
+        }
+        queue_.push_back(std::move(frame));
+        frame_ready_.notify_one();
+    }
+}
+
+bool FrameSource::read(Frame& frame) {
+    TRACE_SCOPE("wait_frame");
+    std::unique_lock<std::mutex> lock(mutex_);
+    frame_ready_.wait(lock, [this] { return !queue_.empty() || end_of_stream_ || !running_; });
+    if (queue_.empty()) return false;
+
+    frame = std::move(queue_.front());
+    queue_.pop_front();
+    space_ready_.notify_one();
+    return true;
+}
+
+bool FrameSource::tryRead(Frame& frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty()) return false;
+    frame = std::move(queue_.front());
+    queue_.pop_front();
+    space_ready_.notify_one();
+    return true;
+}
+
+bool FrameSource::finished() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.empty() && (end_of_stream_ || !running_);
+}
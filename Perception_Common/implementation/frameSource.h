@@ -0,0 +1,96 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// frameSource.h : Threaded frame source for cameras, video files and image directories.
+//
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "imagePyramid.h"
+
+struct Frame {
+    cv::Mat image;
+    int64_t index = -1;                                // Position in the source, counting dropped frames
+    std::chrono::steady_clock::time_point capture_time; // When the frame was grabbed from the source
+    double media_time_ms = 0.0;                        // Timestamp inside a video file, 0 otherwise
+    std::shared_ptr<const ImagePyramid> pyramid;       // Set when the source builds pyramids
+};
+
+enum class FrameSourceMode {
+    Auto,       // LatestOnly for cameras, Lossless for files and directories
+    LatestOnly, // Real time: keep only the newest frame, older ones are dropped
+    Lossless    // Replay: every frame is delivered, decoding waits for the consumer
+};
+
+// Decodes frames on a dedicated thread so a slow consumer never backs up the camera
+// driver. Sources are a camera index ("0"), a video file, or a directory of images
+// (read in file name order).
+class FrameSource {
+public:
+    FrameSource() = default;
+    ~FrameSource();
+
+    FrameSource(const FrameSource&) = delete;
+    FrameSource& operator=(const FrameSource&) = delete;
+
+    // Build a grayscale pyramid of every frame on the decode thread (call before open)
+    void setPyramid(const PyramidConfig& config);
+
+    // Deliver video files and image directories at their recorded rate (image directories
+    // at fallback_fps), like a live camera; call before open
+    void setRealtime(bool realtime, double fallback_fps = 30.0);
+
+    bool open(const std::string& source, FrameSourceMode mode = FrameSourceMode::Auto, size_t queue_depth = 8);
+    bool isOpened() const { return opened_; }
+    void close();
+
+    // Blocks until the next frame is available. Returns false at the end of the stream.
+    bool read(Frame& frame);
+
+    // Takes the next frame if one is waiting, without blocking
+    bool tryRead(Frame& frame);
+    // True once the stream has ended and every frame was read
+    bool finished();
+
+    FrameSourceMode mode() const { return mode_; }
+    uint64_t droppedFrames() const { return dropped_.load(); }
+
+private:
+    bool grab(Frame& frame);
+    void decodeLoop();
+
+    cv::VideoCapture capture_;
+    std::vector<std::string> images_;
+    size_t next_image_ = 0;
+    int64_t next_index_ = 0;
+
+    FrameSourceMode mode_ = FrameSourceMode::LatestOnly;
+    size_t capacity_ = 1;
+    bool realtime_ = false;
+    bool pace_ = false; // realtime_ and not a camera
+    double fallback_fps_ = 30.0;
+    std::chrono::steady_clock::time_point replay_start_;
+    std::unique_ptr<PyramidPool> pyramid_pool_;
+    bool opened_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable frame_ready_, space_ready_;
+    std::deque<Frame> queue_;
+    bool running_ = false;
+    bool end_of_stream_ = false;
+    std::atomic<uint64_t> dropped_{ 0 };
+    std::thread thread_;
+};
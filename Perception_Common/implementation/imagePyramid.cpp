@@ -0,0 +1,293 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// imagePyramid.cpp : Per-frame grayscale conversion and image pyramid in pooled buffers,
+// built once and shared by all detectors of a frame.
+//
+#include "imagePyramid.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cmath>
+
+// With AVX-512 the compiler vectorizes the scalar loop with wider registers than the
+// SSSE3 kernel and is as fast, so the kernel is only used below that.
+#if defined(__SSSE3__) && !defined(__AVX512BW__)
+#define PYRAMID_GRAY_SSSE3
+#include <tmmintrin.h>
+#endif
+
+namespace {
+
+// cv::cvtColor BGR2GRAY coefficients, 14-bit fixed point
+const int kGrayShift = 14;
+const int kBlue = 1868, kGreen = 9617, kRed = 4899;
+const int kRound = 1 << (kGrayShift - 1);
+
+const int kResizeBits = 11;
+const int kResizeOne = 1 << kResizeBits;
+
+const size_t kRowAlignment = 64;
+
+void bgrToGrayRowScalar(const uint8_t* src, uint8_t* dst, int begin, int width) {
+    for (int x = begin; x < width; ++x) {
+        const uint8_t* p = src + 3 * x;
+        dst[x] = static_cast<uint8_t>((p[0] * kBlue + p[1] * kGreen + p[2] * kRed + kRound) >> kGrayShift);
+    }
+}
+
+#if defined(PYRAMID_GRAY_SSSE3)
+// 16 pixels per iteration: deinterleave B, G, R with pshufb, then two pmaddwd per four
+// pixels compute B*cb + G*cg and R*cr + round in 32 bits.
+void bgrToGrayRowSsse3(const uint8_t* src, uint8_t* dst, int width) {
+    const __m128i b0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i r0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+    const __m128i coeff_bg = _mm_set1_epi32((kGreen << 16) | kBlue);
+    const __m128i coeff_r1 = _mm_set1_epi32((kRound << 16) | kRed);
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i zero = _mm_setzero_si128();
+
+    auto weigh = [&](__m128i b, __m128i g, __m128i r) {
+        __m128i sum = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(b, g), coeff_bg),
+            _mm_madd_epi16(_mm_unpacklo_epi16(r, ones), coeff_r1));
+        __m128i lo = _mm_srai_epi32(sum, kGrayShift);
+        sum = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(b, g), coeff_bg),
+            _mm_madd_epi16(_mm_unpackhi_epi16(r, ones), coeff_r1));
+        return _mm_packs_epi32(lo, _mm_srai_epi32(sum, kGrayShift));
+    };
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t* p = src + 3 * x;
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+        const __m128i blue = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, b0), _mm_shuffle_epi8(b, b1)), _mm_shuffle_epi8(c, b2));
+        const __m128i green = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, g0), _mm_shuffle_epi8(b, g1)), _mm_shuffle_epi8(c, g2));
+        const __m128i red = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, r0), _mm_shuffle_epi8(b, r1)), _mm_shuffle_epi8(c, r2));
+
+        const __m128i lo = weigh(_mm_unpacklo_epi8(blue, zero), _mm_unpacklo_epi8(green, zero), _mm_unpacklo_epi8(red, zero));
+        const __m128i hi = weigh(_mm_unpackhi_epi8(blue, zero), _mm_unpackhi_epi8(green, zero), _mm_unpackhi_epi8(red, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(lo, hi));
+    }
+    bgrToGrayRowScalar(src, dst, x, width);
+}
+#endif
+
+// Source index and weight of each destination column or row (cv::resize INTER_LINEAR)
+void linearTaps(int src_size, int dst_size, std::vector<int>& index, std::vector<int>& weight) {
+    const double scale = static_cast<double>(src_size) / dst_size;
+    index.resize(dst_size);
+    weight.resize(dst_size);
+    for (int d = 0; d < dst_size; ++d) {
+        double f = (d + 0.5) * scale - 0.5;
+        int s = static_cast<int>(std::floor(f));
+        f -= s;
+        if (s < 0) {
+            s = 0;
+            f = 0.0;
+        }
+        if (s >= src_size - 1) {
+            s = src_size - 1;
+            f = 0.0;
+        }
+        index[d] = s;
+        weight[d] = static_cast<int>(std::lround(f * kResizeOne));
+    }
+}
+
+// resize() that reports whether the vector had to grow
+template <typename T>
+bool grow(std::vector<T>& values, size_t size) {
+    const bool allocated = values.capacity() < size;
+    values.resize(size);
+    return allocated;
+}
+
+size_t alignedStride(int width) {
+    return (static_cast<size_t>(width) + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+}
+
+} // namespace
+
+void bgrToGrayScalar(const uint8_t* bgr, size_t bgr_stride, uint8_t* gray, size_t gray_stride, int width, int height) {
+    for (int y = 0; y < height; ++y) {
+        bgrToGrayRowScalar(bgr + y * bgr_stride, gray + y * gray_stride, 0, width);
+    }
+}
+
+void bgrToGray(const uint8_t* bgr, size_t bgr_stride, uint8_t* gray, size_t gray_stride, int width, int height) {
+#if defined(PYRAMID_GRAY_SSSE3)
+    for (int y = 0; y < height; ++y) {
+        bgrToGrayRowSsse3(bgr + y * bgr_stride, gray + y * gray_stride, width);
+    }
+#else
+    bgrToGrayScalar(bgr, bgr_stride, gray, gray_stride, width, height);
+#endif
+}
+
+bool BilinearTaps::reset(int new_src_width, int new_src_height, int new_dst_width, int new_dst_height) {
+    if (new_src_width == src_width && new_src_height == src_height && new_dst_width == dst_width
+        && new_dst_height == dst_height) {
+        return false;
+    }
+    src_width = new_src_width;
+    src_height = new_src_height;
+    dst_width = new_dst_width;
+    dst_height = new_dst_height;
+
+    bool allocated = xs.capacity() < static_cast<size_t>(dst_width) || ys.capacity() < static_cast<size_t>(dst_height);
+    linearTaps(src_width, dst_width, xs, ax);
+    linearTaps(src_height, dst_height, ys, ay);
+    // Taps are clamped so that index + 1 stays inside the row (weight 0 at the border)
+    for (int x = 0; x < dst_width; ++x) {
+        if (xs[x] >= src_width - 1) {
+            xs[x] = std::max(src_width - 2, 0);
+            ax[x] = src_width > 1 ? kResizeOne : 0;
+        }
+    }
+    allocated |= grow(rows[0], dst_width);
+    allocated |= grow(rows[1], dst_width);
+    return allocated;
+}
+
+void resizeBilinear(const GrayView& src, uint8_t* dst, int dst_width, int dst_height, size_t dst_stride) {
+    BilinearTaps taps;
+    taps.reset(src.width, src.height, dst_width, dst_height);
+    resizeBilinear(src, dst, dst_stride, taps);
+}
+
+void resizeBilinear(const GrayView& src, uint8_t* dst, size_t dst_stride, BilinearTaps& taps) {
+    const int dst_width = taps.dst_width, dst_height = taps.dst_height;
+    const std::vector<int>& ys = taps.ys;
+    const std::vector<int>& ay = taps.ay;
+
+    // Horizontally filtered source rows, scaled by kResizeOne; two rows cached
+    std::vector<int>* rows = taps.rows;
+    int cached[2] = { -1, -1 };
+    auto horizontal = [&](int sy, std::vector<int>& out) {
+        const uint8_t* __restrict s = src.row(sy);
+        const int* __restrict index = taps.xs.data();
+        const int* __restrict weight = taps.ax.data();
+        int* __restrict o = out.data();
+        const int step = src.width > 1 ? 1 : 0;
+        for (int x = 0; x < dst_width; ++x) {
+            const int i = index[x];
+            o[x] = s[i] * kResizeOne + (s[i + step] - s[i]) * weight[x];
+        }
+    };
+
+    for (int y = 0; y < dst_height; ++y) {
+        const int sy0 = ys[y], sy1 = std::min(ys[y] + 1, src.height - 1);
+        int* top = nullptr;
+        int* bottom = nullptr;
+        for (int k = 0; k < 2; ++k) {
+            if (cached[k] == sy0) top = rows[k].data();
+            if (cached[k] == sy1) bottom = rows[k].data();
+        }
+        if (!top) {
+            const int k = (cached[0] == sy1) ? 1 : 0;
+            horizontal(sy0, rows[k]);
+            cached[k] = sy0;
+            top = rows[k].data();
+        }
+        if (!bottom) {
+            const int k = (cached[0] == sy0) ? 1 : 0;
+            horizontal(sy1, rows[k]);
+            cached[k] = sy1;
+            bottom = rows[k].data();
+        }
+
+        const int wb = ay[y], wt = kResizeOne - wb;
+        const int* __restrict t = top;
+        const int* __restrict b = bottom;
+        uint8_t* __restrict d = dst + y * dst_stride;
+        for (int x = 0; x < dst_width; ++x) {
+            d[x] = static_cast<uint8_t>((t[x] * wt + b[x] * wb + (1 << (2 * kResizeBits - 1))) >> (2 * kResizeBits));
+        }
+    }
+}
+
+bool ImagePyramid::reset(const PyramidConfig& config, int width, int height) {
+    const int count = std::max(config.levels, 1);
+    bool allocated = grow(levels_, count);
+    allocated |= grow(scales_, count);
+    allocated |= grow(offsets_, count);
+    allocated |= grow(taps_, count - 1);
+
+    // Level sizes follow cv::ORB: round(size / scale^i)
+    size_t total = 0;
+    for (int i = 0; i < count; ++i) {
+        const float factor = std::pow(config.scale, static_cast<float>(i));
+        GrayView& view = levels_[i];
+        view.width = std::max(1, static_cast<int>(std::lround(width / factor)));
+        view.height = std::max(1, static_cast<int>(std::lround(height / factor)));
+        view.stride = alignedStride(view.width);
+        scales_[i] = factor;
+        offsets_[i] = total;
+        total += view.stride * view.height;
+        if (i > 0) allocated |= taps_[i - 1].reset(levels_[i - 1].width, levels_[i - 1].height, view.width, view.height);
+    }
+
+    if (storage_.size() < total + kRowAlignment) {
+        storage_.resize(total + kRowAlignment);
+        allocated = true;
+    }
+
+    uint8_t* base = storage_.data();
+    base += (kRowAlignment - reinterpret_cast<uintptr_t>(base) % kRowAlignment) % kRowAlignment;
+    bytes_ = 0;
+    for (int i = 0; i < count; ++i) {
+        levels_[i].data = base + offsets_[i];
+        bytes_ += static_cast<size_t>(levels_[i].width) * levels_[i].height;
+    }
+    return allocated;
+}
+
+PyramidPool::PyramidPool(PyramidConfig config)
+    : config_(config), shared_(std::make_shared<Shared>()) {
+}
+
+size_t PyramidPool::allocations() const {
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    return shared_->allocations;
+}
+
+std::shared_ptr<const ImagePyramid> PyramidPool::build(const uint8_t* bgr, int width, int height, size_t stride) {
+    TRACE_SCOPE("pyramid");
+    std::unique_ptr<ImagePyramid> pyramid;
+    {
+        std::lock_guard<std::mutex> lock(shared_->mutex);
+        if (!shared_->free.empty()) {
+            pyramid = std::move(shared_->free.back());
+            shared_->free.pop_back();
+        }
+    }
+    if (!pyramid) pyramid.reset(new ImagePyramid());
+
+    if (pyramid->reset(config_, width, height)) {
+        std::lock_guard<std::mutex> lock(shared_->mutex);
+        shared_->allocations++;
+    }
+
+    const GrayView& gray = pyramid->levels_[0];
+    bgrToGray(bgr, stride, const_cast<uint8_t*>(gray.data), gray.stride, width, height);
+    for (int i = 1; i < pyramid->levels(); ++i) {
+        const GrayView& level = pyramid->levels_[i];
+        resizeBilinear(pyramid->levels_[i - 1], const_cast<uint8_t*>(level.data), level.stride, pyramid->taps_[i - 1]);
+    }
+
+    // Hand the buffer back to the pool instead of freeing it
+    std::shared_ptr<Shared> shared = shared_;
+    return std::shared_ptr<const ImagePyramid>(pyramid.release(), [shared](const ImagePyramid* p) {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->free.emplace_back(const_cast<ImagePyramid*>(p));
+    });
+}
@@ -0,0 +1,104 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// imagePyramid.h : Per-frame grayscale conversion and image pyramid in pooled buffers,
+// built once and shared by all detectors of a frame.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Non-owning view of an 8-bit single channel image
+struct GrayView {
+    const uint8_t* data = nullptr;
+    int width = 0;
+    int height = 0;
+    size_t stride = 0; // Bytes between rows
+
+    const uint8_t* row(int y) const { return data + y * stride; }
+};
+
+// BGR to gray with the BT.601 weights and 14-bit fixed point rounding of cv::cvtColor, so
+// results are bit-exact with OpenCV. Uses SSSE3 when available and AVX-512 is not.
+void bgrToGray(const uint8_t* bgr, size_t bgr_stride, uint8_t* gray, size_t gray_stride, int width, int height);
+
+// Scalar reference of bgrToGray()
+void bgrToGrayScalar(const uint8_t* bgr, size_t bgr_stride, uint8_t* gray, size_t gray_stride, int width, int height);
+
+// Source columns and rows with their weights for one resizeBilinear() size pair, and the
+// two horizontally filtered rows it keeps. Depends only on the sizes, so a pyramid
+// computes it once per level.
+struct BilinearTaps {
+    int src_width = 0, src_height = 0, dst_width = 0, dst_height = 0;
+    std::vector<int> xs, ax, ys, ay;
+    std::vector<int> rows[2];
+
+    // Recompute for new sizes, nothing to do if they are unchanged. Returns true if memory
+    // had to be allocated.
+    bool reset(int src_width, int src_height, int dst_width, int dst_height);
+};
+
+// Bilinear downscale with the pixel-center alignment of cv::resize(INTER_LINEAR). The
+// first form computes the taps on every call.
+void resizeBilinear(const GrayView& src, uint8_t* dst, int dst_width, int dst_height, size_t dst_stride);
+void resizeBilinear(const GrayView& src, uint8_t* dst, size_t dst_stride, BilinearTaps& taps);
+
+struct PyramidConfig {
+    int levels = 8;      // Level 0 is the full resolution grayscale frame
+    float scale = 1.2f;  // Size ratio between consecutive levels (ORB default)
+};
+
+class ImagePyramid {
+public:
+    int levels() const { return static_cast<int>(levels_.size()); }
+    const GrayView& level(int i) const { return levels_[i]; }
+    const GrayView& gray() const { return levels_[0]; }
+
+    // Factor from level i coordinates to level 0 coordinates
+    float scale(int i) const { return scales_[i]; }
+
+    // Bytes written to build the pyramid (all levels)
+    size_t bytes() const { return bytes_; }
+
+private:
+    friend class PyramidPool;
+
+    // Lay out the levels and resize taps for a frame size; reuses the buffers when they
+    // are large enough. Returns true if memory had to be allocated.
+    bool reset(const PyramidConfig& config, int width, int height);
+
+    std::vector<uint8_t> storage_;
+    std::vector<GrayView> levels_;
+    std::vector<float> scales_;
+    std::vector<size_t> offsets_;
+    std::vector<BilinearTaps> taps_; // taps_[i - 1] builds level i from level i - 1
+    size_t bytes_ = 0;
+};
+
+// Builds pyramids into recycled buffers. A pyramid returns to the pool when the last
+// shared_ptr to it is released, so consumers on other threads can keep it as long as they
+// need. Once warm, building a pyramid performs no allocation.
+class PyramidPool {
+public:
+    explicit PyramidPool(PyramidConfig config = PyramidConfig());
+
+    std::shared_ptr<const ImagePyramid> build(const uint8_t* bgr, int width, int height, size_t stride);
+
+    const PyramidConfig& config() const { return config_; }
+    // Pyramids, level buffers or resize taps allocated so far; stays constant once warm
+    size_t allocations() const;
+
+private:
+    struct Shared {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ImagePyramid>> free;
+        size_t allocations = 0;
+    };
+
+    PyramidConfig config_;
+    std::shared_ptr<Shared> shared_;
+};
@@ -0,0 +1,36 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// latencyMeter.cpp : Glass-to-result latency statistics printed at a fixed frame interval.
+//
+#include "latencyMeter.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cstdio>
+
+LatencyMeter::LatencyMeter(std::string name, size_t report_every)
+    : name_(std::move(name)), report_every_(std::max<size_t>(report_every, 1)) {
+    samples_.reserve(report_every_);
+}
+
+void LatencyMeter::addSince(std::chrono::steady_clock::time_point capture_time) {
+    add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - capture_time).count());
+}
+
+void LatencyMeter::add(double ms) {
+    TRACE_COUNTER("glass_to_result_ms", ms);
+    samples_.push_back(ms);
+    if (samples_.size() >= report_every_) {
+        report();
+        samples_.clear();
+    }
+}
+
+void LatencyMeter::report() {
+    std::sort(samples_.begin(), samples_.end());
+    const double p50 = samples_[samples_.size() / 2];
+    const double p99 = samples_[(samples_.size() * 99) / 100];
+    std::printf("[%s] glass-to-result latency over %zu frames: p50 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+        name_.c_str(), samples_.size(), p50, p99, samples_.back());
+}
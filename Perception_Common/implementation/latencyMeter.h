@@ -0,0 +1,27 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// latencyMeter.h : Glass-to-result latency statistics printed at a fixed frame interval.
+//
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class LatencyMeter {
+public:
+    explicit LatencyMeter(std::string name, size_t report_every = 100);
+
+    // Record the time from capture_time to now; prints p50 / p99 / max every report_every frames
+    void addSince(std::chrono::steady_clock::time_point capture_time);
+    void add(double ms);
+
+private:
+    void report();
+
+    std::string name_;
+    size_t report_every_;
+    std::vector<double> samples_;
+};
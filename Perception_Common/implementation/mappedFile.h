@@ -0,0 +1,35 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// mappedFile.h : Read-only memory mapping of a whole file (POSIX and Win32).
+//
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map path read-only and shared, so every process mapping the same file uses the
+    // same page cache pages. Returns false if the file cannot be opened or mapped.
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+    const char* data() const { return static_cast<const char*>(data_); }
+    size_t size() const { return size_; }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
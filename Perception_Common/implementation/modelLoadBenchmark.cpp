@@ -0,0 +1,75 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// modelLoadBenchmark.cpp : Load time and resident memory of the dlib face models, loaded
+// from the .dat files or from the memory-mapped cache. Run each mode in its own process
+// so the RSS numbers are not polluted by the other mode. The RSS after the first descriptor
+// includes the mapped ResNet weights, of which "shared" is the part other processes mapping
+// the cache use as well (faceNetShareBenchmark measures N processes):
+//
+//   modelLoadBenchmark build   # deserialize the .dat files and write the cache
+//   modelLoadBenchmark dat     # deserialize the .dat files
+//   modelLoadBenchmark cache   # load from the cache
+//
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "faceModels.h"
+#include "processStats.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <build|dat|cache> [shape_predictor.dat] [resnet.dat] [cache]" << std::endl;
+        return -1;
+    }
+    const std::string mode = argv[1];
+    const std::string shape_path = argc > 2 ? argv[2] : "shape_predictor_68_face_landmarks.dat";
+    const std::string net_path = argc > 3 ? argv[3] : "dlib_face_recognition_resnet_model_v1.dat";
+    const std::string cache_path = argc > 4 ? argv[4] : "face_models.cache";
+
+    const double rss_before = residentSetBytes() / 1048576.0;
+    auto start = std::chrono::steady_clock::now();
+
+    std::shared_ptr<FaceModels> models;
+    if (mode == "dat" || mode == "build") {
+        models = loadFaceModels(shape_path, net_path, "");
+    }
+    else if (mode == "cache") {
+        models = readFaceModelCache(shape_path, net_path, cache_path);
+        if (!models) {
+            std::cerr << "Error: Cache " << cache_path << " is missing or stale, run the build mode first." << std::endl;
+            return -1;
+        }
+    }
+    else {
+        std::cerr << "Error: Unknown mode " << mode << std::endl;
+        return -1;
+    }
+    const double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    const double rss_after = residentSetBytes() / 1048576.0;
+
+    if (mode == "build") {
+        start = std::chrono::steady_clock::now();
+        if (!writeFaceModelCache(*models, shape_path, net_path, cache_path)) {
+            std::cerr << "Error: Could not write " << cache_path << std::endl;
+            return -1;
+        }
+        const double write_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::printf("cache written in %.1f ms\n", write_ms);
+    }
+
+    // One forward pass makes sure the restored network is usable
+    dlib::matrix<dlib::rgb_pixel> chip(150, 150);
+    dlib::assign_all_pixels(chip, dlib::rgb_pixel(128, 128, 128));
+    FaceEncoder encoder(*models);
+    dlib::matrix<float, 0, 1> embedding = encoder(chip);
+    const double rss_used = residentSetBytes() / 1048576.0;
+    const double shared = sharedResidentBytes() / 1048576.0;
+
+    std::printf("mode %-6s load %8.1f ms   RSS %7.1f MB -> %7.1f MB, %7.1f MB after a descriptor (%.1f MB shared)   embedding[0] %.6f\n",
+        mode.c_str(), load_ms, rss_before, rss_after, rss_used, shared, embedding(0));
+    return 0;
+}
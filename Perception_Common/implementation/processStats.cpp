@@ -0,0 +1,47 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// processStats.cpp : Process-level measurements used by the startup and memory reports.
+//
+#include "processStats.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+size_t residentSetBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.WorkingSetSize;
+#else
+    // Second field of /proc/self/statm is the resident page count
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    long pages = 0, resident = 0;
+    int fields = std::fscanf(file, "%ld %ld", &pages, &resident);
+    std::fclose(file);
+    if (fields != 2) return 0;
+    return static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+size_t sharedResidentBytes() {
+#ifdef _WIN32
+    return 0;
+#else
+    // Third field of /proc/self/statm is the resident file-backed (shared) page count
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    long pages = 0, resident = 0, shared = 0;
+    int fields = std::fscanf(file, "%ld %ld %ld", &pages, &resident, &shared);
+    std::fclose(file);
+    if (fields != 3) return 0;
+    return static_cast<size_t>(shared) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
@@ -0,0 +1,16 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// processStats.h : Process-level measurements used by the startup and memory reports.
+//
+#pragma once
+
+#include <cstddef>
+
+// Current resident set size of this process in bytes, or 0 if unavailable
+size_t residentSetBytes();
+
+// Part of the resident set backed by files, such as a shared read-only mapping, which
+// every process mapping the same file counts although the pages exist once. 0 if
+// unavailable (Windows).
+size_t sharedResidentBytes();
@@ -0,0 +1,108 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// pyramidFeatures.cpp : OpenCV views of a shared ImagePyramid and ORB / FAST+BRIEF detection on it.
+//
+#include "pyramidFeatures.h"
+
+#include <opencv2/opencv_modules.hpp>
+#ifdef HAVE_OPENCV_XFEATURES2D
+#include <opencv2/xfeatures2d.hpp>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Geometric split of the budget over the first levels, as in cv::ORB
+std::vector<int> levelBudgets(const ImagePyramid& pyramid, int levels, int nfeatures) {
+    levels = levels > 0 ? std::min(levels, pyramid.levels()) : pyramid.levels();
+    const double factor = levels > 1 ? 1.0 / pyramid.scale(1) : 1.0;
+    double per_level = levels > 1 ? nfeatures * (1.0 - factor) / (1.0 - std::pow(factor, levels)) : nfeatures;
+
+    std::vector<int> budgets(levels);
+    int assigned = 0;
+    for (int i = 0; i < levels; ++i) {
+        budgets[i] = i == levels - 1 ? std::max(nfeatures - assigned, 0) : static_cast<int>(std::lround(per_level));
+        per_level *= factor;
+        assigned += budgets[i];
+    }
+    return budgets;
+}
+
+// Map level keypoints to level 0 coordinates and collect their descriptors
+void appendLevel(const ImagePyramid& pyramid, int level, const std::vector<cv::KeyPoint>& level_keypoints,
+    const cv::Mat& level_descriptors, std::vector<cv::KeyPoint>& keypoints, std::vector<cv::Mat>& all_descriptors) {
+    const float scale = pyramid.scale(level);
+    for (cv::KeyPoint keypoint : level_keypoints) {
+        keypoint.pt *= scale;
+        keypoint.size *= scale;
+        keypoint.octave = level;
+        keypoints.push_back(keypoint);
+    }
+    if (!level_descriptors.empty()) all_descriptors.push_back(level_descriptors.clone());
+}
+
+} // namespace
+
+void detectOrbOnPyramid(cv::ORB& orb, const ImagePyramid& pyramid, int nfeatures,
+    std::vector<cv::KeyPoint>& keypoints, cv::Mat& descriptors, int levels) {
+    keypoints.clear();
+    descriptors.release();
+
+    // The caller's settings are restored on return, also if OpenCV throws
+    struct Restore {
+        cv::ORB& orb;
+        int levels, features;
+        ~Restore() {
+            orb.setNLevels(levels);
+            orb.setMaxFeatures(features);
+        }
+    } restore{ orb, orb.getNLevels(), orb.getMaxFeatures() };
+    orb.setNLevels(1);
+
+    const std::vector<int> budgets = levelBudgets(pyramid, levels, nfeatures);
+    std::vector<cv::KeyPoint> level_keypoints;
+    cv::Mat level_descriptors;
+    std::vector<cv::Mat> all_descriptors;
+    for (int i = 0; i < static_cast<int>(budgets.size()); ++i) {
+        if (budgets[i] <= 0) continue;
+        orb.setMaxFeatures(budgets[i]);
+        orb.detectAndCompute(asMat(pyramid.level(i)), cv::noArray(), level_keypoints, level_descriptors);
+        appendLevel(pyramid, i, level_keypoints, level_descriptors, keypoints, all_descriptors);
+    }
+    if (!all_descriptors.empty()) cv::vconcat(all_descriptors, descriptors);
+}
+
+void detectFastBriefOnPyramid(const ImagePyramid& pyramid, int nfeatures, int threshold,
+    std::vector<cv::KeyPoint>& keypoints, cv::Mat& descriptors, int levels) {
+    keypoints.clear();
+    descriptors.release();
+
+    cv::Ptr<cv::FastFeatureDetector> fast = cv::FastFeatureDetector::create(threshold, true);
+#ifdef HAVE_OPENCV_XFEATURES2D
+    static const cv::Ptr<cv::DescriptorExtractor> brief = cv::xfeatures2d::BriefDescriptorExtractor::create(32);
+#else
+    // Without opencv_contrib, upright rBRIEF: the ORB sampling pattern without orientation
+    static const cv::Ptr<cv::DescriptorExtractor> brief = cv::ORB::create();
+#endif
+
+    const std::vector<int> budgets = levelBudgets(pyramid, levels, nfeatures);
+    std::vector<cv::KeyPoint> level_keypoints;
+    cv::Mat level_descriptors;
+    std::vector<cv::Mat> all_descriptors;
+    for (int i = 0; i < static_cast<int>(budgets.size()); ++i) {
+        if (budgets[i] <= 0) continue;
+        const cv::Mat level = asMat(pyramid.level(i));
+        fast->detect(level, level_keypoints);
+        cv::KeyPointsFilter::retainBest(level_keypoints, budgets[i]);
+        for (cv::KeyPoint& keypoint : level_keypoints) {
+            keypoint.angle = 0.0f;
+            keypoint.size = 31.0f;
+        }
+        brief->compute(level, level_keypoints, level_descriptors);
+        appendLevel(pyramid, i, level_keypoints, level_descriptors, keypoints, all_descriptors);
+    }
+    if (!all_descriptors.empty()) cv::vconcat(all_descriptors, descriptors);
+}
@@ -0,0 +1,33 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// pyramidFeatures.h : OpenCV views of a shared ImagePyramid and ORB / FAST+BRIEF detection on it.
+//
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+#include <vector>
+
+#include "imagePyramid.h"
+
+// cv::Mat header over a pyramid level (no copy)
+inline cv::Mat asMat(const GrayView& view) {
+    return cv::Mat(view.height, view.width, CV_8UC1, const_cast<uint8_t*>(view.data), view.stride);
+}
+
+// ORB on the shared pyramid instead of cv::ORB's own: each level is detected with a
+// single-level ORB, the feature budget is split across levels like cv::ORB does, and
+// keypoints are mapped back to level 0 coordinates (octave = level). levels limits the
+// number of pyramid levels used (0 = all). The other settings of orb are used as they are;
+// its level count and feature budget are changed during the call and restored after it.
+void detectOrbOnPyramid(cv::ORB& orb, const ImagePyramid& pyramid, int nfeatures,
+    std::vector<cv::KeyPoint>& keypoints, cv::Mat& descriptors, int levels = 0);
+
+// FAST corners with non-maximum suppression and BRIEF descriptors on the shared pyramid,
+// strongest nfeatures split across levels like detectOrbOnPyramid(). Cheaper than ORB
+// (no orientation, no Harris score) but not rotation invariant. Uses the opencv_contrib
+// BRIEF extractor when available, otherwise upright ORB descriptors.
+void detectFastBriefOnPyramid(const ImagePyramid& pyramid, int nfeatures, int threshold,
+    std::vector<cv::KeyPoint>& keypoints, cv::Mat& descriptors, int levels = 0);
@@ -0,0 +1,746 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// quantizedFaceNet.cpp : int8 inference of the dlib face ResNet, with a float reference
+// of the same network for calibration and comparison.
+//
+// Activations are NHWC. The int8 tensors keep a one pixel zero border, so the 3x3
+// convolutions need no bounds checks and four neighbouring output pixels can share every
+// weight load. Weights are packed as [K / 4][outputs][4] (K = kernel * kernel * inputs):
+// one 32-bit broadcast of four input channels multiplied with a vector of 16 (AVX-512) or
+// 8 outputs accumulates four products per output in one vpdpbusd, or in
+// vpmaddubsw + vpmaddwd without VNNI.
+//
+#include "quantizedFaceNet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+#define FACENET_AVX512_VNNI
+#include <immintrin.h>
+#elif defined(__AVXVNNI__)
+#define FACENET_AVX_VNNI
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define FACENET_AVX2
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// dlib's input_rgb_image mean, subtracted before dividing by 256
+const float kMean[3] = { 122.782f, 117.001f, 104.298f };
+const float kInputScale = 1.0f / 256.0f;
+
+const int kDescriptorInputs = 256;
+const int kStemSize = (kFaceChipSize - 7) / 2 + 1; // 72
+
+const int kActivationMax = 127; // 7-bit activations
+const int kWeightMax = 127;
+const int kStemWeightMax = 63;  // Stem inputs are full 8-bit pixels
+
+// Largest activation: the stem output, 72 x 72 x 32 (74 x 74 with the border)
+const size_t kFloatBuffer = static_cast<size_t>(kStemSize) * kStemSize * 32;
+const size_t kQuantizedBuffer = static_cast<size_t>(kStemSize + 2) * (kStemSize + 2) * 32;
+
+// dlib pads stride 1 convolutions to keep the size, and does not pad strided ones
+int convPadding(int kernel, int stride) {
+    return stride == 1 ? kernel / 2 : 0;
+}
+
+int convOutput(int size, int kernel, int stride) {
+    return (size + 2 * convPadding(kernel, stride) - kernel) / stride + 1;
+}
+
+// ---------------------------------------------------------------------------------------
+// int8 dot-product kernels
+
+#if defined(FACENET_AVX512_VNNI)
+using Lanes = __m512i;
+const int kLanes = 16;
+const int kMaxVectors = 4;
+inline Lanes zeroLanes() { return _mm512_setzero_si512(); }
+inline Lanes loadLanes(const int8_t* p) { return _mm512_loadu_si512(p); }
+inline Lanes broadcast4(const uint8_t* p) { int32_t v; std::memcpy(&v, p, 4); return _mm512_set1_epi32(v); }
+inline Lanes dot4(Lanes sum, Lanes x, Lanes w) { return _mm512_dpbusd_epi32(sum, x, w); }
+inline void storeLanes(int32_t* p, Lanes v) { _mm512_storeu_si512(p, v); }
+const char* const kKernel = "avx512-vnni";
+#elif defined(FACENET_AVX_VNNI)
+using Lanes = __m256i;
+const int kLanes = 8;
+const int kMaxVectors = 2;
+inline Lanes zeroLanes() { return _mm256_setzero_si256(); }
+inline Lanes loadLanes(const int8_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline Lanes broadcast4(const uint8_t* p) { int32_t v; std::memcpy(&v, p, 4); return _mm256_set1_epi32(v); }
+inline Lanes dot4(Lanes sum, Lanes x, Lanes w) { return _mm256_dpbusd_avx_epi32(sum, x, w); }
+inline void storeLanes(int32_t* p, Lanes v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+const char* const kKernel = "avx-vnni";
+#elif defined(FACENET_AVX2)
+using Lanes = __m256i;
+const int kLanes = 8;
+const int kMaxVectors = 2;
+inline Lanes zeroLanes() { return _mm256_setzero_si256(); }
+inline Lanes loadLanes(const int8_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline Lanes broadcast4(const uint8_t* p) { int32_t v; std::memcpy(&v, p, 4); return _mm256_set1_epi32(v); }
+// Pair sums are at most 2 * 127 * 127, so vpmaddubsw never saturates
+inline Lanes dot4(Lanes sum, Lanes x, Lanes w) {
+    return _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), _mm256_set1_epi16(1)));
+}
+inline void storeLanes(int32_t* p, Lanes v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+const char* const kKernel = "avx2";
+#else
+const int kLanes = 16;
+const int kMaxVectors = 4;
+const char* const kKernel = "scalar";
+#endif
+
+// Accumulates P output pixels x B * kLanes output channels. pixels[p] points at the
+// input under the top left tap of pixel p, weights at the first output of the chunk.
+template <int P, int B>
+void convTile(const uint8_t* const* pixels, int row_step, int kernel, int channels,
+    const int8_t* weights, int outputs, int32_t* acc) {
+#if defined(FACENET_AVX512_VNNI) || defined(FACENET_AVX_VNNI) || defined(FACENET_AVX2)
+    Lanes sum[P][B];
+    for (int p = 0; p < P; ++p)
+        for (int b = 0; b < B; ++b) sum[p][b] = zeroLanes();
+
+    const int8_t* w = weights;
+    for (int ky = 0; ky < kernel; ++ky) {
+        for (int kx = 0; kx < kernel; ++kx) {
+            const int offset = ky * row_step + kx * channels;
+            for (int c = 0; c < channels; c += 4, w += 4 * outputs) {
+                Lanes wv[B];
+                for (int b = 0; b < B; ++b) wv[b] = loadLanes(w + 4 * kLanes * b);
+                for (int p = 0; p < P; ++p) {
+                    const Lanes x = broadcast4(pixels[p] + offset + c);
+                    for (int b = 0; b < B; ++b) sum[p][b] = dot4(sum[p][b], x, wv[b]);
+                }
+            }
+        }
+    }
+    for (int p = 0; p < P; ++p)
+        for (int b = 0; b < B; ++b) storeLanes(acc + p * outputs + b * kLanes, sum[p][b]);
+#else
+    int32_t sum[P][B * kLanes] = {};
+    const int8_t* w = weights;
+    for (int ky = 0; ky < kernel; ++ky) {
+        for (int kx = 0; kx < kernel; ++kx) {
+            const int offset = ky * row_step + kx * channels;
+            for (int c = 0; c < channels; c += 4, w += 4 * outputs) {
+                for (int p = 0; p < P; ++p) {
+                    const uint8_t* x = pixels[p] + offset + c;
+                    for (int o = 0; o < B * kLanes; ++o) {
+                        const int8_t* wo = w + 4 * o;
+                        sum[p][o] += x[0] * wo[0] + x[1] * wo[1] + x[2] * wo[2] + x[3] * wo[3];
+                    }
+                }
+            }
+        }
+    }
+    for (int p = 0; p < P; ++p) std::memcpy(acc + p * outputs, sum[p], sizeof(sum[p]));
+#endif
+}
+
+template <int P>
+void convTileChunks(const uint8_t* const* pixels, int row_step, int kernel, int channels,
+    const int8_t* weights, int outputs, int32_t* acc) {
+    const int wide = kMaxVectors * kLanes;
+    int o = 0;
+    for (; o + wide <= outputs; o += wide)
+        convTile<P, kMaxVectors>(pixels, row_step, kernel, channels, weights + 4 * o, outputs, acc + o);
+    for (; o < outputs; o += 2 * kLanes)
+        convTile<P, 2>(pixels, row_step, kernel, channels, weights + 4 * o, outputs, acc + o);
+}
+
+// ---------------------------------------------------------------------------------------
+// int8 tensors
+
+struct QTensor {
+    int h = 0, w = 0, c = 0;
+    uint8_t* data = nullptr;
+
+    uint8_t* at(int y, int x) const { return data + (static_cast<size_t>(y + 1) * (w + 2) + x + 1) * c; }
+    int rowStep() const { return (w + 2) * c; }
+};
+
+QTensor makeTensor(std::vector<uint8_t>& buffer, int h, int w, int c) {
+    QTensor t{ h, w, c, buffer.data() };
+    std::memset(t.data, 0, static_cast<size_t>(h + 2) * (w + 2) * c);
+    return t;
+}
+
+inline uint8_t quantize(float value, float inverse_scale) {
+    const float q = value * inverse_scale;
+    return q <= 0.0f ? 0 : q >= kActivationMax ? kActivationMax : static_cast<uint8_t>(q + 0.5f);
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------------------
+// Weights and scales
+
+namespace {
+
+struct ConvShape {
+    int inputs, outputs, kernel, stride;
+    bool down; // Block of a down-sampling conv1
+};
+
+// The stem, then conv1 and conv2 of every block of alevel4 ... alevel0
+const std::vector<ConvShape>& convShapes() {
+    static const std::vector<ConvShape> shapes = [] {
+        std::vector<ConvShape> result = { { 3, 32, 7, 2, false } };
+        // Channels, down-sampling blocks, identity blocks
+        const int levels[5][3] = { { 32, 0, 3 }, { 64, 1, 3 }, { 128, 1, 2 }, { 256, 1, 2 }, { 256, 1, 0 } };
+        int channels = 32;
+        for (const auto& level : levels) {
+            for (int i = 0; i < level[1] + level[2]; ++i) {
+                const bool down = i < level[1];
+                result.push_back({ channels, level[0], 3, down ? 2 : 1, down });
+                result.push_back({ level[0], level[0], 3, 1, down });
+                channels = level[0];
+            }
+        }
+        return result;
+    }();
+    return shapes;
+}
+
+size_t weightCount(const ConvShape& shape) {
+    return static_cast<size_t>(shape.outputs) * shape.kernel * shape.kernel * shape.inputs;
+}
+
+} // namespace
+
+FaceNetWeights FaceNetWeights::shapes() {
+    auto conv = [](const ConvShape& shape) {
+        FaceNetConv c;
+        c.inputs = shape.inputs;
+        c.outputs = shape.outputs;
+        c.kernel = shape.kernel;
+        c.stride = shape.stride;
+        c.weights.assign(weightCount(shape), 0.0f);
+        c.bias.assign(shape.outputs, 0.0f);
+        return c;
+    };
+
+    const std::vector<ConvShape>& shapes = convShapes();
+    FaceNetWeights weights;
+    weights.stem = conv(shapes[0]);
+    for (size_t i = 1; i + 1 < shapes.size(); i += 2) {
+        FaceNetBlock block;
+        block.down = shapes[i].down;
+        block.conv1 = conv(shapes[i]);
+        block.conv2 = conv(shapes[i + 1]);
+        weights.blocks.push_back(block);
+    }
+    weights.fc.assign(static_cast<size_t>(kDescriptorInputs) * kFaceDescriptorSize, 0.0f);
+    return weights;
+}
+
+bool FaceNetWeights::valid() const {
+    const FaceNetWeights expected = shapes();
+    auto same = [](const FaceNetConv& a, const FaceNetConv& b) {
+        return a.inputs == b.inputs && a.outputs == b.outputs && a.kernel == b.kernel && a.stride == b.stride
+            && a.weights.size() == b.weights.size() && a.bias.size() == b.bias.size();
+    };
+    if (!same(stem, expected.stem) || blocks.size() != expected.blocks.size() || fc.size() != expected.fc.size()) return false;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (blocks[i].down != expected.blocks[i].down || !same(blocks[i].conv1, expected.blocks[i].conv1)
+            || !same(blocks[i].conv2, expected.blocks[i].conv2)) return false;
+    }
+    return true;
+}
+
+bool FaceNetScales::save(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "faceNetScales " << activation.size() << "\n" << std::setprecision(9);
+    for (float scale : activation) out << scale << "\n";
+    return static_cast<bool>(out);
+}
+
+bool FaceNetScales::load(const std::string& path) {
+    std::ifstream in(path);
+    std::string tag;
+    size_t count = 0;
+    if (!(in >> tag >> count) || tag != "faceNetScales") return false;
+    std::vector<float> scales(count);
+    for (float& scale : scales) {
+        if (!(in >> scale) || !(scale > 0.0f)) return false;
+    }
+    activation = scales;
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------
+// Float network
+
+namespace {
+
+// Weights of one convolution inside a packed block
+struct FloatConv {
+    int inputs, outputs, kernel, stride;
+    const float* weights; // [kernel][kernel][inputs][outputs], outputs innermost
+    const float* bias;
+};
+
+// Appends the convolution to a packed block in the layout of FloatConv
+void packConv(const FaceNetConv& conv, std::vector<float>& packed) {
+    const int taps = conv.kernel * conv.kernel;
+    const size_t base = packed.size();
+    packed.resize(base + conv.weights.size());
+    float* w = packed.data() + base;
+    for (int o = 0; o < conv.outputs; ++o)
+        for (int t = 0; t < taps; ++t)
+            for (int i = 0; i < conv.inputs; ++i)
+                w[(static_cast<size_t>(t) * conv.inputs + i) * conv.outputs + o] = conv.weights[(static_cast<size_t>(o) * taps + t) * conv.inputs + i];
+    packed.insert(packed.end(), conv.bias.begin(), conv.bias.end());
+}
+
+void unpackConv(const FloatConv& packed, FaceNetConv& conv) {
+    const int taps = conv.kernel * conv.kernel;
+    for (int o = 0; o < conv.outputs; ++o)
+        for (int t = 0; t < taps; ++t)
+            for (int i = 0; i < conv.inputs; ++i)
+                conv.weights[(static_cast<size_t>(o) * taps + t) * conv.inputs + i] = packed.weights[(static_cast<size_t>(t) * conv.inputs + i) * conv.outputs + o];
+    conv.bias.assign(packed.bias, packed.bias + conv.outputs);
+}
+
+struct Dims {
+    int h, w, c;
+    size_t size() const { return static_cast<size_t>(h) * w * c; }
+};
+
+Dims convFloat(const float* in, Dims id, const FloatConv& conv, float* out) {
+    const int pad = convPadding(conv.kernel, conv.stride);
+    const Dims od{ convOutput(id.h, conv.kernel, conv.stride), convOutput(id.w, conv.kernel, conv.stride), conv.outputs };
+    const int outputs = conv.outputs;
+    for (int oy = 0; oy < od.h; ++oy) {
+        for (int ox = 0; ox < od.w; ++ox) {
+            float* o = out + (static_cast<size_t>(oy) * od.w + ox) * outputs;
+            std::copy(conv.bias, conv.bias + outputs, o);
+            for (int ky = 0; ky < conv.kernel; ++ky) {
+                const int iy = oy * conv.stride + ky - pad;
+                if (iy < 0 || iy >= id.h) continue;
+                for (int kx = 0; kx < conv.kernel; ++kx) {
+                    const int ix = ox * conv.stride + kx - pad;
+                    if (ix < 0 || ix >= id.w) continue;
+                    const float* x = in + (static_cast<size_t>(iy) * id.w + ix) * id.c;
+                    const float* w = conv.weights + static_cast<size_t>(ky * conv.kernel + kx) * id.c * outputs;
+                    for (int i = 0; i < id.c; ++i, w += outputs) {
+                        const float xv = x[i];
+                        if (xv == 0.0f) continue;
+                        for (int k = 0; k < outputs; ++k) o[k] += xv * w[k];
+                    }
+                }
+            }
+        }
+    }
+    return od;
+}
+
+void reluFloat(float* values, size_t count) {
+    for (size_t i = 0; i < count; ++i) values[i] = std::max(values[i], 0.0f);
+}
+
+} // namespace
+
+struct FaceNetFloat::Model {
+    std::vector<float> storage;        // The packed weights, unless they are external
+    std::shared_ptr<const void> owner; // Keeps external packed weights alive
+    FloatConv stem;
+    struct Block {
+        FloatConv conv1, conv2;
+        bool down;
+    };
+    std::vector<Block> blocks;
+    const float* fc;
+
+    // Points every layer into the packed block
+    void layOut(const float* packed) {
+        const std::vector<ConvShape>& shapes = convShapes();
+        auto next = [&](const ConvShape& shape) {
+            FloatConv conv{ shape.inputs, shape.outputs, shape.kernel, shape.stride, packed, packed + weightCount(shape) };
+            packed += weightCount(shape) + shape.outputs;
+            return conv;
+        };
+        stem = next(shapes[0]);
+        blocks.clear();
+        for (size_t i = 1; i + 1 < shapes.size(); i += 2) {
+            const FloatConv conv1 = next(shapes[i]);
+            blocks.push_back({ conv1, next(shapes[i + 1]), shapes[i].down });
+        }
+        fc = packed;
+    }
+};
+
+size_t faceNetFloatPackedSize() {
+    size_t count = static_cast<size_t>(kDescriptorInputs) * kFaceDescriptorSize;
+    for (const ConvShape& shape : convShapes()) count += weightCount(shape) + shape.outputs;
+    return count;
+}
+
+std::vector<float> packFaceNetFloat(const FaceNetWeights& weights) {
+    std::vector<float> packed;
+    packed.reserve(faceNetFloatPackedSize());
+    packConv(weights.stem, packed);
+    for (const FaceNetBlock& block : weights.blocks) {
+        packConv(block.conv1, packed);
+        packConv(block.conv2, packed);
+    }
+    packed.insert(packed.end(), weights.fc.begin(), weights.fc.end());
+    return packed;
+}
+
+FaceNetFloat::FaceNetFloat(const FaceNetWeights& weights)
+    : a_(kFloatBuffer), b_(kFloatBuffer), c_(kFloatBuffer), skip_(kFloatBuffer) {
+    auto model = std::make_shared<Model>();
+    model->storage = packFaceNetFloat(weights);
+    model->layOut(model->storage.data());
+    model_ = model;
+}
+
+FaceNetFloat::FaceNetFloat(const float* packed, std::shared_ptr<const void> owner)
+    : a_(kFloatBuffer), b_(kFloatBuffer), c_(kFloatBuffer), skip_(kFloatBuffer) {
+    auto model = std::make_shared<Model>();
+    model->owner = std::move(owner);
+    model->layOut(packed);
+    model_ = model;
+}
+
+FaceNetWeights FaceNetFloat::weights() const {
+    FaceNetWeights weights = FaceNetWeights::shapes();
+    unpackConv(model_->stem, weights.stem);
+    for (size_t i = 0; i < weights.blocks.size(); ++i) {
+        unpackConv(model_->blocks[i].conv1, weights.blocks[i].conv1);
+        unpackConv(model_->blocks[i].conv2, weights.blocks[i].conv2);
+    }
+    weights.fc.assign(model_->fc, model_->fc + weights.fc.size());
+    return weights;
+}
+
+void FaceNetFloat::embed(const uint8_t* rgb, float* descriptor, const Observer& observer) {
+    const Model& model = *model_;
+
+    Dims d{ kFaceChipSize, kFaceChipSize, 3 };
+    for (size_t i = 0; i < d.size(); ++i) a_[i] = (rgb[i] - kMean[i % 3]) * kInputScale;
+
+    // Stem and 3x3 / 2 max pool
+    Dims s = convFloat(a_.data(), d, model.stem, b_.data());
+    reluFloat(b_.data(), s.size());
+    if (observer) observer(0, b_.data(), s.size());
+    d = { convOutput(s.h, 3, 2), convOutput(s.w, 3, 2), s.c };
+    for (int y = 0; y < d.h; ++y) {
+        for (int x = 0; x < d.w; ++x) {
+            float* o = a_.data() + (static_cast<size_t>(y) * d.w + x) * d.c;
+            std::fill(o, o + d.c, 0.0f); // Inputs are >= 0 after the relu
+            for (int ky = 0; ky < 3; ++ky)
+                for (int kx = 0; kx < 3; ++kx) {
+                    const float* in = b_.data() + (static_cast<size_t>(2 * y + ky) * s.w + 2 * x + kx) * s.c;
+                    for (int c = 0; c < d.c; ++c) o[c] = std::max(o[c], in[c]);
+                }
+        }
+    }
+
+    int tensor = 1;
+    for (const Model::Block& block : model.blocks) {
+        const Dims m = convFloat(a_.data(), d, block.conv1, b_.data());
+        reluFloat(b_.data(), m.size());
+        if (observer) observer(tensor, b_.data(), m.size());
+        const Dims dc = convFloat(b_.data(), m, block.conv2, c_.data());
+
+        // Skip path: the input, or its 2x2 average pool
+        const float* skip = a_.data();
+        Dims ds = d;
+        if (block.down) {
+            ds = { (d.h - 2) / 2 + 1, (d.w - 2) / 2 + 1, d.c };
+            for (int y = 0; y < ds.h; ++y)
+                for (int x = 0; x < ds.w; ++x) {
+                    float* o = skip_.data() + (static_cast<size_t>(y) * ds.w + x) * ds.c;
+                    const float* p00 = a_.data() + (static_cast<size_t>(2 * y) * d.w + 2 * x) * d.c;
+                    const float* p10 = p00 + static_cast<size_t>(d.w) * d.c;
+                    for (int c = 0; c < ds.c; ++c) o[c] = 0.25f * (p00[c] + p00[d.c + c] + p10[c] + p10[d.c + c]);
+                }
+            skip = skip_.data();
+        }
+
+        // Sum over the larger of the two shapes, missing values are zero
+        const Dims od{ std::max(dc.h, ds.h), std::max(dc.w, ds.w), std::max(dc.c, ds.c) };
+        for (int y = 0; y < od.h; ++y) {
+            for (int x = 0; x < od.w; ++x) {
+                float* o = b_.data() + (static_cast<size_t>(y) * od.w + x) * od.c;
+                std::fill(o, o + od.c, 0.0f);
+                if (y < dc.h && x < dc.w) {
+                    const float* v = c_.data() + (static_cast<size_t>(y) * dc.w + x) * dc.c;
+                    for (int c = 0; c < dc.c; ++c) o[c] += v[c];
+                }
+                if (y < ds.h && x < ds.w) {
+                    const float* v = skip + (static_cast<size_t>(y) * ds.w + x) * ds.c;
+                    for (int c = 0; c < ds.c; ++c) o[c] += v[c];
+                }
+            }
+        }
+        reluFloat(b_.data(), od.size());
+        if (observer) observer(tensor + 1, b_.data(), od.size());
+        std::swap(a_, b_);
+        d = od;
+        tensor += 2;
+    }
+
+    // Global average pool and fc_no_bias
+    float pooled[kDescriptorInputs] = {};
+    const size_t pixels = static_cast<size_t>(d.h) * d.w;
+    for (size_t p = 0; p < pixels; ++p)
+        for (int c = 0; c < d.c; ++c) pooled[c] += a_[p * d.c + c];
+    std::fill(descriptor, descriptor + kFaceDescriptorSize, 0.0f);
+    for (int i = 0; i < kDescriptorInputs; ++i) {
+        const float v = pooled[i] / pixels;
+        const float* w = model.fc + static_cast<size_t>(i) * kFaceDescriptorSize;
+        for (int o = 0; o < kFaceDescriptorSize; ++o) descriptor[o] += v * w[o];
+    }
+}
+
+FaceNetScales calibrateFaceNet(const FaceNetWeights& weights, const std::vector<const uint8_t*>& chips, float percentile) {
+    const size_t tensors = 1 + 2 * weights.blocks.size();
+    const size_t kStride = 7; // Every 7th value is enough for a percentile
+    std::vector<std::vector<float>> samples(tensors);
+    std::vector<float> peak(tensors, 0.0f);
+
+    FaceNetFloat net(weights);
+    float descriptor[kFaceDescriptorSize];
+    for (const uint8_t* chip : chips) {
+        net.embed(chip, descriptor, [&](int tensor, const float* values, size_t count) {
+            for (size_t i = 0; i < count; ++i) peak[tensor] = std::max(peak[tensor], values[i]);
+            for (size_t i = tensor % kStride; i < count; i += kStride) samples[tensor].push_back(values[i]);
+        });
+    }
+
+    FaceNetScales scales;
+    for (size_t t = 0; t < tensors; ++t) {
+        std::vector<float>& values = samples[t];
+        float range = peak[t];
+        if (!values.empty() && percentile < 100.0f) {
+            const size_t rank = std::min(values.size() - 1, static_cast<size_t>(values.size() * percentile / 100.0f));
+            std::nth_element(values.begin(), values.begin() + rank, values.end());
+            range = values[rank];
+        }
+        if (!(range > 0.0f)) range = peak[t] > 0.0f ? peak[t] : 1.0f;
+        scales.activation.push_back(range / kActivationMax);
+    }
+    return scales;
+}
+
+// ---------------------------------------------------------------------------------------
+// int8 network
+
+namespace {
+
+struct QuantizedConv {
+    int inputs, outputs, kernel, stride; // inputs rounded up to a multiple of 4
+    std::vector<int8_t> weights;         // [kernel * kernel * inputs / 4][outputs][4]
+    std::vector<float> scale;            // Input scale * weight scale of each output
+    std::vector<float> bias;
+};
+
+QuantizedConv quantizeConv(const FaceNetConv& conv, int inputs, float input_scale, int weight_max) {
+    QuantizedConv q{ inputs, conv.outputs, conv.kernel, conv.stride, {}, {}, conv.bias };
+    const int taps = conv.kernel * conv.kernel;
+    const size_t k = static_cast<size_t>(taps) * inputs;
+    q.weights.assign(k * conv.outputs, 0);
+    q.scale.resize(conv.outputs);
+    for (int o = 0; o < conv.outputs; ++o) {
+        const float* w = conv.weights.data() + static_cast<size_t>(o) * taps * conv.inputs;
+        float peak = 0.0f;
+        for (int i = 0; i < taps * conv.inputs; ++i) peak = std::max(peak, std::fabs(w[i]));
+        const float weight_scale = peak > 0.0f ? peak / weight_max : 1.0f;
+        q.scale[o] = input_scale * weight_scale;
+        for (int t = 0; t < taps; ++t) {
+            for (int i = 0; i < conv.inputs; ++i) {
+                const size_t kk = static_cast<size_t>(t) * inputs + i;
+                q.weights[((kk / 4) * conv.outputs + o) * 4 + kk % 4] =
+                    static_cast<int8_t>(std::lrint(w[t * conv.inputs + i] / weight_scale));
+            }
+        }
+    }
+    return q;
+}
+
+// Runs the convolution over the output rows, handing each pixel's accumulators to
+// epilogue(y, x, acc)
+template <typename Epilogue>
+void runConv(const QTensor& in, const QuantizedConv& conv, int out_h, int out_w, int32_t* acc, Epilogue&& epilogue) {
+    const int pad = convPadding(conv.kernel, conv.stride);
+    const int row_step = in.rowStep();
+    const uint8_t* pixels[4];
+    for (int y = 0; y < out_h; ++y) {
+        int x = 0;
+        for (; x + 4 <= out_w; x += 4) {
+            for (int p = 0; p < 4; ++p) pixels[p] = in.at(y * conv.stride - pad, (x + p) * conv.stride - pad);
+            convTileChunks<4>(pixels, row_step, conv.kernel, in.c, conv.weights.data(), conv.outputs, acc);
+            for (int p = 0; p < 4; ++p) epilogue(y, x + p, acc + p * conv.outputs);
+        }
+        for (; x < out_w; ++x) {
+            pixels[0] = in.at(y * conv.stride - pad, x * conv.stride - pad);
+            convTileChunks<1>(pixels, row_step, conv.kernel, in.c, conv.weights.data(), conv.outputs, acc);
+            epilogue(y, x, acc);
+        }
+    }
+}
+
+} // namespace
+
+struct QuantizedFaceNet::Model {
+    QuantizedConv stem;
+    float stem_scale;
+    struct Block {
+        QuantizedConv conv1, conv2;
+        bool down;
+        float input_scale, middle_scale, output_scale;
+    };
+    std::vector<Block> blocks;
+    std::vector<float> fc;
+};
+
+QuantizedFaceNet::QuantizedFaceNet(const FaceNetWeights& weights, const FaceNetScales& scales)
+    : a_(kQuantizedBuffer), b_(kQuantizedBuffer), c_(kQuantizedBuffer),
+      acc_(4 * kDescriptorInputs), skip_(kDescriptorInputs) {
+    auto model = std::make_shared<Model>();
+
+    // The stem reads raw pixels padded to 4 channels: fold the 1/256 into the weights and
+    // the mean into the bias
+    FaceNetConv stem = weights.stem;
+    const int taps = stem.kernel * stem.kernel;
+    for (int o = 0; o < stem.outputs; ++o) {
+        for (int t = 0; t < taps; ++t) {
+            for (int c = 0; c < stem.inputs; ++c) {
+                float& w = stem.weights[(static_cast<size_t>(o) * taps + t) * stem.inputs + c];
+                stem.bias[o] -= w * kMean[c] * kInputScale;
+                w *= kInputScale;
+            }
+        }
+    }
+    model->stem = quantizeConv(stem, 4, 1.0f, kStemWeightMax);
+    model->stem_scale = scales.activation.at(0);
+
+    float input_scale = model->stem_scale;
+    for (size_t i = 0; i < weights.blocks.size(); ++i) {
+        const FaceNetBlock& block = weights.blocks[i];
+        const float middle_scale = scales.activation.at(1 + 2 * i);
+        const float output_scale = scales.activation.at(2 + 2 * i);
+        model->blocks.push_back({ quantizeConv(block.conv1, block.conv1.inputs, input_scale, kWeightMax),
+            quantizeConv(block.conv2, block.conv2.inputs, middle_scale, kWeightMax),
+            block.down, input_scale, middle_scale, output_scale });
+        input_scale = output_scale;
+    }
+    model->fc = weights.fc;
+    model_ = model;
+}
+
+const char* QuantizedFaceNet::kernel() {
+    return kKernel;
+}
+
+void QuantizedFaceNet::embed(const uint8_t* rgb, float* descriptor) {
+    const Model& model = *model_;
+    int32_t* acc = acc_.data();
+
+    QTensor input = makeTensor(a_, kFaceChipSize, kFaceChipSize, 4);
+    for (int y = 0; y < kFaceChipSize; ++y) {
+        const uint8_t* src = rgb + static_cast<size_t>(y) * kFaceChipSize * 3;
+        uint8_t* dst = input.at(y, 0);
+        for (int x = 0; x < kFaceChipSize; ++x, src += 3, dst += 4) std::memcpy(dst, src, 3);
+    }
+
+    // Stem with relu, then the 3x3 / 2 max pool directly on the quantized values
+    const QuantizedConv& stem = model.stem;
+    const int stem_size = convOutput(kFaceChipSize, stem.kernel, stem.stride);
+    QTensor stem_out = makeTensor(b_, stem_size, stem_size, stem.outputs);
+    float inverse = 1.0f / model.stem_scale;
+    runConv(input, stem, stem_size, stem_size, acc, [&](int y, int x, const int32_t* sum) {
+        uint8_t* o = stem_out.at(y, x);
+        for (int k = 0; k < stem.outputs; ++k) o[k] = quantize(sum[k] * stem.scale[k] + stem.bias[k], inverse);
+    });
+    const int pooled = convOutput(stem_size, 3, 2);
+    QTensor x = makeTensor(a_, pooled, pooled, stem.outputs);
+    for (int y = 0; y < pooled; ++y) {
+        for (int px = 0; px < pooled; ++px) {
+            uint8_t* o = x.at(y, px);
+            for (int ky = 0; ky < 3; ++ky)
+                for (int kx = 0; kx < 3; ++kx) {
+                    const uint8_t* in = stem_out.at(2 * y + ky, 2 * px + kx);
+                    for (int c = 0; c < x.c; ++c) o[c] = std::max(o[c], in[c]);
+                }
+        }
+    }
+
+    for (const Model::Block& block : model.blocks) {
+        // conv1 with relu
+        const int mh = convOutput(x.h, 3, block.conv1.stride), mw = convOutput(x.w, 3, block.conv1.stride);
+        QTensor middle = makeTensor(b_, mh, mw, block.conv1.outputs);
+        inverse = 1.0f / block.middle_scale;
+        runConv(x, block.conv1, mh, mw, acc, [&](int y, int px, const int32_t* sum) {
+            uint8_t* o = middle.at(y, px);
+            for (int k = 0; k < middle.c; ++k) o[k] = quantize(sum[k] * block.conv1.scale[k] + block.conv1.bias[k], inverse);
+        });
+
+        // conv2 + skip with relu, over the larger of the two shapes
+        const int sh = block.down ? (x.h - 2) / 2 + 1 : x.h, sw = block.down ? (x.w - 2) / 2 + 1 : x.w;
+        QTensor out = makeTensor(c_, std::max(mh, sh), std::max(mw, sw), block.conv2.outputs);
+        float* skip = skip_.data();
+        auto skipAt = [&](int y, int px) {
+            std::fill(skip, skip + out.c, 0.0f);
+            if (y >= sh || px >= sw) return;
+            if (block.down) {
+                const uint8_t* p00 = x.at(2 * y, 2 * px);
+                const uint8_t* p10 = x.at(2 * y + 1, 2 * px);
+                const float s = 0.25f * block.input_scale;
+                for (int c = 0; c < x.c; ++c) skip[c] = s * (p00[c] + p00[x.c + c] + p10[c] + p10[x.c + c]);
+            }
+            else {
+                const uint8_t* p = x.at(y, px);
+                for (int c = 0; c < x.c; ++c) skip[c] = block.input_scale * p[c];
+            }
+        };
+        inverse = 1.0f / block.output_scale;
+        runConv(middle, block.conv2, mh, mw, acc, [&](int y, int px, const int32_t* sum) {
+            skipAt(y, px);
+            uint8_t* o = out.at(y, px);
+            for (int k = 0; k < out.c; ++k)
+                o[k] = quantize(sum[k] * block.conv2.scale[k] + block.conv2.bias[k] + skip[k], inverse);
+        });
+        for (int y = 0; y < out.h; ++y) {
+            for (int px = 0; px < out.w; ++px) {
+                if (y < mh && px < mw) continue;
+                skipAt(y, px);
+                uint8_t* o = out.at(y, px);
+                for (int k = 0; k < out.c; ++k) o[k] = quantize(skip[k], inverse);
+            }
+        }
+
+        // The output becomes the next input; a_ is free again
+        std::swap(a_, c_);
+        x = out;
+        x.data = a_.data();
+    }
+
+    // Global average pool and fc_no_bias in float
+    const Model::Block& last = model.blocks.back();
+    float pooled_sum[kDescriptorInputs] = {};
+    for (int y = 0; y < x.h; ++y)
+        for (int px = 0; px < x.w; ++px) {
+            const uint8_t* p = x.at(y, px);
+            for (int c = 0; c < x.c; ++c) pooled_sum[c] += p[c];
+        }
+    const float scale = last.output_scale / (x.h * x.w);
+    std::fill(descriptor, descriptor + kFaceDescriptorSize, 0.0f);
+    for (int i = 0; i < kDescriptorInputs; ++i) {
+        const float v = pooled_sum[i] * scale;
+        const float* w = model.fc.data() + static_cast<size_t>(i) * kFaceDescriptorSize;
+        for (int o = 0; o < kFaceDescriptorSize; ++o) descriptor[o] += v * w[o];
+    }
+}
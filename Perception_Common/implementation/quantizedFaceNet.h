@@ -0,0 +1,113 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// quantizedFaceNet.h : int8 inference of the dlib face ResNet (anet_type in faceModels.h),
+// with a float reference of the same network for calibration and comparison.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+const int kFaceChipSize = 150;       // Input: kFaceChipSize^2 interleaved RGB bytes
+const int kFaceDescriptorSize = 128;
+
+// One convolution with the affine layer after it folded in
+struct FaceNetConv {
+    int inputs = 0, outputs = 0, kernel = 3, stride = 1;
+    std::vector<float> weights; // [outputs][kernel][kernel][inputs]
+    std::vector<float> bias;    // [outputs]
+};
+
+// relu(conv2(relu(conv1(x))) + skip(x)); conv1 has the stride of the block. The skip of a
+// down block is a 2x2 average pool, zero-extended to the channels and size of conv2.
+struct FaceNetBlock {
+    FaceNetConv conv1, conv2;
+    bool down = false;
+};
+
+// Weights of anet_type: the 7x7 stem applied to (pixel - mean) / 256 as in dlib's
+// input_rgb_image, the residual blocks of alevel4 ... alevel0 in execution order and
+// fc_no_bias<128> after the global average pool.
+struct FaceNetWeights {
+    FaceNetConv stem;
+    std::vector<FaceNetBlock> blocks;
+    std::vector<float> fc; // [256][128], as stored by dlib
+
+    // Zero weights with the shapes of anet_type, to be filled in
+    static FaceNetWeights shapes();
+    bool valid() const;
+};
+
+// Activation scales, one per quantized tensor: the stem output, then the middle and the
+// output of every block (the order FaceNetFloat reports them to its observer)
+struct FaceNetScales {
+    std::vector<float> activation;
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+};
+
+// Straightforward float implementation, used for calibration and by the face programs
+// when the models come from the cache (faceModels.h). Meant to reproduce dlib's
+// anet_type; faceNetBenchmark compares it with dlib's descriptors on real aligned faces
+// and stops if they differ by more than 1e-3.
+//
+// It runs on one packed block of faceNetFloatPackedSize() floats in the layout of its
+// kernels (packFaceNetFloat()). The block is either its own or external, e.g. inside a
+// read-only file mapping that several processes share.
+class FaceNetFloat {
+public:
+    using Observer = std::function<void(int tensor, const float* values, size_t count)>;
+
+    explicit FaceNetFloat(const FaceNetWeights& weights);
+
+    // Runs on packed weights in place, without copying them; owner keeps them alive
+    FaceNetFloat(const float* packed, std::shared_ptr<const void> owner);
+
+    // Not thread-safe (scratch buffers); copies share the weights
+    void embed(const uint8_t* rgb, float* descriptor, const Observer& observer = nullptr);
+
+    // Copy of the weights in the layout of FaceNetWeights
+    FaceNetWeights weights() const;
+
+private:
+    struct Model;
+    std::shared_ptr<const Model> model_;
+    std::vector<float> a_, b_, c_, skip_;
+};
+
+// Packed weights of FaceNetFloat, to be stored in a file and mapped
+size_t faceNetFloatPackedSize();
+std::vector<float> packFaceNetFloat(const FaceNetWeights& weights);
+
+// Runs the float network over the calibration chips and takes the given percentile of
+// every activation tensor as its range.
+FaceNetScales calibrateFaceNet(const FaceNetWeights& weights, const std::vector<const uint8_t*>& chips,
+    float percentile = 99.99f);
+
+// Weights are int8 with one scale per output channel, activations are 0..127 with one
+// scale per tensor (the AVX2 pair sums cannot saturate, so the VNNI and AVX2 kernels give
+// the same descriptors). The stem reads the raw pixels with the mean subtraction folded
+// into its bias. The final average pool and fc layer run in float.
+class QuantizedFaceNet {
+public:
+    QuantizedFaceNet(const FaceNetWeights& weights, const FaceNetScales& scales);
+
+    // Not thread-safe (scratch buffers); copies share the weights, use one per thread
+    void embed(const uint8_t* rgb, float* descriptor);
+
+    // Dot-product kernel compiled in: "avx512-vnni", "avx-vnni", "avx2" or "scalar"
+    static const char* kernel();
+
+private:
+    struct Model;
+    std::shared_ptr<const Model> model_;
+    std::vector<uint8_t> a_, b_, c_;
+    std::vector<int32_t> acc_;
+    std::vector<float> skip_;
+};
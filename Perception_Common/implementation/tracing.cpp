@@ -0,0 +1,338 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// tracing.cpp : Scoped timers and counters with per-thread buffers, percentile summaries
+// and Chrome trace export.
+//
+// Each thread owns a single-producer / single-consumer ring. The owning thread only
+// writes events and publishes its head index; the collector thread drains every ring
+// at a fixed period, so the recording path takes no lock and never allocates after the
+// first event of a thread.
+//
+#include "tracing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace trace {
+
+std::atomic<bool> g_enabled{ false };
+
+namespace {
+
+struct ThreadBuffer {
+    static constexpr uint64_t kCapacity = 1 << 14;
+
+    std::unique_ptr<Event[]> events{ new Event[kCapacity] };
+    alignas(64) std::atomic<uint64_t> head{ 0 }; // Written by the owning thread
+    alignas(64) std::atomic<uint64_t> tail{ 0 }; // Written by the collector
+    std::atomic<uint64_t> dropped{ 0 };
+    std::atomic<bool> retired{ false };
+    int tid = 0;
+    std::string name; // Guarded by the registry mutex
+};
+
+struct StageStats {
+    std::vector<double> durations_ms; // Current summary window
+    uint64_t total = 0;
+};
+
+struct CounterStats {
+    double sum = 0.0;
+    double last = 0.0;
+    uint64_t count = 0;
+};
+
+class Collector {
+public:
+    ~Collector() { stop(); }
+
+    std::shared_ptr<ThreadBuffer> registerThread() {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        buffer->tid = next_tid_++;
+        buffers_.push_back(buffer);
+        return buffer;
+    }
+
+    void nameThread(ThreadBuffer& buffer, const char* name) {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        buffer.name = name;
+    }
+
+    void start(const TraceOptions& options) {
+        stop();
+        options_ = options;
+        window_start_ns_ = nowNs();
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            running_ = true;
+        }
+        g_enabled.store(true, std::memory_order_relaxed);
+        thread_ = std::thread(&Collector::run, this);
+    }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        g_enabled.store(false, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            running_ = false;
+        }
+        wake_.notify_one();
+        thread_.join();
+
+        drain();
+        if (options_.final_summary) printSummary();
+        if (!options_.json_path.empty()) writeChromeTrace();
+        json_events_.clear();
+        stages_.clear();
+        counters_.clear();
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        while (running_) {
+            wake_.wait_for(lock, std::chrono::milliseconds(50));
+            drain();
+            const double window_s = (nowNs() - window_start_ns_) * 1e-9;
+            if (options_.summary_interval_s > 0.0 && window_s >= options_.summary_interval_s) {
+                printSummary();
+            }
+        }
+    }
+
+    void drain() {
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            buffers = buffers_;
+        }
+
+        for (const auto& buffer : buffers) {
+            // Read retired before head, so a retired buffer is known to be complete
+            const bool retired = buffer->retired.load(std::memory_order_acquire);
+            const uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+            const uint64_t head = buffer->head.load(std::memory_order_acquire);
+            for (uint64_t i = tail; i < head; ++i) {
+                consume(buffer->tid, buffer->events[i & (ThreadBuffer::kCapacity - 1)]);
+            }
+            buffer->tail.store(head, std::memory_order_release);
+            dropped_ += buffer->dropped.exchange(0, std::memory_order_relaxed);
+
+            if (retired) {
+                std::lock_guard<std::mutex> lock(registry_mutex_);
+                thread_names_[buffer->tid] = buffer->name;
+                buffers_.erase(std::remove(buffers_.begin(), buffers_.end(), buffer), buffers_.end());
+            }
+        }
+    }
+
+    void consume(int tid, const Event& event) {
+        if (event.type == EventType::Scope) {
+            StageStats& stats = stages_[event.name];
+            stats.durations_ms.push_back(event.duration_ns * 1e-6);
+            stats.total++;
+        }
+        else {
+            CounterStats& stats = counters_[event.name];
+            stats.sum += event.value;
+            stats.last = event.value;
+            stats.count++;
+        }
+
+        if (!options_.json_path.empty()) {
+            if (json_events_.size() < options_.max_json_events) json_events_.emplace_back(tid, event);
+            else json_overflow_++;
+        }
+    }
+
+    static double percentile(const std::vector<double>& sorted, double p) {
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+    }
+
+    void printSummary() {
+        const uint64_t now = nowNs();
+        const double window_s = (now - window_start_ns_) * 1e-9;
+        window_start_ns_ = now;
+
+        std::printf("[%s] trace summary over %.1f s\n", options_.process_name.c_str(), window_s);
+        std::printf("  %-28s %8s %9s %9s %9s %9s\n", "stage", "count", "p50 ms", "p90 ms", "p99 ms", "max ms");
+        for (auto& entry : stages_) {
+            std::vector<double>& samples = entry.second.durations_ms;
+            if (samples.empty()) continue;
+            std::sort(samples.begin(), samples.end());
+            std::printf("  %-28s %8zu %9.3f %9.3f %9.3f %9.3f\n", entry.first.c_str(), samples.size(),
+                percentile(samples, 0.5), percentile(samples, 0.9), percentile(samples, 0.99), samples.back());
+            samples.clear();
+        }
+        for (auto& entry : counters_) {
+            CounterStats& stats = entry.second;
+            if (stats.count == 0) continue;
+            std::printf("  %-28s %8llu   mean %10.3f   last %10.3f\n", entry.first.c_str(),
+                static_cast<unsigned long long>(stats.count), stats.sum / stats.count, stats.last);
+            stats = CounterStats();
+        }
+        if (dropped_ > 0) {
+            std::printf("  %llu events dropped (collector fell behind)\n", static_cast<unsigned long long>(dropped_));
+            dropped_ = 0;
+        }
+        std::fflush(stdout);
+    }
+
+    static void writeJsonString(std::FILE* out, const std::string& text) {
+        std::fputc('"', out);
+        for (char c : text) {
+            if (c == '"' || c == '\\') std::fputc('\\', out);
+            if (static_cast<unsigned char>(c) >= 0x20) std::fputc(c, out);
+        }
+        std::fputc('"', out);
+    }
+
+    void writeChromeTrace() {
+        std::FILE* out = std::fopen(options_.json_path.c_str(), "w");
+        if (!out) {
+            std::fprintf(stderr, "Error: Could not write trace %s\n", options_.json_path.c_str());
+            return;
+        }
+
+        std::fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        std::fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":");
+        writeJsonString(out, options_.process_name);
+        std::fprintf(out, "}}");
+
+        std::map<int, std::string> names;
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            names = thread_names_;
+            for (const auto& buffer : buffers_) names[buffer->tid] = buffer->name;
+        }
+        for (const auto& entry : names) {
+            if (entry.second.empty()) continue;
+            std::fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", entry.first);
+            writeJsonString(out, entry.second);
+            std::fprintf(out, "}}");
+        }
+
+        const uint64_t origin = json_events_.empty() ? 0 : std::min_element(json_events_.begin(), json_events_.end(),
+            [](const std::pair<int, Event>& a, const std::pair<int, Event>& b) {
+                return a.second.start_ns < b.second.start_ns;
+            })->second.start_ns;
+        for (const auto& entry : json_events_) {
+            const Event& event = entry.second;
+            std::fprintf(out, ",\n{\"name\":");
+            writeJsonString(out, event.name);
+            if (event.type == EventType::Scope) {
+                std::fprintf(out, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", entry.first,
+                    (event.start_ns - origin) * 1e-3, event.duration_ns * 1e-3);
+            }
+            else {
+                std::fprintf(out, ",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%g}}", entry.first,
+                    (event.start_ns - origin) * 1e-3, event.value);
+            }
+        }
+        std::fprintf(out, "\n]}\n");
+        std::fclose(out);
+
+        std::printf("[%s] wrote %zu trace events to %s", options_.process_name.c_str(), json_events_.size(),
+            options_.json_path.c_str());
+        if (json_overflow_ > 0) std::printf(" (%llu not kept)", static_cast<unsigned long long>(json_overflow_));
+        std::printf("\n");
+    }
+
+    TraceOptions options_;
+
+    std::mutex registry_mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    std::map<int, std::string> thread_names_; // Threads that have exited
+    int next_tid_ = 1;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool running_ = false;
+    std::thread thread_;
+
+    // Collector thread only
+    std::map<std::string, StageStats> stages_;
+    std::map<std::string, CounterStats> counters_;
+    std::vector<std::pair<int, Event>> json_events_;
+    uint64_t json_overflow_ = 0;
+    uint64_t dropped_ = 0;
+    uint64_t window_start_ns_ = 0;
+};
+
+Collector& collector() {
+    static Collector instance;
+    return instance;
+}
+
+// Marks the buffer retired when its thread exits; the collector frees it after draining
+struct ThreadBufferHandle {
+    std::shared_ptr<ThreadBuffer> buffer;
+    ~ThreadBufferHandle() {
+        if (buffer) buffer->retired.store(true, std::memory_order_release);
+    }
+};
+
+ThreadBuffer& threadBuffer() {
+    thread_local ThreadBufferHandle handle;
+    if (!handle.buffer) handle.buffer = collector().registerThread();
+    return *handle.buffer;
+}
+
+} // namespace
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void record(const Event& event) {
+    ThreadBuffer& buffer = threadBuffer();
+    const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    if (head - buffer.tail.load(std::memory_order_acquire) >= ThreadBuffer::kCapacity) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events[head & (ThreadBuffer::kCapacity - 1)] = event;
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void setThreadName(const char* name) {
+    if (enabled()) collector().nameThread(threadBuffer(), name);
+}
+
+void start(const TraceOptions& options) {
+    collector().start(options);
+}
+
+void stop() {
+    collector().stop();
+}
+
+Session::Session(const std::string& process_name) {
+    const char* setting = std::getenv("PERCEPTION_TRACE");
+    if (!setting || !*setting || std::string(setting) == "0") return;
+
+    TraceOptions options;
+    options.process_name = process_name;
+    if (std::string(setting) != "1") options.json_path = setting;
+    start(options);
+    active_ = true;
+}
+
+Session::~Session() {
+    if (active_) stop();
+}
+
+} // namespace trace
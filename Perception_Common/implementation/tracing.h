@@ -0,0 +1,116 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// tracing.h : Scoped timers and counters with per-thread buffers, percentile summaries
+// and Chrome trace export.
+//
+// Usage:
+//
+//   trace::Session tracing("orb");           // once, at the top of main()
+//   { TRACE_SCOPE("detectAndCompute"); ... }  // time a block
+//   TRACE_COUNTER("keypoints", keypoints.size());
+//
+// Tracing is off unless the PERCEPTION_TRACE environment variable is set:
+//
+//   PERCEPTION_TRACE=1            print per-stage percentiles every 5 s
+//   PERCEPTION_TRACE=orb.json     also write a Chrome trace (chrome://tracing, Perfetto)
+//
+// When off, a scope costs one relaxed atomic load. Define PERCEPTION_TRACE_DISABLED to
+// compile the macros out entirely. Names must be string literals (they are stored as
+// pointers).
+//
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace trace {
+
+enum class EventType : uint8_t {
+    Scope,
+    Counter
+};
+
+struct Event {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    double value;
+    EventType type;
+};
+
+extern std::atomic<bool> g_enabled;
+
+inline bool enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t nowNs();
+
+// Append an event to the calling thread's buffer. Never blocks; the event is dropped
+// if the collector has fallen a full buffer behind.
+void record(const Event& event);
+
+// Label the calling thread in the Chrome trace
+void setThreadName(const char* name);
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* name) : name_(name), start_ns_(enabled() ? nowNs() : 0) {}
+    ~ScopedTimer() {
+        if (start_ns_ != 0) record({ name_, start_ns_, nowNs() - start_ns_, 0.0, EventType::Scope });
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_ns_;
+};
+
+inline void counter(const char* name, double value) {
+    if (enabled()) record({ name, nowNs(), 0, value, EventType::Counter });
+}
+
+struct TraceOptions {
+    std::string process_name;
+    std::string json_path;              // Empty: summaries only
+    double summary_interval_s = 5.0;    // 0 disables periodic summaries
+    bool final_summary = true;          // Print a summary from stop()
+    size_t max_json_events = 1 << 21;   // Events kept for the Chrome trace
+};
+
+// Start the collector thread and enable recording
+void start(const TraceOptions& options);
+
+// Disable recording, drain all buffers, print the final summary and write the trace
+void stop();
+
+// Starts tracing from PERCEPTION_TRACE (see above) and stops it when destroyed
+class Session {
+public:
+    explicit Session(const std::string& process_name);
+    ~Session();
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+private:
+    bool active_ = false;
+};
+
+} // namespace trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef PERCEPTION_TRACE_DISABLED
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_COUNTER(name, value) ((void)0)
+#else
+#define TRACE_SCOPE(name) ::trace::ScopedTimer TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_COUNTER(name, value) ::trace::counter(name, static_cast<double>(value))
+#endif
@@ -0,0 +1,54 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// tripleBuffer.h : Lock-free single-producer / single-consumer handoff of the latest value.
+//
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Three slots: the producer owns back(), the consumer owns front() and the third is the
+// handoff. publish() swaps back and handoff, update() swaps handoff and front when a new
+// value is waiting; both are one atomic exchange, so neither side ever waits for the
+// other. A value published before the consumer picked up the previous one replaces it
+// (counted in dropped()). Slots are reused, so T can keep its allocations.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer side
+    T& back() { return slots_[back_]; }
+    void publish() {
+        const uint8_t previous = handoff_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel);
+        back_ = previous & kIndex;
+        published_.fetch_add(1, std::memory_order_relaxed);
+        if (previous & kFresh) dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Consumer side; true when front() changed
+    bool update() {
+        if (!(handoff_.load(std::memory_order_relaxed) & kFresh)) return false;
+        const uint8_t previous = handoff_.exchange(front_, std::memory_order_acq_rel);
+        front_ = previous & kIndex;
+        return true;
+    }
+    T& front() { return slots_[front_]; }
+
+    uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static const uint8_t kIndex = 0x3;
+    static const uint8_t kFresh = 0x4;
+
+    T slots_[3];
+    uint8_t back_ = 0;
+    uint8_t front_ = 1;
+    alignas(64) std::atomic<uint8_t> handoff_{ 2 };
+    std::atomic<uint64_t> published_{ 0 };
+    std::atomic<uint64_t> dropped_{ 0 };
+};
@@ -0,0 +1,74 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// visualOdometry.cpp : Frame-to-frame feature matching and relative pose for the SLAM programs.
+//
+#include "visualOdometry.h"
+#include "tracing.h"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/flann.hpp>
+
+#include <algorithm>
+
+std::vector<cv::DMatch> computeMatches(const cv::Mat& descriptors1, const cv::Mat& descriptors2) {
+    TRACE_SCOPE("computeMatches");
+    if (descriptors1.empty() || descriptors2.empty()) return {};
+
+    if (descriptors1.depth() == CV_8U) {
+        cv::BFMatcher bf(cv::NORM_HAMMING, true);
+
+        std::vector<cv::DMatch> matches;
+        bf.match(descriptors1, descriptors2, matches);
+
+        // Sort matches by distance
+        std::sort(matches.begin(), matches.end(), [](const cv::DMatch& a, const cv::DMatch& b) {
+            return a.distance < b.distance;
+            });
+
+        return matches;
+    }
+
+    cv::Ptr<cv::flann::IndexParams> indexParams = cv::makePtr<cv::flann::KDTreeIndexParams>(5);
+    cv::Ptr<cv::flann::SearchParams> searchParams = cv::makePtr<cv::flann::SearchParams>(50);
+    cv::FlannBasedMatcher flann(indexParams, searchParams);
+
+    std::vector<std::vector<cv::DMatch>> knnMatches;
+    flann.knnMatch(descriptors1, descriptors2, knnMatches, 2);
+
+    // Filter matches using Lowe's ratio test
+    std::vector<cv::DMatch> goodMatches;
+    for (const auto& knnMatch : knnMatches) {
+        if (knnMatch.size() >= 2 && knnMatch[0].distance < 0.7f * knnMatch[1].distance) {
+            goodMatches.push_back(knnMatch[0]);
+        }
+    }
+    return goodMatches;
+}
+
+void findPose(const std::vector<cv::DMatch>& matches, const std::vector<cv::KeyPoint>& keypoints1, const std::vector<cv::KeyPoint>& keypoints2, const cv::Mat& K, cv::Mat& R, cv::Mat& t, cv::Mat& mask) {
+    std::vector<cv::Point2f> pts1, pts2;
+    for (const auto& match : matches) {
+        pts1.push_back(keypoints1[match.queryIdx].pt);
+        pts2.push_back(keypoints2[match.trainIdx].pt);
+    }
+
+    // The five-point solver needs at least five correspondences
+    if (pts1.size() < 5) {
+        R = cv::Mat::eye(3, 3, CV_64F);
+        t = cv::Mat::zeros(3, 1, CV_64F);
+        mask.release();
+        return;
+    }
+
+    // Find essential matrix
+    cv::Mat E;
+    {
+        TRACE_SCOPE("findEssentialMat");
+        E = cv::findEssentialMat(pts1, pts2, K, cv::RANSAC, 0.999, 1.0, mask);
+    }
+
+    // Recover pose (R, t)
+    TRACE_SCOPE("recoverPose");
+    cv::recoverPose(E, pts1, pts2, K, R, t, mask);
+}
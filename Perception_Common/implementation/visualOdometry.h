@@ -0,0 +1,20 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// visualOdometry.h : Frame-to-frame feature matching and relative pose for the SLAM programs.
+//
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+#include <vector>
+
+// Match descriptors of two frames. Binary descriptors (ORB, BRIEF) use a cross-checked
+// brute-force Hamming matcher sorted by distance; float descriptors (SIFT) use FLANN with
+// Lowe's ratio test.
+std::vector<cv::DMatch> computeMatches(const cv::Mat& descriptors1, const cv::Mat& descriptors2);
+
+// Estimate the relative rotation and translation from matched keypoints with a RANSAC
+// essential matrix. mask marks the inliers.
+void findPose(const std::vector<cv::DMatch>& matches, const std::vector<cv::KeyPoint>& keypoints1, const std::vector<cv::KeyPoint>& keypoints2, const cv::Mat& K, cv::Mat& R, cv::Mat& t, cv::Mat& mask);
@@ -0,0 +1,105 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// workStealingPool.cpp : Thread pool with a task queue per worker and stealing between them.
+//
+#include "workStealingPool.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <string>
+
+WorkStealingPool::WorkStealingPool(int threads) {
+    if (threads <= 0) threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    threads_ = threads;
+    for (int i = 0; i < threads; ++i) queues_.emplace_back(new Queue);
+    workers_.reserve(threads);
+    for (int i = 0; i < threads; ++i) workers_.emplace_back(&WorkStealingPool::work, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) worker.join();
+}
+
+void WorkStealingPool::submit(Task task, int preferred_worker) {
+    const int n = threads();
+    const int worker = preferred_worker >= 0 ? preferred_worker % n : static_cast<int>(next_queue_++ % n);
+    {
+        std::lock_guard<std::mutex> lock(queues_[worker]->mutex);
+        queues_[worker]->tasks.push_back(std::move(task));
+    }
+    queued_++;
+    // Taking the lock orders the count with a worker that is about to sleep
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    wake_.notify_one();
+}
+
+void WorkStealingPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return queued_.load() == 0 && active_.load() == 0; });
+}
+
+void WorkStealingPool::parallelFor(int tasks, const std::function<void(int task, int worker)>& fn) {
+    if (tasks <= 0) return;
+    struct Join {
+        std::atomic<int> next{ 0 };
+        std::mutex mutex;
+        std::condition_variable done;
+        int running = 0;
+    } join;
+
+    // One drainer per worker; tasks are handed out by index so uneven ones balance out
+    const int drainers = std::min(tasks, threads());
+    join.running = drainers;
+    for (int i = 0; i < drainers; ++i) {
+        submit([&join, &fn, tasks](int worker) {
+            for (int task = join.next++; task < tasks; task = join.next++) fn(task, worker);
+            std::lock_guard<std::mutex> lock(join.mutex);
+            if (--join.running == 0) join.done.notify_one();
+        }, i);
+    }
+    std::unique_lock<std::mutex> lock(join.mutex);
+    join.done.wait(lock, [&join] { return join.running == 0; });
+}
+
+bool WorkStealingPool::take(int worker, Task& task) {
+    const int n = threads();
+    for (int i = 0; i < n; ++i) {
+        Queue& queue = *queues_[(worker + i) % n];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        // Active before the queued count drops, so waitIdle() never sees both at zero early
+        active_++;
+        queued_--;
+        if (i > 0) stolen_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::work(int worker) {
+    trace::setThreadName(("pool" + std::to_string(worker)).c_str());
+    Task task;
+    while (true) {
+        if (take(worker, task)) {
+            task(worker);
+            task = nullptr;
+            executed_.fetch_add(1, std::memory_order_relaxed);
+            if (--active_ == 0 && queued_.load() == 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                idle_.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+        if (stop_ && queued_.load() == 0) return;
+    }
+}
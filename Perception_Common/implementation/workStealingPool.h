@@ -0,0 +1,69 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// workStealingPool.h : Thread pool with a task queue per worker and stealing between them.
+//
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// submit() queues a task on its preferred worker (round robin without a preference), so
+// work for the same stream tends to stay on the same core. Each worker runs its own queue
+// oldest first; an idle worker steals the oldest task of another queue before it sleeps.
+// Tasks get the index of the worker that runs them, for per-worker scratch state.
+class WorkStealingPool {
+public:
+    using Task = std::function<void(int worker)>;
+
+    explicit WorkStealingPool(int threads = 0); // 0 = hardware concurrency
+    ~WorkStealingPool();                        // Runs the queued tasks, then joins
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Task task, int preferred_worker = -1);
+
+    // Blocks until every submitted task has finished
+    void waitIdle();
+
+    // Fork-join loop: runs fn(task, worker) for task 0 .. tasks-1 on the workers and returns
+    // when all are done. Only waits for its own tasks, so other users of the pool can keep
+    // submitting. Must not be called from a task of the same pool.
+    void parallelFor(int tasks, const std::function<void(int task, int worker)>& fn);
+
+    int threads() const { return threads_; }
+    uint64_t executed() const { return executed_.load(std::memory_order_relaxed); }
+    uint64_t stolen() const { return stolen_.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool take(int worker, Task& task);
+    void work(int worker);
+
+    int threads_ = 0; // Fixed before the workers start; workers_ is still growing then
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::atomic<int64_t> queued_{ 0 };
+    std::atomic<int> active_{ 0 };
+    bool stop_ = false;
+
+    std::atomic<unsigned> next_queue_{ 0 };
+    std::atomic<uint64_t> executed_{ 0 };
+    std::atomic<uint64_t> stolen_{ 0 };
+};
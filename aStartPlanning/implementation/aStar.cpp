@@ -1,18 +1,19 @@
 //
 // Copyright(c) 2024 deepwave-ai. All Rights Reserved.
 //
-// aStarPathPlanning.cpp : This file contains the 'main' function. Program execution begins and ends there.
-//
+// aStar.cpp : A* path planning on a 4-connected occupancy grid, and weighted A* over the
+// traversal costs of a CostMap (costMap.h).
 //
 
-#include <iostream>
+#include "aStar.h"
+#include "costMap.h"
+
 #include <vector>
 #include <queue>
 #include <cmath>
 #include <set>
 #include <utility>
 #include <algorithm>
-#include <opencv2/opencv.hpp>
 
 using namespace std;
 
@@ -82,50 +83,79 @@ vector<pair<int, int>> astar(const vector<vector<int>>& grid, pair<int, int> sta
     return {}; // Return empty vector if no path is found
 }
 
+float octileHeuristic(pair<int, int> a, pair<int, int> b) {
+    const int dx = abs(a.first - b.first), dy = abs(a.second - b.second);
+    return static_cast<float>(max(dx, dy)) + (sqrt(2.0f) - 1.0f) * static_cast<float>(min(dx, dy));
+}
 
-int main() {
-    // Define grid, start, and goal
-    vector<vector<int>> grid(10, vector<int>(10, 0));
-    for (int i = 3; i < 8; ++i) {
-        grid[i][5] = 1; // Add an obstacle
+vector<pair<int, int>> CostMapPlanner::plan(const CostMap& map, pair<int, int> start, pair<int, int> goal, float weight) {
+    const int rows = map.rows(), cols = map.cols();
+    const size_t cells = static_cast<size_t>(rows) * cols;
+    if (g_.size() != cells) {
+        g_.assign(cells, 0.0f);
+        parent_.assign(cells, -1);
+        seen_.assign(cells, 0);
+        closed_.assign(cells, 0);
+        search_ = 0;
     }
+    if (++search_ == 0) { // Stamp wrapped around
+        fill(seen_.begin(), seen_.end(), 0);
+        fill(closed_.begin(), closed_.end(), 0);
+        search_ = 1;
+    }
+    expanded_ = 0;
+    path_cost_ = 0.0f;
+    open_.clear();
 
-    pair<int, int> start = { 0, 0 };
-    pair<int, int> goal = { 9, 9 };
-
-    // Run A* and retrieve the path
-    vector<pair<int, int>> path = astar(grid, start, goal);
-
-    // Visualization using OpenCV
-    cv::Mat image = cv::Mat::zeros(grid.size(), grid[0].size(), CV_8UC3);
-    for (int i = 0; i < grid.size(); ++i) {
-        for (int j = 0; j < grid[0].size(); ++j) {
-            if (grid[i][j] == 1) {
-                image.at<cv::Vec3b>(i, j) = cv::Vec3b(0, 0, 0); // Black for obstacles
-            }
-            else {
-                image.at<cv::Vec3b>(i, j) = cv::Vec3b(255, 255, 255); // White for free space
-            }
-        }
+    if (map.cost(start.first, start.second) == CostMap::kLethal || map.cost(goal.first, goal.second) == CostMap::kLethal) {
+        return {};
     }
 
-    if (!path.empty()) {
-        std::cout << "Path coordinates:" << std::endl;
-        for (const auto& coordinate : path) {
-            std::cout << "(" << coordinate.first << ", " << coordinate.second << ")" << std::endl;
+    // Min-heap on f; among equal f the deeper entry first, which saves expansions near the goal
+    const auto worse = [](const Entry& a, const Entry& b) { return a.f > b.f || (a.f == b.f && a.g < b.g); };
+    const int start_cell = start.first * cols + start.second, goal_cell = goal.first * cols + goal.second;
+    g_[start_cell] = 0.0f;
+    parent_[start_cell] = -1;
+    seen_[start_cell] = search_;
+    open_.push_back({ weight * octileHeuristic(start, goal), 0.0f, start_cell });
+
+    const float diagonal = sqrt(2.0f);
+    while (!open_.empty()) {
+        pop_heap(open_.begin(), open_.end(), worse);
+        const Entry current = open_.back();
+        open_.pop_back();
+        if (closed_[current.cell] == search_ || current.g > g_[current.cell]) continue;
+        closed_[current.cell] = search_;
+        expanded_++;
+
+        if (current.cell == goal_cell) {
+            vector<pair<int, int>> path;
+            for (int cell = goal_cell; cell >= 0; cell = parent_[cell]) path.push_back({ cell / cols, cell % cols });
+            reverse(path.begin(), path.end());
+            path_cost_ = current.g;
+            return path;
+        }
 
-            int y = coordinate.first;  // Row (y)
-            int x = coordinate.second; // Column (x)
-            if (y >= 0 && y < image.rows && x >= 0 && x < image.cols) {
-                image.at<cv::Vec3b>(y, x) = cv::Vec3b(0, 0, 255); // Red for path
+        const int row = current.cell / cols, col = current.cell % cols;
+        const float cost = map.cost(row, col);
+        for (int dr = -1; dr <= 1; ++dr) {
+            for (int dc = -1; dc <= 1; ++dc) {
+                const int r = row + dr, c = col + dc;
+                if ((dr == 0 && dc == 0) || r < 0 || r >= rows || c < 0 || c >= cols) continue;
+                const int neighbor = r * cols + c;
+                const float neighbor_cost = map.cost(r, c);
+                if (neighbor_cost == CostMap::kLethal || closed_[neighbor] == search_) continue;
+                if (dr != 0 && dc != 0 && (map.cost(row, c) == CostMap::kLethal || map.cost(r, col) == CostMap::kLethal)) continue;
+
+                const float g = current.g + (dr != 0 && dc != 0 ? diagonal : 1.0f) * 0.5f * (cost + neighbor_cost);
+                if (seen_[neighbor] == search_ && g >= g_[neighbor]) continue;
+                seen_[neighbor] = search_;
+                g_[neighbor] = g;
+                parent_[neighbor] = current.cell;
+                open_.push_back({ g + weight * octileHeuristic({ r, c }, goal), g, neighbor });
+                push_heap(open_.begin(), open_.end(), worse);
             }
         }
     }
-
-    image.at<cv::Vec3b>(start.first, start.second) = cv::Vec3b(0, 255, 0); // Green for start
-    image.at<cv::Vec3b>(goal.first, goal.second) = cv::Vec3b(255, 0, 0);   // Blue for goal
-
-    cv::resize(image, image, cv::Size(500, 500), 0, 0, cv::INTER_NEAREST);
-    cv::imshow("A* Pathfinding", image);
-    cv::waitKey(0);
+    return {};
 }
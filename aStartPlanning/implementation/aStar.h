@@ -0,0 +1,56 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// aStar.h : A* path planning on a 4-connected occupancy grid, and weighted A* over the
+// traversal costs of a CostMap (costMap.h).
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class CostMap;
+
+// Manhattan distance between two grid cells
+int heuristic(std::pair<int, int> a, std::pair<int, int> b);
+
+// Shortest path from start to goal, both given as (row, column). Cells equal to 1 are
+// obstacles. Returns the cells of the path including start and goal, or an empty vector
+// if the goal cannot be reached.
+std::vector<std::pair<int, int>> astar(const std::vector<std::vector<int>>& grid, std::pair<int, int> start, std::pair<int, int> goal);
+
+// Octile distance: the length of the shortest 8-connected path between two cells
+float octileHeuristic(std::pair<int, int> a, std::pair<int, int> b);
+
+// A* on the 8-connected grid of a CostMap. A step costs its length (1 or sqrt 2) times the
+// mean cost of the two cells; lethal cells are never entered and a diagonal step needs both
+// cells beside it to be free. Every cost is at least 1, so the octile heuristic is
+// admissible and weight 1 finds the cheapest path. weight > 1 searches f = g + weight h
+// without reopening closed cells: the path costs at most weight times the cheapest one,
+// in exchange for far fewer expansions.
+class CostMapPlanner {
+public:
+    // Cells of the path including start and goal, empty if the goal cannot be reached or
+    // start or goal is lethal. Not thread-safe (scratch buffers); use one per thread.
+    std::vector<std::pair<int, int>> plan(const CostMap& map, std::pair<int, int> start, std::pair<int, int> goal, float weight = 1.0f);
+
+    size_t expanded() const { return expanded_; } // Cells closed by the last plan()
+    float pathCost() const { return path_cost_; }
+
+private:
+    struct Entry {
+        float f, g;
+        int cell;
+    };
+
+    // Scratch values are valid where the stamp equals search_, so nothing is cleared per query
+    std::vector<float> g_;
+    std::vector<int> parent_;
+    std::vector<uint32_t> seen_, closed_;
+    std::vector<Entry> open_;
+    uint32_t search_ = 0;
+    size_t expanded_ = 0;
+    float path_cost_ = 0.0f;
+};
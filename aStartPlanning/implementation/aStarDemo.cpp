@@ -0,0 +1,61 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// aStarDemo.cpp : This file contains the 'main' function. Program execution begins and ends there.
+//
+
+#include <iostream>
+#include <vector>
+#include <utility>
+#include <opencv2/opencv.hpp>
+
+#include "aStar.h"
+
+using namespace std;
+
+int main() {
+    // Define grid, start, and goal
+    vector<vector<int>> grid(10, vector<int>(10, 0));
+    for (int i = 3; i < 8; ++i) {
+        grid[i][5] = 1; // Add an obstacle
+    }
+
+    pair<int, int> start = { 0, 0 };
+    pair<int, int> goal = { 9, 9 };
+
+    // Run A* and retrieve the path
+    vector<pair<int, int>> path = astar(grid, start, goal);
+
+    // Visualization using OpenCV
+    cv::Mat image = cv::Mat::zeros(grid.size(), grid[0].size(), CV_8UC3);
+    for (int i = 0; i < grid.size(); ++i) {
+        for (int j = 0; j < grid[0].size(); ++j) {
+            if (grid[i][j] == 1) {
+                image.at<cv::Vec3b>(i, j) = cv::Vec3b(0, 0, 0); // Black for obstacles
+            }
+            else {
+                image.at<cv::Vec3b>(i, j) = cv::Vec3b(255, 255, 255); // White for free space
+            }
+        }
+    }
+
+    if (!path.empty()) {
+        std::cout << "Path coordinates:" << std::endl;
+        for (const auto& coordinate : path) {
+            std::cout << "(" << coordinate.first << ", " << coordinate.second << ")" << std::endl;
+
+            int y = coordinate.first;  // Row (y)
+            int x = coordinate.second; // Column (x)
+            if (y >= 0 && y < image.rows && x >= 0 && x < image.cols) {
+                image.at<cv::Vec3b>(y, x) = cv::Vec3b(0, 0, 255); // Red for path
+            }
+        }
+    }
+
+    image.at<cv::Vec3b>(start.first, start.second) = cv::Vec3b(0, 255, 0); // Green for start
+    image.at<cv::Vec3b>(goal.first, goal.second) = cv::Vec3b(255, 0, 0);   // Blue for goal
+
+    cv::resize(image, image, cv::Size(500, 500), 0, 0, cv::INTER_NEAREST);
+    cv::imshow("A* Pathfinding", image);
+    cv::waitKey(0);
+}
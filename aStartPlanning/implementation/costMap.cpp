@@ -0,0 +1,153 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// costMap.cpp : Obstacle distance transform of an occupancy grid with incremental updates,
+// inflated into traversal costs for the planner in aStar.h.
+//
+
+#include "costMap.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int kFar = std::numeric_limits<int>::max();
+const int kNeighbors[8][2] = { {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1} };
+
+} // namespace
+
+CostMap::CostMap(const std::vector<std::vector<int>>& grid, const CostMapOptions& options)
+    : rows_(static_cast<int>(grid.size())), cols_(grid.empty() ? 0 : static_cast<int>(grid[0].size())), options_(options) {
+    max_sq_distance_ = static_cast<int>(std::ceil(options.inflation_radius * options.inflation_radius));
+    cost_table_.resize(max_sq_distance_ + 1);
+    open_.resize(max_sq_distance_ + 1);
+    lowest_ = max_sq_distance_ + 1;
+    for (int sq = 0; sq <= max_sq_distance_; ++sq) {
+        const float d = std::sqrt(static_cast<float>(sq));
+        if (d < options.robot_radius) cost_table_[sq] = kLethal;
+        else if (d >= options.inflation_radius) cost_table_[sq] = 1.0f;
+        else cost_table_[sq] = 1.0f + options.cost_scale * std::exp(-options.decay * (d - options.robot_radius));
+    }
+
+    const size_t cells = static_cast<size_t>(rows_) * cols_;
+    occupied_.assign(cells, 0);
+    sq_distance_.assign(cells, kFar);
+    nearest_.assign(cells, -1);
+    raise_.assign(cells, 0);
+    cost_.assign(cells, 1.0f);
+    is_changed_.assign(cells, 0);
+
+    for (int row = 0; row < rows_; ++row) {
+        for (int col = 0; col < cols_; ++col) {
+            if (grid[row][col] == 1) setObstacle(row, col, true);
+        }
+    }
+    update();
+}
+
+void CostMap::push(int sq_distance, int cell) {
+    open_[sq_distance].push_back(cell);
+    lowest_ = std::min(lowest_, sq_distance);
+}
+
+bool CostMap::pop(int& sq_distance, int& cell) {
+    while (lowest_ < static_cast<int>(open_.size()) && open_[lowest_].empty()) lowest_++;
+    if (lowest_ == static_cast<int>(open_.size())) return false;
+    sq_distance = lowest_;
+    cell = open_[lowest_].back();
+    open_[lowest_].pop_back();
+    return true;
+}
+
+void CostMap::setDistance(int cell, int sq_distance) {
+    sq_distance_[cell] = sq_distance;
+    if (!is_changed_[cell]) {
+        is_changed_[cell] = 1;
+        changed_.push_back(cell);
+    }
+}
+
+void CostMap::clear(int cell) {
+    nearest_[cell] = -1;
+    setDistance(cell, kFar);
+}
+
+void CostMap::setObstacle(int row, int col, bool occupied) {
+    const int cell = row * cols_ + col;
+    if ((occupied_[cell] != 0) == occupied) return;
+    occupied_[cell] = occupied ? 1 : 0;
+    if (occupied) {
+        nearest_[cell] = cell;
+        setDistance(cell, 0);
+        raise_[cell] = 0;
+    }
+    else {
+        clear(cell);
+        raise_[cell] = 1;
+    }
+    push(0, cell);
+}
+
+size_t CostMap::update() {
+    int sq_distance, cell;
+    while (pop(sq_distance, cell)) {
+        if (raise_[cell]) {
+            raise(cell);
+        }
+        else if (sq_distance == sq_distance_[cell] && nearest_[cell] >= 0 && occupied_[nearest_[cell]]) {
+            lower(cell); // Skips entries made stale by a shorter distance found later
+        }
+    }
+
+    for (int cell : changed_) {
+        const int sq = sq_distance_[cell];
+        cost_[cell] = sq > max_sq_distance_ ? 1.0f : cost_table_[sq];
+        is_changed_[cell] = 0;
+    }
+    const size_t changed = changed_.size();
+    changed_.clear();
+    return changed;
+}
+
+void CostMap::raise(int cell) {
+    const int row = cell / cols_, col = cell % cols_;
+    for (const auto& offset : kNeighbors) {
+        const int r = row + offset[0], c = col + offset[1];
+        if (r < 0 || r >= rows_ || c < 0 || c >= cols_) continue;
+        const int neighbor = r * cols_ + c;
+        if (nearest_[neighbor] < 0 || raise_[neighbor]) continue;
+
+        // Either the neighbor lost its obstacle too, or it will refill the cleared area
+        push(sq_distance_[neighbor], neighbor);
+        if (!occupied_[nearest_[neighbor]]) {
+            clear(neighbor);
+            raise_[neighbor] = 1;
+        }
+    }
+    raise_[cell] = 0;
+}
+
+void CostMap::lower(int cell) {
+    const int row = cell / cols_, col = cell % cols_;
+    const int obstacle = nearest_[cell];
+    const int obstacle_row = obstacle / cols_, obstacle_col = obstacle % cols_;
+    for (const auto& offset : kNeighbors) {
+        const int r = row + offset[0], c = col + offset[1];
+        if (r < 0 || r >= rows_ || c < 0 || c >= cols_) continue;
+        const int neighbor = r * cols_ + c;
+        if (raise_[neighbor]) continue;
+
+        const int sq = (r - obstacle_row) * (r - obstacle_row) + (c - obstacle_col) * (c - obstacle_col);
+        if (sq < sq_distance_[neighbor] && sq <= max_sq_distance_) {
+            nearest_[neighbor] = obstacle;
+            setDistance(neighbor, sq);
+            push(sq, neighbor);
+        }
+    }
+}
+
+float CostMap::distance(int row, int col) const {
+    const int sq = sq_distance_[row * cols_ + col];
+    return sq > max_sq_distance_ ? options_.inflation_radius : std::min(std::sqrt(static_cast<float>(sq)), options_.inflation_radius);
+}
@@ -0,0 +1,82 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// costMap.h : Obstacle distance transform of an occupancy grid with incremental updates,
+// inflated into traversal costs for the planner in aStar.h.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Distances are in cells, between cell centers
+struct CostMapOptions {
+    float robot_radius = 1.5f;     // Cells closer than this to an obstacle are lethal
+    float inflation_radius = 8.0f; // Cells at least this far from every obstacle cost 1
+    float cost_scale = 4.0f;       // Extra cost just outside the robot radius
+    float decay = 0.5f;            // The extra cost falls off as exp(-decay * (d - robot_radius))
+};
+
+// Traversal cost per unit of path length of every cell: infinite within the robot radius
+// of an obstacle, 1 + cost_scale exp(-decay (d - robot_radius)) up to the inflation radius
+// and 1 beyond. Every finite cost is at least 1.
+//
+// The distance to the nearest obstacle is propagated from the obstacles in order of
+// increasing distance, each cell inheriting the nearest obstacle of a neighbor (8-connected
+// brushfire; within a small fraction of a cell of the exact Euclidean transform). It stops
+// at the inflation radius. Changing a cell starts a wave from that cell only: a removed
+// obstacle first clears the cells that referred to it ("raise"), then the remaining
+// obstacles around refill them ("lower"), so an update costs in proportion to the area
+// whose distance changes rather than the map.
+class CostMap {
+public:
+    static constexpr float kLethal = std::numeric_limits<float>::infinity();
+
+    // Cells of grid equal to 1 are obstacles, as for astar()
+    explicit CostMap(const std::vector<std::vector<int>>& grid, const CostMapOptions& options = CostMapOptions());
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    const CostMapOptions& options() const { return options_; }
+
+    // Marks a cell as obstacle or free; the distances and costs change at the next update()
+    void setObstacle(int row, int col, bool occupied);
+
+    // Propagates the changes since the last update; returns the number of cells whose
+    // distance changed
+    size_t update();
+
+    bool occupied(int row, int col) const { return occupied_[row * cols_ + col] != 0; }
+
+    // Clearance to the nearest obstacle, at most inflation_radius
+    float distance(int row, int col) const;
+
+    float cost(int row, int col) const { return cost_[row * cols_ + col]; }
+
+private:
+    void push(int sq_distance, int cell);
+    bool pop(int& sq_distance, int& cell);
+    void setDistance(int cell, int sq_distance);
+    void clear(int cell);
+    void raise(int cell);
+    void lower(int cell);
+
+    int rows_, cols_;
+    CostMapOptions options_;
+    int max_sq_distance_;           // Propagation stops beyond this
+    std::vector<float> cost_table_; // Cost by squared distance, 0 ... max_sq_distance_
+
+    std::vector<uint8_t> occupied_;
+    std::vector<int> sq_distance_; // kFar if no obstacle within max_sq_distance_
+    std::vector<int> nearest_;     // Nearest obstacle cell, -1 if none
+    std::vector<uint8_t> raise_;   // Cleared, its neighbors still have to be checked
+    std::vector<float> cost_;
+
+    // Bucket queue on the squared distance, which never exceeds max_sq_distance_
+    std::vector<std::vector<int>> open_;
+    int lowest_ = 0;
+    std::vector<int> changed_;
+    std::vector<uint8_t> is_changed_;
+};
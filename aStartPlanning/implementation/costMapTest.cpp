@@ -0,0 +1,119 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// costMapTest.cpp : Checks the incremental updates of CostMap against a map rebuilt from
+// the same grid, and the rebuilt distances against a brute-force Euclidean distance
+// transform. Random obstacle edits are applied in batches of random size; returns 1 on
+// the first mismatch.
+//
+//   costMapTest [sequences] [seed]
+//
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "costMap.h"
+
+namespace {
+
+// The brushfire inherits the nearest obstacle of a neighbor, which can miss the true
+// nearest obstacle by a fraction of a cell
+const float kDistanceTolerance = 0.25f;
+
+// Distance to the nearest obstacle cell, at most inflation_radius
+float exactDistance(const std::vector<std::vector<int>>& grid, int row, int col, float inflation_radius) {
+    int best = -1;
+    for (size_t r = 0; r < grid.size(); ++r) {
+        for (size_t c = 0; c < grid[r].size(); ++c) {
+            if (grid[r][c] != 1) continue;
+            const int dr = static_cast<int>(r) - row, dc = static_cast<int>(c) - col;
+            const int sq = dr * dr + dc * dc;
+            if (best < 0 || sq < best) best = sq;
+        }
+    }
+    return best < 0 ? inflation_radius : std::min(std::sqrt(static_cast<float>(best)), inflation_radius);
+}
+
+// Describes the first cell where the incremental map differs from the rebuilt one, or
+// where the rebuilt distance is off the exact transform by more than the tolerance
+bool compare(const CostMap& incremental, const std::vector<std::vector<int>>& grid, const CostMapOptions& options,
+    int sequence, int step, float& max_error) {
+    const CostMap rebuilt(grid, options);
+    for (int row = 0; row < rebuilt.rows(); ++row) {
+        for (int col = 0; col < rebuilt.cols(); ++col) {
+            if (incremental.occupied(row, col) != rebuilt.occupied(row, col) ||
+                incremental.distance(row, col) != rebuilt.distance(row, col) ||
+                incremental.cost(row, col) != rebuilt.cost(row, col)) {
+                std::printf("sequence %d step %d: cell (%d, %d) distance %.4f cost %.4f after updates, %.4f / %.4f rebuilt\n",
+                    sequence, step, row, col, incremental.distance(row, col), incremental.cost(row, col),
+                    rebuilt.distance(row, col), rebuilt.cost(row, col));
+                return false;
+            }
+            const float exact = exactDistance(grid, row, col, options.inflation_radius);
+            const float error = std::fabs(rebuilt.distance(row, col) - exact);
+            max_error = std::max(max_error, error);
+            if (error > kDistanceTolerance) {
+                std::printf("sequence %d step %d: cell (%d, %d) distance %.4f, exact %.4f\n",
+                    sequence, step, row, col, rebuilt.distance(row, col), exact);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int sequences = argc > 1 ? std::atoi(argv[1]) : 200;
+    const unsigned seed = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 1u;
+
+    std::mt19937 gen(seed);
+    float max_error = 0.0f;
+    size_t updates = 0;
+    for (int sequence = 0; sequence < sequences; ++sequence) {
+        // Small maps with scattered obstacles and options, so removals uncover areas that
+        // other obstacles have to refill
+        std::uniform_int_distribution<int> size(8, 40);
+        const int rows = size(gen), cols = size(gen);
+        CostMapOptions options;
+        options.inflation_radius = std::uniform_real_distribution<float>(2.0f, 10.0f)(gen);
+        options.robot_radius = std::uniform_real_distribution<float>(0.5f, 2.0f)(gen);
+
+        std::vector<std::vector<int>> grid(rows, std::vector<int>(cols, 0));
+        std::uniform_int_distribution<int> row_of(0, rows - 1), col_of(0, cols - 1);
+        const float density = std::uniform_real_distribution<float>(0.0f, 0.15f)(gen);
+        for (auto& row : grid)
+            for (int& cell : row) cell = std::bernoulli_distribution(density)(gen) ? 1 : 0;
+
+        CostMap map(grid, options);
+        if (!compare(map, grid, options, sequence, 0, max_error)) return 1;
+
+        for (int step = 1; step <= 20; ++step) {
+            // A batch of edits: single cells, or short lines added or removed together
+            const int edits = std::uniform_int_distribution<int>(1, 6)(gen);
+            for (int e = 0; e < edits; ++e) {
+                const bool occupied = std::bernoulli_distribution(0.5)(gen);
+                const int length = std::bernoulli_distribution(0.3)(gen) ? std::uniform_int_distribution<int>(2, 8)(gen) : 1;
+                const bool horizontal = std::bernoulli_distribution(0.5)(gen);
+                int row = row_of(gen), col = col_of(gen);
+                for (int i = 0; i < length && row < rows && col < cols; ++i) {
+                    grid[row][col] = occupied ? 1 : 0;
+                    map.setObstacle(row, col, occupied);
+                    if (horizontal) col++;
+                    else row++;
+                }
+            }
+            map.update();
+            updates++;
+            if (!compare(map, grid, options, sequence, step, max_error)) return 1;
+        }
+    }
+
+    std::printf("%d sequences, %zu updates: incremental maps match the rebuilt ones, max distance error %.3f cells\n",
+        sequences, updates, max_error);
+    return 0;
+}
@@ -0,0 +1,16 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// benchmarkCheck.h : Correctness checks run by the benchmarks before they are timed.
+//
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+// Stops the benchmark with message like State::SkipWithError() and makes the suite exit
+// with a failure (benchmarkMain.cpp), so benchmarks_smoke fails. Google Benchmark itself
+// exits 0 after SkipWithError(), which is kept for inputs that are missing on purpose.
+void failCheck(benchmark::State& state, const char* message);
+
+// Number of failCheck() calls so far
+int failedChecks();
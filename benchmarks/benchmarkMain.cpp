@@ -0,0 +1,37 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// benchmarkMain.cpp : main() of the benchmark suite. Same as benchmark_main, but returns
+// 1 when a benchmark failed one of its checks.
+//
+#include "benchmarkCheck.h"
+
+#include <atomic>
+#include <iostream>
+
+namespace {
+
+std::atomic<int> failed_checks{ 0 };
+
+} // namespace
+
+void failCheck(benchmark::State& state, const char* message) {
+    failed_checks++;
+    state.SkipWithError(message);
+}
+
+int failedChecks() {
+    return failed_checks.load();
+}
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    if (failedChecks() > 0) {
+        std::cerr << "Error: " << failedChecks() << " benchmark check(s) failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// faceNetBenchmarks.cpp : Single-thread embeddings/s of the face ResNet in int8
+// (QuantizedFaceNet) and in float (FaceNetFloat, the straightforward reference in
+// quantizedFaceNet.cpp, not dlib). The weights are random with the anet_type shapes, so
+// the timing is that of the real model. error_vs_float only shows that quantization keeps
+// the descriptors close to FaceNetFloat; it is not an accuracy. The speed against dlib and
+// the verification accuracy on faces need the trained model (faceNetBenchmark).
+//
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmarkCheck.h"
+#include "quantizedFaceNet.h"
+
+namespace {
+
+// He-initialized convolutions; the second convolution of each block is scaled down the
+// way batch norm leaves a trained residual branch, so activations stay bounded over the
+// 14 blocks
+FaceNetWeights randomWeights(uint32_t seed) {
+    std::mt19937 rng(seed);
+    FaceNetWeights weights = FaceNetWeights::shapes();
+    auto fill = [&](FaceNetConv& conv, float gain) {
+        std::normal_distribution<float> weight(0.0f, gain * std::sqrt(2.0f / (conv.kernel * conv.kernel * conv.inputs)));
+        std::normal_distribution<float> bias(0.0f, 0.05f);
+        for (float& w : conv.weights) w = weight(rng);
+        for (float& b : conv.bias) b = bias(rng);
+    };
+    fill(weights.stem, 8.0f); // Inputs are divided by 256
+    for (FaceNetBlock& block : weights.blocks) {
+        fill(block.conv1, 1.0f);
+        fill(block.conv2, 0.3f);
+    }
+    std::normal_distribution<float> fc(0.0f, 0.1f);
+    for (float& w : weights.fc) w = fc(rng);
+    return weights;
+}
+
+// Smooth colour gradients with some noise, so activations are not uniform
+std::vector<std::vector<uint8_t>> syntheticChips(int count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<std::vector<uint8_t>> chips(count, std::vector<uint8_t>(kFaceChipSize * kFaceChipSize * 3));
+    for (auto& chip : chips) {
+        const float fx = 0.2f * uniform(rng), fy = 0.2f * uniform(rng), phase = 6.0f * uniform(rng);
+        for (int y = 0; y < kFaceChipSize; ++y)
+            for (int x = 0; x < kFaceChipSize; ++x)
+                for (int c = 0; c < 3; ++c) {
+                    const float v = 128.0f + 90.0f * std::sin(fx * x + fy * y + phase + c) + 20.0f * (uniform(rng) - 0.5f);
+                    chip[(y * kFaceChipSize + x) * 3 + c] = static_cast<uint8_t>(std::clamp(v, 0.0f, 255.0f));
+                }
+    }
+    return chips;
+}
+
+struct FaceNetFixture {
+    FaceNetFixture() : weights(randomWeights(1)), chips(syntheticChips(24, 2)) {
+        std::vector<const uint8_t*> calibration;
+        for (int i = 0; i < 16; ++i) calibration.push_back(chips[i].data());
+        scales = calibrateFaceNet(weights, calibration);
+    }
+
+    FaceNetWeights weights;
+    FaceNetScales scales;
+    std::vector<std::vector<uint8_t>> chips; // 16 for calibration, 8 for evaluation
+};
+
+const FaceNetFixture& fixture() {
+    static const FaceNetFixture instance;
+    return instance;
+}
+
+void BM_FaceNetFloat(benchmark::State& state) {
+    const FaceNetFixture& f = fixture();
+    FaceNetFloat net(f.weights);
+    float descriptor[kFaceDescriptorSize];
+
+    // The model cache runs the network on packed weights it does not own (faceModels.cpp)
+    auto packed = std::make_shared<const std::vector<float>>(packFaceNetFloat(f.weights));
+    FaceNetFloat external(packed->data(), packed);
+    float expected[kFaceDescriptorSize];
+    net.embed(f.chips[16].data(), expected);
+    external.embed(f.chips[16].data(), descriptor);
+    if (!std::equal(descriptor, descriptor + kFaceDescriptorSize, expected) ||
+        packFaceNetFloat(external.weights()) != *packed) {
+        failCheck(state, "packed weights do not give the same network");
+        return;
+    }
+
+    size_t i = 16;
+    for (auto _ : state) {
+        net.embed(f.chips[i].data(), descriptor);
+        benchmark::DoNotOptimize(descriptor);
+        i = i + 1 < f.chips.size() ? i + 1 : 16;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel("reference, not dlib");
+}
+BENCHMARK(BM_FaceNetFloat)->Unit(benchmark::kMillisecond);
+
+void BM_FaceNetInt8(benchmark::State& state) {
+    const FaceNetFixture& f = fixture();
+    QuantizedFaceNet net(f.weights, f.scales);
+    float descriptor[kFaceDescriptorSize];
+    size_t i = 16;
+    for (auto _ : state) {
+        net.embed(f.chips[i].data(), descriptor);
+        benchmark::DoNotOptimize(descriptor);
+        i = i + 1 < f.chips.size() ? i + 1 : 16;
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    // Relative L2 distance to the float descriptors of the evaluation chips
+    FaceNetFloat reference(f.weights);
+    float expected[kFaceDescriptorSize];
+    double error = 0.0, norm = 0.0;
+    for (size_t n = 16; n < f.chips.size(); ++n) {
+        reference.embed(f.chips[n].data(), expected);
+        net.embed(f.chips[n].data(), descriptor);
+        double e = 0.0, m = 0.0;
+        for (int k = 0; k < kFaceDescriptorSize; ++k) {
+            e += (descriptor[k] - expected[k]) * (descriptor[k] - expected[k]);
+            m += expected[k] * expected[k];
+        }
+        error += std::sqrt(e);
+        norm += std::sqrt(m);
+    }
+    state.counters["error_vs_float"] = error / norm;
+    state.SetLabel(QuantizedFaceNet::kernel());
+}
+BENCHMARK(BM_FaceNetInt8)->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,210 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// featureLogBenchmarks.cpp : Cost of logging a frame of features in the SLAM loop and of
+// reading it back from the memory-mapped log, with ORB-sized frames (32-byte binary
+// descriptors) and SIFT-sized frames (128 floats). The read and recovery benchmarks check
+// that every frame comes back unchanged before they time anything.
+//
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmarkCheck.h"
+#include "featureLog.h"
+
+namespace {
+
+struct SyntheticFrame {
+    std::vector<LogKeypoint> keypoints;
+    std::vector<uint8_t> descriptors;
+    uint16_t descriptor_bytes;
+    DescriptorType type;
+
+    SyntheticFrame(int count, bool binary)
+        : descriptor_bytes(binary ? 32 : 128 * sizeof(float)), type(binary ? DescriptorType::Binary : DescriptorType::Float) {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> u(0.0f, 640.0f);
+        for (int i = 0; i < count; ++i) keypoints.push_back({ u(rng), u(rng), 31.0f, u(rng), 1e-3f, i % 8 });
+        descriptors.resize(size_t(count) * descriptor_bytes);
+        for (uint8_t& byte : descriptors) byte = static_cast<uint8_t>(rng());
+    }
+
+    FeatureLogRecord record(uint64_t index) const {
+        FeatureLogRecord r;
+        r.index = index;
+        r.capture_ns = static_cast<int64_t>(index) * 33333333;
+        r.has_pose = true;
+        r.keypoints = keypoints.data();
+        r.keypoint_count = static_cast<uint32_t>(keypoints.size());
+        r.descriptor_type = type;
+        r.descriptor_bytes = descriptor_bytes;
+        r.descriptors = descriptors.data();
+        return r;
+    }
+};
+
+std::string logPath(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void writeLog(const std::string& path, const SyntheticFrame& frame, uint64_t frames) {
+    FeatureLogWriter log;
+    log.open(path);
+    for (uint64_t i = 0; i < frames; ++i) log.append(frame.record(i));
+    log.close();
+}
+
+// True if frame i of the log holds exactly what frame.record(i) appended
+bool sameFrame(const FeatureLogReader& log, size_t i, const SyntheticFrame& frame) {
+    const FeatureLogFrame view = log.frame(i);
+    const FeatureLogRecord expected = frame.record(i);
+    const FeatureLogFrameHeader& header = *view.header;
+    return header.index == expected.index && header.capture_ns == expected.capture_ns &&
+        header.flags == kFeatureLogHasPose && header.keypoint_count == expected.keypoint_count &&
+        header.descriptor_type == expected.descriptor_type && header.descriptor_bytes == expected.descriptor_bytes &&
+        std::memcmp(header.rotation, expected.rotation, sizeof(header.rotation)) == 0 &&
+        std::memcmp(view.keypoints, expected.keypoints, expected.keypoint_count * sizeof(LogKeypoint)) == 0 &&
+        std::memcmp(view.descriptors, expected.descriptors, size_t(expected.keypoint_count) * expected.descriptor_bytes) == 0;
+}
+
+bool sameFrames(const FeatureLogReader& log, const SyntheticFrame& frame) {
+    for (size_t i = 0; i < log.frames(); ++i) {
+        if (!sameFrame(log, i, frame)) return false;
+    }
+    return true;
+}
+
+// Arg 0: keypoints per frame, arg 1: 1 = binary descriptors, 0 = float.
+// Appends as fast as possible, in wall time: once four sealed chunks wait for the disk,
+// append() blocks, so this is the sustained rate the disk allows, not the cost of the copy.
+void BM_FeatureLogAppend(benchmark::State& state) {
+    const SyntheticFrame frame(static_cast<int>(state.range(0)), state.range(1) != 0);
+    const std::string path = logPath("featureLogAppend.flog");
+    FeatureLogWriter log;
+    log.open(path);
+    uint64_t index = 0;
+    for (auto _ : state) {
+        log.append(frame.record(index++));
+    }
+    const uint64_t bytes = log.bytesWritten();
+    log.close();
+    std::filesystem::remove(path);
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.counters["KB_per_frame"] = bytes / 1024.0 / index;
+}
+BENCHMARK(BM_FeatureLogAppend)->Args({ 500, 1 })->Args({ 2000, 1 })->Args({ 500, 0 })->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// As above, but one append per frame at arg 2 frames per second, the way the SLAM loop
+// logs, for two seconds. Only the append() calls are timed; max_us is the slowest one.
+void BM_FeatureLogAppendPaced(benchmark::State& state) {
+    const SyntheticFrame frame(static_cast<int>(state.range(0)), state.range(1) != 0);
+    const auto period = std::chrono::nanoseconds(1000000000 / state.range(2));
+    const std::string path = logPath("featureLogAppendPaced.flog");
+    FeatureLogWriter log;
+    log.open(path);
+    uint64_t index = 0;
+    double max_s = 0.0;
+    auto next = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        std::this_thread::sleep_until(next);
+        next += period;
+        const auto start = std::chrono::steady_clock::now();
+        log.append(frame.record(index++));
+        const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        state.SetIterationTime(s);
+        max_s = std::max(max_s, s);
+    }
+    log.close();
+    std::filesystem::remove(path);
+    state.counters["max_us"] = max_s * 1e6;
+}
+BENCHMARK(BM_FeatureLogAppendPaced)->Args({ 500, 1, 30 })->Args({ 500, 0, 30 })->Iterations(60)
+    ->Unit(benchmark::kMicrosecond)->UseManualTime();
+
+// Random access to frames of a 1000-frame log, touching every keypoint and descriptor
+void BM_FeatureLogRead(benchmark::State& state) {
+    const SyntheticFrame frame(static_cast<int>(state.range(0)), state.range(1) != 0);
+    const std::string path = logPath("featureLogRead.flog");
+    writeLog(path, frame, 1000);
+    FeatureLogReader log;
+    if (!log.open(path) || log.frames() != 1000 || log.recovered() || !sameFrames(log, frame)) {
+        failCheck(state, "log did not read back unchanged");
+        return;
+    }
+
+    std::mt19937 rng(3);
+    size_t bytes = 0;
+    for (auto _ : state) {
+        const FeatureLogFrame view = log.frame(rng() % log.frames());
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < view.header->keypoint_count; ++i) sum += view.keypoints[i].x;
+        uint64_t bits = 0;
+        const size_t descriptor_bytes = size_t(view.header->keypoint_count) * view.header->descriptor_bytes;
+        for (size_t i = 0; i < descriptor_bytes; i += sizeof(uint64_t)) bits ^= *reinterpret_cast<const uint64_t*>(view.descriptors + i);
+        benchmark::DoNotOptimize(sum);
+        benchmark::DoNotOptimize(bits);
+        bytes += view.header->record_bytes;
+    }
+    log.close();
+    std::filesystem::remove(path);
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_FeatureLogRead)->Args({ 500, 1 })->Args({ 500, 0 })->Unit(benchmark::kMicrosecond);
+
+// Opening a 1000-frame log cut off in the middle of a chunk, as a crash leaves it: the
+// footer and index are gone, so the reader rebuilds the index from the complete chunks
+void BM_FeatureLogRecover(benchmark::State& state) {
+    const SyntheticFrame frame(static_cast<int>(state.range(0)), state.range(1) != 0);
+    const std::string path = logPath("featureLogRecover.flog");
+    writeLog(path, frame, 1000);
+
+    // Chunk ends from the record offsets of the intact log: a new chunk starts wherever a
+    // record does not directly follow the previous one
+    std::vector<uint64_t> offsets;
+    uint32_t record_bytes = 0;
+    {
+        FeatureLogReader log;
+        if (!log.open(path) || log.frames() != 1000) {
+            failCheck(state, "log could not be read back");
+            return;
+        }
+        record_bytes = log.frame(0).header->record_bytes;
+        for (size_t i = 0; i < log.frames(); ++i) {
+            offsets.push_back(reinterpret_cast<const char*>(log.frame(i).header) - reinterpret_cast<const char*>(log.frame(0).header));
+        }
+    }
+    const uint64_t cut = offsets[offsets.size() / 2] + record_bytes / 2;
+    size_t complete = 0;
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        const bool chunk_ends = i + 1 == offsets.size() || offsets[i + 1] != offsets[i] + record_bytes;
+        if (chunk_ends && offsets[i] + record_bytes <= cut) complete = i + 1;
+    }
+    // The last chunk ends before the index (8 bytes per frame) and the 24-byte footer
+    const uint64_t chunks_end = std::filesystem::file_size(path) - offsets.size() * sizeof(uint64_t) - 24;
+    std::filesystem::resize_file(path, chunks_end - (offsets.back() + record_bytes - cut));
+
+    FeatureLogReader log;
+    if (!log.open(path) || !log.recovered() || log.frames() != complete || complete == 0 || !sameFrames(log, frame)) {
+        failCheck(state, "truncated log was not recovered to its complete chunks");
+        return;
+    }
+    for (auto _ : state) {
+        log.open(path);
+        benchmark::DoNotOptimize(log.frames());
+    }
+    log.close();
+    std::filesystem::remove(path);
+    state.counters["frames"] = static_cast<double>(complete);
+}
+BENCHMARK(BM_FeatureLogRecover)->Args({ 500, 1 })->Unit(benchmark::kMicrosecond);
+
+} // namespace
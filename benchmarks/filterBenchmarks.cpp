@@ -0,0 +1,184 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// filterBenchmarks.cpp : Particle filter, Kalman filter and multi-target association hot paths.
+//
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "hungarian.h"
+#include "kalmanFilter.h"
+#include "kalmanTrackPool.h"
+#include "particleFilter.h"
+#include "trackManager.h"
+
+namespace {
+
+// 1. Particle filter (faceParticleTracking.cpp), particle count as argument
+
+void BM_ParticlePredict(benchmark::State& state) {
+    ParticleFilter filter(static_cast<size_t>(state.range(0)));
+    filter.initializeUniform(640.0f, 480.0f);
+    for (auto _ : state) {
+        filter.predict(10.0f);
+        benchmark::DoNotOptimize(filter.x());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParticlePredict)->RangeMultiplier(10)->Range(100, 100000);
+
+void BM_ParticleUpdate(benchmark::State& state) {
+    ParticleFilter filter(static_cast<size_t>(state.range(0)));
+    filter.initializeUniform(640.0f, 480.0f);
+    for (auto _ : state) {
+        filter.update(320.0f, 240.0f, 50.0f);
+        benchmark::DoNotOptimize(filter.weights());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParticleUpdate)->RangeMultiplier(10)->Range(100, 100000);
+
+void BM_ParticleResample(benchmark::State& state) {
+    ParticleFilter filter(static_cast<size_t>(state.range(0)));
+    filter.initializeUniform(640.0f, 480.0f);
+    filter.update(320.0f, 240.0f, 50.0f);
+    for (auto _ : state) {
+        filter.resample();
+        benchmark::DoNotOptimize(filter.x());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParticleResample)->RangeMultiplier(10)->Range(100, 100000);
+
+// Full tracking step on a face moving in a circle
+void BM_ParticleFrame(benchmark::State& state) {
+    ParticleFilter filter(static_cast<size_t>(state.range(0)));
+    filter.initializeAround(320.0f, 240.0f, 20.0f);
+    int k = 0;
+    for (auto _ : state) {
+        const float mx = 320.0f + 100.0f * std::cos(0.05f * k), my = 240.0f + 80.0f * std::sin(0.05f * k);
+        filter.predict(10.0f);
+        filter.update(mx, my, 50.0f);
+        filter.resampleIfNeeded();
+        float x, y;
+        filter.estimate(x, y);
+        benchmark::DoNotOptimize(x);
+        ++k;
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParticleFrame)->RangeMultiplier(10)->Range(100, 100000);
+
+// 2. Kalman filter (movingFaceRecog.cpp)
+
+using Filter = KalmanFilter<double, 3, 2>;
+
+struct KalmanModel {
+    Filter::StateMatrix Q = Filter::StateMatrix::zeros();
+    Filter::MeasurementMatrix H = Filter::MeasurementMatrix::identity();
+    Filter::MeasurementCov R = 2.0 * Filter::MeasurementCov::identity();
+    Filter::StateVector u = Filter::StateVector::zeros();
+
+    KalmanModel() {
+        Q(0, 0) = Q(1, 1) = 100.0;
+        Q(2, 2) = 5.0 * 3.14159265358979 / 180.0;
+    }
+};
+
+void BM_KalmanPredictUpdate(benchmark::State& state) {
+    const KalmanModel model;
+    Filter filter;
+    filter.initialize(Filter::StateVector::zeros(), 500.0 * Filter::StateMatrix::identity());
+    int k = 0;
+    for (auto _ : state) {
+        Filter::MeasurementVector z;
+        z(0, 0) = 320.0 + 100.0 * std::cos(0.05 * k);
+        z(1, 0) = 240.0 + 80.0 * std::sin(0.05 * k);
+        filter.predict(model.u, model.Q);
+        filter.update(z, model.H, model.R);
+        benchmark::DoNotOptimize(filter.x);
+        ++k;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KalmanPredictUpdate);
+
+void BM_KalmanBatch(benchmark::State& state) {
+    const KalmanModel model;
+    const size_t count = static_cast<size_t>(state.range(0));
+    std::vector<Filter> filters(count);
+    for (auto& filter : filters) filter.initialize(Filter::StateVector::zeros(), 500.0 * Filter::StateMatrix::identity());
+    std::vector<Filter::MeasurementVector> measurements(count);
+    for (size_t i = 0; i < count; ++i) {
+        measurements[i](0, 0) = 320.0 + 100.0 * std::cos(0.1 * i);
+        measurements[i](1, 0) = 240.0 + 80.0 * std::sin(0.1 * i);
+    }
+    for (auto _ : state) {
+        batchPredict(filters.data(), count, model.u, model.Q);
+        benchmark::DoNotOptimize(batchUpdate(filters.data(), measurements.data(), count, model.H, model.R));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_KalmanBatch)->Arg(64)->Arg(4096);
+
+// 3. Association (Multi_Target_Tracking)
+
+void BM_Hungarian(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> cost(0.0f, 100.0f);
+    std::vector<float> costs(static_cast<size_t>(n) * n);
+    for (float& c : costs) c = cost(gen);
+    std::vector<int> assignment(n);
+    HungarianSolver solver;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(solver.solve(costs.data(), n, n, assignment.data()));
+    }
+}
+BENCHMARK(BM_Hungarian)->Arg(10)->Arg(50)->Arg(200);
+
+// Targets bouncing in a 1280x720 frame with noise, 10% missed detections and clutter
+void BM_TrackManagerStep(benchmark::State& state) {
+    struct Target {
+        float x, y, vx, vy;
+    };
+    const int num_targets = static_cast<int>(state.range(0));
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> ux(0.0f, 1280.0f), uy(0.0f, 720.0f), uv(-4.0f, 4.0f), u01(0.0f, 1.0f);
+    std::normal_distribution<float> noise(0.0f, 2.0f);
+    std::vector<Target> targets(num_targets);
+    for (auto& target : targets) target = { ux(gen), uy(gen), uv(gen), uv(gen) };
+
+    TrackManager<KalmanTrackPool> tracker(KalmanTrackPool(4 * num_targets, 25.0, 0.01, 4.0, 500.0));
+    std::vector<Detection> detections;
+    auto nextFrame = [&]() {
+        detections.clear();
+        for (auto& target : targets) {
+            target.x += target.vx;
+            target.y += target.vy;
+            if (target.x < 0.0f || target.x > 1280.0f) target.vx = -target.vx;
+            if (target.y < 0.0f || target.y > 720.0f) target.vy = -target.vy;
+            if (u01(gen) < 0.9f) detections.push_back({ target.x + noise(gen), target.y + noise(gen) });
+        }
+        for (int c = 0; c < num_targets / 5; ++c) detections.push_back({ ux(gen), uy(gen) });
+    };
+
+    // Let the tracks confirm before timing
+    for (int f = 0; f < 20; ++f) {
+        nextFrame();
+        tracker.step(detections);
+    }
+    for (auto _ : state) {
+        state.PauseTiming();
+        nextFrame();
+        state.ResumeTiming();
+        tracker.step(detections);
+    }
+}
+BENCHMARK(BM_TrackManagerStep)->Arg(10)->Arg(50)->Unit(benchmark::kMicrosecond);
+
+} // namespace
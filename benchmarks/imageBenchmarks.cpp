@@ -0,0 +1,111 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// imageBenchmarks.cpp : Grayscale conversion and the shared image pyramid, on synthetic
+// BGR frames at the common camera resolutions.
+//
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "benchmarkCheck.h"
+#include "imagePyramid.h"
+
+namespace {
+
+// Smooth BGR test frame; content does not affect the timings but keeps the data realistic
+struct BgrFrame {
+    int width, height;
+    size_t stride;
+    std::vector<uint8_t> data;
+
+    BgrFrame(int w, int h) : width(w), height(h), stride(static_cast<size_t>(w) * 3), data(stride * h) {
+        std::mt19937 rng(12345);
+        std::uniform_int_distribution<int> noise(0, 15);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                uint8_t* p = &data[y * stride + x * 3];
+                p[0] = static_cast<uint8_t>((x + noise(rng)) & 255);
+                p[1] = static_cast<uint8_t>((y + noise(rng)) & 255);
+                p[2] = static_cast<uint8_t>((x + y + noise(rng)) & 255);
+            }
+        }
+    }
+};
+
+// Pixels where bgrToGray() differs from the scalar reference, on full-range random data
+// with a width that leaves a scalar tail after the vector loop
+size_t grayMismatches() {
+    const int width = 1283, height = 37;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint8_t> bgr(static_cast<size_t>(width) * 3 * height);
+    for (uint8_t& value : bgr) value = static_cast<uint8_t>(byte(rng));
+
+    std::vector<uint8_t> simd(static_cast<size_t>(width) * height), scalar(simd.size());
+    bgrToGray(bgr.data(), static_cast<size_t>(width) * 3, simd.data(), width, width, height);
+    bgrToGrayScalar(bgr.data(), static_cast<size_t>(width) * 3, scalar.data(), width, width, height);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < simd.size(); ++i) mismatches += simd[i] != scalar[i];
+    return mismatches;
+}
+
+void grayBenchmark(benchmark::State& state, bool simd) {
+    if (simd && grayMismatches() != 0) {
+        failCheck(state, "bgrToGray differs from bgrToGrayScalar");
+        return;
+    }
+    BgrFrame frame(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    std::vector<uint8_t> gray(static_cast<size_t>(frame.width) * frame.height);
+    for (auto _ : state) {
+        if (simd) {
+            bgrToGray(frame.data.data(), frame.stride, gray.data(), frame.width, frame.width, frame.height);
+        }
+        else {
+            bgrToGrayScalar(frame.data.data(), frame.stride, gray.data(), frame.width, frame.width, frame.height);
+        }
+        benchmark::DoNotOptimize(gray.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(frame.data.size()));
+}
+
+void BM_BgrToGrayScalar(benchmark::State& state) {
+    grayBenchmark(state, false);
+}
+BENCHMARK(BM_BgrToGrayScalar)->Args({ 640, 480 })->Args({ 1280, 720 })->Args({ 1920, 1080 })->Unit(benchmark::kMicrosecond);
+
+void BM_BgrToGray(benchmark::State& state) {
+    grayBenchmark(state, true);
+}
+BENCHMARK(BM_BgrToGray)->Args({ 640, 480 })->Args({ 1280, 720 })->Args({ 1920, 1080 })->Unit(benchmark::kMicrosecond);
+
+// Grayscale plus 8-level pyramid; arg 2 = 1 reuses pooled buffers, 0 allocates per frame
+void BM_PyramidBuild(benchmark::State& state) {
+    BgrFrame frame(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    const bool pooled = state.range(2) != 0;
+    PyramidPool pool;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        if (pooled) {
+            auto pyramid = pool.build(frame.data.data(), frame.width, frame.height, frame.stride);
+            bytes = pyramid->bytes();
+            benchmark::DoNotOptimize(pyramid.get());
+        }
+        else {
+            PyramidPool fresh;
+            auto pyramid = fresh.build(frame.data.data(), frame.width, frame.height, frame.stride);
+            bytes = pyramid->bytes();
+            benchmark::DoNotOptimize(pyramid.get());
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(frame.data.size()));
+    state.counters["pyramid_MB"] = bytes / 1048576.0;
+    if (pooled) state.counters["allocations"] = static_cast<double>(pool.allocations());
+}
+BENCHMARK(BM_PyramidBuild)->Args({ 640, 480, 0 })->Args({ 640, 480, 1 })->Args({ 1280, 720, 0 })->Args({ 1280, 720, 1 })
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
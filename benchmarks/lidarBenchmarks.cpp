@@ -0,0 +1,336 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// lidarBenchmarks.cpp : Velodyne ingestion throughput in points per second: pcap parsing
+// and packet decoding, ground removal, voxel-grid downsampling and the whole chain, on a
+// synthetic capture (ground plane, a wavy wall and poles) in the sensor's own packet
+// format. points_per_second of a VLS-128 run is compared with the sensor's ~2.4 M
+// points/s single-return rate in the realtime_headroom counter. The decoder is checked
+// against a hand-built packet and the voxel grid against a plain std::map reduction
+// before they are timed.
+//
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "benchmarkCheck.h"
+#include "cloudFilter.h"
+#include "velodyneDecoder.h"
+#include "velodynePcap.h"
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+const double kVls128PointsPerSecond = 2.4e6;
+
+// Range of a ray in the synthetic scene, 0 for no return
+double sceneRange(double azimuth, double elevation) {
+    double range = 120.0;
+    if (elevation < 0.0) range = std::min(range, 1.8 / std::sin(-elevation));
+    const double wall = 25.0 + 6.0 * std::sin(3.0 * azimuth);
+    const double wall_height = 4.0;
+    const double to_wall = wall / std::cos(elevation);
+    if (to_wall * std::sin(elevation) < wall_height) range = std::min(range, to_wall);
+    // Poles every 20 degrees at 8 m, 0.3 m wide
+    const double sector = std::fmod(azimuth, kPi / 9.0);
+    if (std::fabs(sector - kPi / 18.0) * 8.0 < 0.15) range = std::min(range, 8.0 / std::cos(elevation));
+    return range < 120.0 ? range : 0.0;
+}
+
+// Data packets of `scans` full turns at 10 Hz in the packet layout of the model
+std::vector<std::vector<uint8_t>> syntheticPackets(VelodyneModel model, int scans) {
+    const VelodyneCalibration calibration = defaultCalibration(model);
+    const int lasers = velodyneLasers(model);
+    const int blocks_per_firing = model == VelodyneModel::Vls128 ? 4 : 1;
+    const int azimuth_step = model == VelodyneModel::Vlp16 ? 40 : model == VelodyneModel::Hdl32 ? 17 : 20;
+    const uint8_t product = model == VelodyneModel::Vlp16 ? 0x22 : model == VelodyneModel::Hdl32 ? 0x21 : 0xa1;
+    const uint8_t vls_flags[4] = { 0xee, 0xdd, 0xcc, 0xbb };
+
+    std::vector<std::vector<uint8_t>> packets;
+    const int firings = scans * 36000 / azimuth_step;
+    std::vector<uint8_t> packet(kVelodynePacketBytes, 0);
+    int block = 0;
+    for (int firing = 0; firing < firings; ++firing) {
+        const int azimuth = (firing * azimuth_step) % 36000;
+        for (int bank = 0; bank < blocks_per_firing; ++bank) {
+            uint8_t* b = packet.data() + block * 100;
+            b[0] = 0xff;
+            b[1] = model == VelodyneModel::Vls128 ? vls_flags[bank] : 0xee;
+            b[2] = static_cast<uint8_t>(azimuth & 0xff);
+            b[3] = static_cast<uint8_t>(azimuth >> 8);
+            for (int channel = 0; channel < 32; ++channel) {
+                const int laser = model == VelodyneModel::Vlp16 ? channel % 16 : bank * 32 + channel;
+                const double elevation = calibration.elevation_deg[laser] * kPi / 180.0;
+                const double range = laser < lasers ? sceneRange(azimuth * kPi / 18000.0, elevation) : 0.0;
+                const int distance = static_cast<int>(range / calibration.distance_resolution_m);
+                b[4 + channel * 3] = static_cast<uint8_t>(distance & 0xff);
+                b[5 + channel * 3] = static_cast<uint8_t>(distance >> 8);
+                b[6 + channel * 3] = static_cast<uint8_t>(laser * 2);
+            }
+            if (++block == 12) {
+                packet[1204] = 0x37; // Strongest return
+                packet[1205] = product;
+                packets.push_back(packet);
+                block = 0;
+            }
+        }
+    }
+    return packets;
+}
+
+void put16(std::vector<uint8_t>& out, size_t at, uint16_t v) {
+    out[at] = static_cast<uint8_t>(v >> 8);
+    out[at + 1] = static_cast<uint8_t>(v & 0xff);
+}
+
+// Little-endian microsecond pcap with Ethernet / IPv4 / UDP framing, one packet per 0.5 ms
+std::string writePcap(const std::vector<std::vector<uint8_t>>& packets, const char* name) {
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream out(path, std::ios::binary);
+    const uint32_t header[6] = { 0xa1b2c3d4, 0x00040002, 0, 0, 65535, 1 };
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    std::vector<uint8_t> frame(42 + kVelodynePacketBytes, 0);
+    put16(frame, 12, 0x0800);
+    frame[14] = 0x45;
+    put16(frame, 16, static_cast<uint16_t>(28 + kVelodynePacketBytes));
+    frame[22] = 64;
+    frame[23] = 17;
+    put16(frame, 34, kVelodyneDataPort);
+    put16(frame, 36, kVelodyneDataPort);
+    put16(frame, 38, static_cast<uint16_t>(8 + kVelodynePacketBytes));
+    for (size_t i = 0; i < packets.size(); ++i) {
+        const uint64_t us = 1700000000ull * 1000000 + i * 500;
+        const uint32_t record[4] = { uint32_t(us / 1000000), uint32_t(us % 1000000), uint32_t(frame.size()), uint32_t(frame.size()) };
+        std::memcpy(frame.data() + 42, packets[i].data(), kVelodynePacketBytes);
+        out.write(reinterpret_cast<const char*>(record), sizeof(record));
+        out.write(reinterpret_cast<const char*>(frame.data()), static_cast<std::streamsize>(frame.size()));
+    }
+    return path;
+}
+
+VelodyneModel modelArg(int64_t arg) {
+    return arg == 16 ? VelodyneModel::Vlp16 : arg == 32 ? VelodyneModel::Hdl32 : VelodyneModel::Vls128;
+}
+
+// One full scan of the model, decoded outside the timed loops
+const LidarScan& syntheticScan(VelodyneModel model) {
+    static LidarScan scans[3];
+    LidarScan& scan = scans[static_cast<int>(model)];
+    if (scan.points.empty()) {
+        VelodyneDecoder decoder(model, defaultCalibration(model));
+        LidarScan completed;
+        for (const std::vector<uint8_t>& data : syntheticPackets(model, 2)) {
+            if (decoder.add({ data.data(), data.size(), 0 }, completed) && scan.points.empty()) scan = completed;
+        }
+    }
+    return scan;
+}
+
+void setPointCounters(benchmark::State& state, uint64_t points, VelodyneModel model) {
+    state.SetItemsProcessed(static_cast<int64_t>(points));
+    if (model == VelodyneModel::Vls128) {
+        state.counters["realtime_headroom"] = benchmark::Counter(static_cast<double>(points) / kVls128PointsPerSecond,
+            benchmark::Counter::kIsRate);
+    }
+}
+
+// HDL-32E packet with every block at 270 degrees and three returns in the first block, then
+// a packet at 1 degree that closes the scan. All blocks share one azimuth, so there is no
+// per-channel interpolation and the points follow from the calibration alone.
+bool decoderMatchesKnownPacket() {
+    const VelodyneCalibration calibration = defaultCalibration(VelodyneModel::Hdl32);
+    VelodyneDecoder decoder(VelodyneModel::Hdl32, calibration);
+    std::vector<uint8_t> packet(kVelodynePacketBytes, 0);
+    auto fill = [&](int azimuth) {
+        for (int block = 0; block < 12; ++block) {
+            uint8_t* b = packet.data() + block * 100;
+            b[0] = 0xff;
+            b[1] = 0xee;
+            b[2] = static_cast<uint8_t>(azimuth & 0xff);
+            b[3] = static_cast<uint8_t>(azimuth >> 8);
+        }
+        packet[1204] = 0x37;
+        packet[1205] = 0x21;
+    };
+    auto setReturn = [&](int channel, int distance, uint8_t intensity) {
+        uint8_t* c = packet.data() + 4 + channel * 3;
+        c[0] = static_cast<uint8_t>(distance & 0xff);
+        c[1] = static_cast<uint8_t>(distance >> 8);
+        c[2] = intensity;
+    };
+
+    // Laser 0 at 10 m, laser 15 (0 degrees) at 5 m, laser 31 at 0.2 m (under min range)
+    fill(27000);
+    setReturn(0, 5000, 40);
+    setReturn(15, 2500, 200);
+    setReturn(31, 100, 7);
+    LidarScan scan;
+    if (decoder.add({ packet.data(), packet.size(), 0 }, scan)) return false;
+    std::fill(packet.begin(), packet.end(), 0);
+    fill(100);
+    if (!decoder.add({ packet.data(), packet.size(), 0 }, scan) || scan.points.size() != 2) return false;
+
+    const int lasers[2] = { 0, 15 };
+    const double ranges[2] = { 10.0, 5.0 };
+    const uint8_t intensities[2] = { 40, 200 };
+    for (int i = 0; i < 2; ++i) {
+        const float elevation_deg = calibration.elevation_deg[lasers[i]];
+        const double elevation = elevation_deg * kPi / 180.0;
+        int ring = 0;
+        for (float e : calibration.elevation_deg) ring += e < elevation_deg ? 1 : 0;
+        const LidarPoint& p = scan.points[i];
+        if (std::fabs(p.x + ranges[i] * std::cos(elevation)) > 1e-3 || std::fabs(p.y) > 1e-3 ||
+            std::fabs(p.z - ranges[i] * std::sin(elevation)) > 1e-3 || p.intensity != intensities[i] ||
+            p.ring != ring || p.azimuth != 27000) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Arg: lasers (16, 32, 128). pcap parsing from the mapping plus decoding into scans.
+void BM_VelodyneDecode(benchmark::State& state) {
+    const VelodyneModel model = modelArg(state.range(0));
+    if (!decoderMatchesKnownPacket()) {
+        failCheck(state, "decoder does not reproduce the hand-built packet");
+        return;
+    }
+    const std::string path = writePcap(syntheticPackets(model, 5), "velodyneDecode.pcap");
+    VelodynePcapReader reader;
+    if (!reader.open(path)) {
+        failCheck(state, "synthetic pcap could not be read");
+        return;
+    }
+    VelodyneDecoder decoder(model, defaultCalibration(model));
+    LidarScan scan;
+    VelodynePacket packet;
+    uint64_t points = 0;
+    for (auto _ : state) {
+        if (!reader.next(packet)) {
+            reader.rewind();
+            reader.next(packet);
+        }
+        if (decoder.add(packet, scan)) points += scan.points.size();
+    }
+    reader.close();
+    std::filesystem::remove(path);
+    setPointCounters(state, points, model);
+}
+BENCHMARK(BM_VelodyneDecode)->Arg(16)->Arg(32)->Arg(128);
+
+// Args: lasers, threads
+void BM_GroundRemoval(benchmark::State& state) {
+    const VelodyneModel model = modelArg(state.range(0));
+    const LidarScan& scan = syntheticScan(model);
+    CloudFilterConfig config;
+    config.threads = static_cast<int>(state.range(1));
+    CloudFilter filter(config);
+    std::vector<LidarPoint> obstacles, ground;
+    for (auto _ : state) {
+        filter.removeGround(scan.points, velodyneLasers(model), obstacles, ground);
+        benchmark::DoNotOptimize(ground.data());
+    }
+    setPointCounters(state, state.iterations() * scan.points.size(), model);
+    state.counters["ground_fraction"] = static_cast<double>(ground.size()) / scan.points.size();
+}
+BENCHMARK(BM_GroundRemoval)->Args({ 128, 1 })->Args({ 128, 4 })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Same voxels as an ordered map of per-voxel sums: same count, each centroid within 1 mm of
+// the reference and intensity within one step
+bool voxelsMatchReference(const std::vector<LidarPoint>& points, float voxel_size, const std::vector<LidarPoint>& voxels) {
+    using Key = std::tuple<int, int, int>;
+    struct Sum {
+        double x = 0.0, y = 0.0, z = 0.0, intensity = 0.0;
+        int count = 0;
+    };
+    auto keyOf = [voxel_size](const LidarPoint& p) {
+        return Key(static_cast<int>(std::floor(p.x / voxel_size)), static_cast<int>(std::floor(p.y / voxel_size)),
+            static_cast<int>(std::floor(p.z / voxel_size)));
+    };
+    std::map<Key, Sum> reference;
+    for (const LidarPoint& p : points) {
+        Sum& sum = reference[keyOf(p)];
+        sum.x += p.x;
+        sum.y += p.y;
+        sum.z += p.z;
+        sum.intensity += p.intensity;
+        sum.count++;
+    }
+    if (reference.size() != voxels.size()) return false;
+
+    std::map<Key, const LidarPoint*> found;
+    for (const LidarPoint& voxel : voxels) {
+        if (!found.emplace(keyOf(voxel), &voxel).second) return false;
+    }
+    for (const auto& entry : reference) {
+        const auto it = found.find(entry.first);
+        if (it == found.end()) return false;
+        const Sum& sum = entry.second;
+        const LidarPoint& voxel = *it->second;
+        if (std::fabs(voxel.x - sum.x / sum.count) > 1e-3 || std::fabs(voxel.y - sum.y / sum.count) > 1e-3 ||
+            std::fabs(voxel.z - sum.z / sum.count) > 1e-3 || std::abs(voxel.intensity - sum.intensity / sum.count) > 1.0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Args: lasers, threads
+void BM_VoxelGrid(benchmark::State& state) {
+    const VelodyneModel model = modelArg(state.range(0));
+    const LidarScan& scan = syntheticScan(model);
+    CloudFilterConfig config;
+    config.threads = static_cast<int>(state.range(1));
+    CloudFilter filter(config);
+    std::vector<LidarPoint> voxels;
+    filter.downsample(scan.points, voxels);
+    if (!voxelsMatchReference(scan.points, config.voxel_size_m, voxels)) {
+        failCheck(state, "voxel grid differs from the reference");
+        return;
+    }
+    for (auto _ : state) {
+        filter.downsample(scan.points, voxels);
+        benchmark::DoNotOptimize(voxels.data());
+    }
+    setPointCounters(state, state.iterations() * scan.points.size(), model);
+    state.counters["voxels"] = static_cast<double>(voxels.size());
+}
+BENCHMARK(BM_VoxelGrid)->Args({ 128, 1 })->Args({ 128, 4 })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Decode, ground removal and downsampling of full scans; args: lasers, threads
+void BM_LidarPipeline(benchmark::State& state) {
+    const VelodyneModel model = modelArg(state.range(0));
+    const std::vector<std::vector<uint8_t>> packets = syntheticPackets(model, 3);
+    VelodyneDecoder decoder(model, defaultCalibration(model));
+    CloudFilterConfig config;
+    config.threads = static_cast<int>(state.range(1));
+    CloudFilter filter(config);
+    LidarScan scan;
+    std::vector<LidarPoint> obstacles, ground;
+    uint64_t points = 0;
+    size_t next = 0;
+    for (auto _ : state) {
+        // Feed packets until one scan is complete
+        while (true) {
+            const std::vector<uint8_t>& data = packets[next];
+            next = (next + 1) % packets.size();
+            if (decoder.add({ data.data(), data.size(), 0 }, scan)) break;
+        }
+        filter.process(scan, decoder.rings(), obstacles, ground);
+        points += scan.points.size();
+    }
+    setPointCounters(state, points, model);
+    state.counters["points_per_scan"] = static_cast<double>(points) / state.iterations();
+}
+BENCHMARK(BM_LidarPipeline)->Args({ 16, 1 })->Args({ 128, 1 })->Args({ 128, 4 })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace
@@ -0,0 +1,138 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// mpcBenchmarks.cpp : One receding-horizon step of the linear MPC, and of the nonlinear
+// bicycle MPC as real-time iteration and as converged SQP on a closed-loop lane change.
+//
+#include <benchmark/benchmark.h>
+
+#include <Eigen/Dense>
+
+#include <cmath>
+#include <vector>
+
+#include "benchmarkCheck.h"
+#include "mpc.h"
+
+namespace {
+
+// Double integrator of mpcDemo.cpp, horizon as argument
+void BM_LinearMpcSolve(benchmark::State& state) {
+    const double dt = 0.1;
+    Eigen::MatrixXd A(2, 2), B(2, 1);
+    A << 1, dt, 0, 1;
+    B << 0, dt;
+    LinearMpc mpc(A, B, Eigen::MatrixXd::Identity(2, 2), 0.1 * Eigen::MatrixXd::Identity(1, 1),
+        static_cast<int>(state.range(0)), -2.0, 2.0);
+
+    Eigen::VectorXd x = Eigen::VectorXd::Zero(2), x_goal(2), u(1);
+    x_goal << 10, 0;
+    for (auto _ : state) {
+        if (!mpc.solve(x, x_goal, u)) {
+            failCheck(state, "qpOASES failed");
+            break;
+        }
+        x = A * x + B * u;
+        if (x(0) > 9.5) x.setZero(); // Restart the approach so the constraints stay active
+    }
+}
+BENCHMARK(BM_LinearMpcSolve)->Arg(10)->Arg(30)->Unit(benchmark::kMicrosecond);
+
+// Sinusoidal lane changes (2 m amplitude, 60 m period) at 10 m/s, one state per step
+std::vector<KinematicBicycle::State> laneChange(const KinematicBicycle& model, int steps) {
+    const double speed = 10.0, amplitude = 2.0, wave = 2.0 * M_PI / 60.0;
+    std::vector<KinematicBicycle::State> reference;
+    for (int k = 0; k < steps; ++k) {
+        const double x = speed * model.dt * k;
+        KinematicBicycle::State r;
+        r << x, amplitude * std::sin(wave * x), std::atan(amplitude * wave * std::cos(wave * x)), speed;
+        reference.push_back(r);
+    }
+    return reference;
+}
+
+const int kLaneChangeSteps = 150;
+
+KinematicBicycle::State laneChangeStart() {
+    return KinematicBicycle::State(0.0, -1.0, 0.0, 8.0); // 1 m off the path and too slow
+}
+
+// Closed loop over the whole lane change; the model is also the plant
+bool runLaneChange(const NonlinearMpcOptions& options, std::vector<KinematicBicycle::State>& states) {
+    KinematicBicycle model;
+    const std::vector<KinematicBicycle::State> reference = laneChange(model, kLaneChangeSteps + options.horizon + 1);
+    NonlinearMpc mpc(model, options);
+    KinematicBicycle::State x = laneChangeStart();
+    KinematicBicycle::Input u;
+    states.assign(1, x);
+    for (int t = 0; t < kLaneChangeSteps; ++t) {
+        const std::vector<KinematicBicycle::State> window(reference.begin() + t + 1, reference.begin() + t + 1 + options.horizon);
+        if (!mpc.solve(x, window, u)) return false;
+        x = model.step(x, u);
+        states.push_back(x);
+    }
+    return true;
+}
+
+// Args: horizon, max iterations (1 = real-time iteration), threads. Reports the
+// linearization and QP share of a step, the RMS position error to the path and, for the
+// real-time iteration, the RMS distance to the closed loop of the converged SQP.
+void BM_NonlinearMpcStep(benchmark::State& state) {
+    NonlinearMpcOptions options;
+    options.horizon = static_cast<int>(state.range(0));
+    options.max_iterations = static_cast<int>(state.range(1));
+    options.threads = static_cast<int>(state.range(2));
+
+    KinematicBicycle model;
+    const std::vector<KinematicBicycle::State> reference = laneChange(model, kLaneChangeSteps + options.horizon + 1);
+    NonlinearMpc mpc(model, options);
+    KinematicBicycle::State x = laneChangeStart();
+    KinematicBicycle::Input u;
+    int t = 0;
+    double linearize_s = 0.0, qp_s = 0.0, iterations = 0.0;
+    for (auto _ : state) {
+        const std::vector<KinematicBicycle::State> window(reference.begin() + t + 1, reference.begin() + t + 1 + options.horizon);
+        if (!mpc.solve(x, window, u)) {
+            failCheck(state, "qpOASES failed");
+            return;
+        }
+        linearize_s += mpc.linearizeSeconds();
+        qp_s += mpc.qpSeconds();
+        iterations += mpc.iterations();
+        x = model.step(x, u);
+        if (++t == kLaneChangeSteps) {
+            t = 0;
+            x = laneChangeStart();
+            mpc.reset();
+        }
+    }
+    const double steps = static_cast<double>(state.iterations());
+    state.counters["linearize_us"] = 1e6 * linearize_s / steps;
+    state.counters["qp_us"] = 1e6 * qp_s / steps;
+    state.counters["qp_per_step"] = iterations / steps;
+
+    std::vector<KinematicBicycle::State> states, converged;
+    NonlinearMpcOptions sqp = options;
+    sqp.max_iterations = 50;
+    if (!runLaneChange(options, states) || !runLaneChange(sqp, converged)) {
+        failCheck(state, "qpOASES failed");
+        return;
+    }
+    const std::vector<KinematicBicycle::State> path = laneChange(model, kLaneChangeSteps + 1);
+    double path_error = 0.0, sqp_error = 0.0;
+    for (size_t k = 0; k < states.size(); ++k) {
+        path_error += (states[k].head<2>() - path[k].head<2>()).squaredNorm();
+        sqp_error += (states[k].head<2>() - converged[k].head<2>()).squaredNorm();
+    }
+    state.counters["rms_path_m"] = std::sqrt(path_error / states.size());
+    state.counters["rms_vs_sqp_m"] = std::sqrt(sqp_error / states.size());
+}
+BENCHMARK(BM_NonlinearMpcStep)
+    ->ArgNames({ "horizon", "iterations", "threads" })
+    ->Args({ 20, 1, 1 })
+    ->Args({ 20, 50, 1 })
+    ->Args({ 40, 1, 1 })
+    ->Args({ 40, 1, 4 })
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,152 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// planningBenchmarks.cpp : A* grid planning, the cost map distance transform and weighted A*.
+//
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmarkCheck.h"
+#include "aStar.h"
+#include "costMap.h"
+
+namespace {
+
+// The wall of aStarDemo.cpp scaled to the grid size
+std::vector<std::vector<int>> wallGrid(int size) {
+    std::vector<std::vector<int>> grid(size, std::vector<int>(size, 0));
+    for (int i = 3 * size / 10; i < 8 * size / 10; ++i) {
+        grid[i][size / 2] = 1;
+    }
+    return grid;
+}
+
+// 20% random obstacles, corners kept free
+std::vector<std::vector<int>> clutterGrid(int size) {
+    std::mt19937 gen(7);
+    std::bernoulli_distribution obstacle(0.2);
+    std::vector<std::vector<int>> grid(size, std::vector<int>(size, 0));
+    for (auto& row : grid) {
+        for (int& cell : row) cell = obstacle(gen) ? 1 : 0;
+    }
+    grid[0][0] = grid[size - 1][size - 1] = 0;
+    return grid;
+}
+
+void BM_AStarWall(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    const auto grid = wallGrid(size);
+    size_t length = 0;
+    for (auto _ : state) {
+        auto path = astar(grid, { 0, 0 }, { size - 1, size - 1 });
+        length = path.size();
+        benchmark::DoNotOptimize(path.data());
+    }
+    state.counters["path"] = static_cast<double>(length);
+}
+BENCHMARK(BM_AStarWall)->Arg(10)->Arg(50)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+void BM_AStarClutter(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    const auto grid = clutterGrid(size);
+    size_t length = 0;
+    for (auto _ : state) {
+        auto path = astar(grid, { 0, 0 }, { size - 1, size - 1 });
+        length = path.size();
+        benchmark::DoNotOptimize(path.data());
+    }
+    state.counters["path"] = static_cast<double>(length);
+}
+BENCHMARK(BM_AStarClutter)->Arg(50)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+// Rectangular blocks (buildings, shelves) covering about 15% of the grid, with the corner
+// areas around the start and goal kept free
+std::vector<std::vector<int>> blockGrid(int size) {
+    std::mt19937 gen(11);
+    const int largest = std::max(3, size / 25);
+    std::uniform_int_distribution<int> position(0, size - 1), extent(2, largest);
+    std::vector<std::vector<int>> grid(size, std::vector<int>(size, 0));
+    const int mean = (2 + largest) / 2;
+    const int blocks = size * size * 15 / (100 * mean * mean);
+    for (int b = 0; b < blocks; ++b) {
+        const int row = position(gen), col = position(gen), height = extent(gen), width = extent(gen);
+        for (int r = row; r < std::min(size, row + height); ++r) {
+            for (int c = col; c < std::min(size, col + width); ++c) {
+                const bool corner = (r < 10 && c < 10) || (r >= size - 10 && c >= size - 10);
+                if (!corner) grid[r][c] = 1;
+            }
+        }
+    }
+    return grid;
+}
+
+void BM_CostMapBuild(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    const auto grid = blockGrid(size);
+    for (auto _ : state) {
+        CostMap map(grid);
+        benchmark::DoNotOptimize(&map);
+    }
+    state.counters["cells_per_s"] = benchmark::Counter(static_cast<double>(size) * size * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_CostMapBuild)->Arg(200)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+// A 4x4 obstacle appearing and disappearing in the middle of the map, as a moving object
+// seen by the sensors would
+void BM_CostMapUpdate(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    CostMap map(blockGrid(size));
+    bool occupied = false;
+    size_t changed = 0;
+    for (auto _ : state) {
+        occupied = !occupied;
+        for (int r = size / 2; r < size / 2 + 4; ++r) {
+            for (int c = size / 2; c < size / 2 + 4; ++c) map.setObstacle(r, c, occupied);
+        }
+        changed += map.update();
+    }
+    state.counters["changed_cells"] = static_cast<double>(changed) / state.iterations();
+}
+BENCHMARK(BM_CostMapUpdate)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+// Corner to corner on the cost map; the argument is the weight times 10. suboptimality is
+// the path cost over the cheapest one (weight 1).
+void BM_CostMapAStar(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    const float weight = static_cast<float>(state.range(1)) / 10.0f;
+    const CostMap map(blockGrid(size));
+    const std::pair<int, int> start = { 2, 2 }, goal = { size - 3, size - 3 };
+    CostMapPlanner planner;
+    planner.plan(map, start, goal, 1.0f);
+    const float cheapest = planner.pathCost();
+
+    std::vector<std::pair<int, int>> path;
+    for (auto _ : state) {
+        path = planner.plan(map, start, goal, weight);
+        benchmark::DoNotOptimize(path.data());
+    }
+    if (path.empty()) {
+        failCheck(state, "No path");
+        return;
+    }
+    float clearance = map.options().inflation_radius;
+    for (const auto& cell : path) clearance = std::min(clearance, map.distance(cell.first, cell.second));
+    state.counters["expanded"] = static_cast<double>(planner.expanded());
+    state.counters["path_cost"] = planner.pathCost();
+    state.counters["suboptimality"] = planner.pathCost() / cheapest;
+    state.counters["min_clearance"] = clearance;
+}
+BENCHMARK(BM_CostMapAStar)
+    ->ArgNames({ "size", "weight_x10" })
+    ->Args({ 500, 10 })
+    ->Args({ 500, 12 })
+    ->Args({ 500, 15 })
+    ->Args({ 500, 20 })
+    ->Args({ 500, 50 })
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,105 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// poolBenchmarks.cpp : WorkStealingPool scheduling the way faceStreamServer uses it:
+// camera streams at 100 fps with uneven per-frame cost, one frame in flight per stream
+// (a frame that arrives while the previous one is still processed is dropped), every
+// stream preferring its own worker. Reports the aggregate and slowest-stream frame rate,
+// frame latency percentiles, the dropped and the stolen fraction as streams are added.
+//
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "workStealingPool.h"
+
+namespace {
+
+void spinFor(std::chrono::microseconds duration) {
+    const auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(values.size() * p))];
+}
+
+// Per-stream state; only the task in flight writes the latencies, busy hands them back
+struct Stream {
+    std::atomic<bool> busy{ false };
+    std::vector<double> latency_ms;
+    uint64_t dropped = 0;
+};
+
+// Args: workers, streams. One iteration is one 10 ms frame period; the frames of the
+// streams arrive staggered over it. Frame cost is 250, 500, 750 or 1000 us by stream,
+// 0.625 ms on average, so 16 streams need one core.
+void BM_WorkStealingStreams(benchmark::State& state) {
+    const int streams = static_cast<int>(state.range(1));
+    const auto period = std::chrono::milliseconds(10);
+    WorkStealingPool pool(static_cast<int>(state.range(0)));
+    std::vector<std::unique_ptr<Stream>> stream_state;
+    for (int s = 0; s < streams; ++s) stream_state.emplace_back(new Stream);
+
+    const auto start = std::chrono::steady_clock::now();
+    auto frame_start = start;
+    for (auto _ : state) {
+        for (int s = 0; s < streams; ++s) {
+            const auto arrival = frame_start + period * s / streams;
+            std::this_thread::sleep_until(arrival);
+            Stream& stream = *stream_state[s];
+            if (stream.busy.load(std::memory_order_acquire)) {
+                stream.dropped++;
+                continue;
+            }
+            stream.busy.store(true, std::memory_order_relaxed);
+            pool.submit([&stream, s, arrival](int) {
+                spinFor(std::chrono::microseconds(250 * (1 + s % 4)));
+                stream.latency_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - arrival).count());
+                stream.busy.store(false, std::memory_order_release);
+            }, s);
+        }
+        frame_start += period;
+    }
+    pool.waitIdle();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> latencies;
+    uint64_t frames = 0, dropped = 0, slowest = ~0ull;
+    for (const std::unique_ptr<Stream>& stream : stream_state) {
+        latencies.insert(latencies.end(), stream->latency_ms.begin(), stream->latency_ms.end());
+        frames += stream->latency_ms.size();
+        dropped += stream->dropped;
+        slowest = std::min<uint64_t>(slowest, stream->latency_ms.size());
+    }
+    state.counters["fps"] = frames / elapsed;
+    state.counters["min_stream_fps"] = slowest / elapsed;
+    state.counters["p50_ms"] = percentile(latencies, 0.5);
+    state.counters["p99_ms"] = percentile(latencies, 0.99);
+    state.counters["dropped_fraction"] = static_cast<double>(dropped) / std::max<uint64_t>(frames + dropped, 1);
+    state.counters["stolen_fraction"] = static_cast<double>(pool.stolen()) / std::max<uint64_t>(pool.executed(), 1);
+}
+BENCHMARK(BM_WorkStealingStreams)->Args({ 4, 4 })->Args({ 4, 8 })->Args({ 4, 16 })->Args({ 4, 32 })
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Submit and run cost of an empty task
+void BM_WorkStealingSubmit(benchmark::State& state) {
+    WorkStealingPool pool(static_cast<int>(state.range(0)));
+    std::atomic<uint64_t> ran{ 0 };
+    for (auto _ : state) {
+        pool.submit([&](int) { ran.fetch_add(1, std::memory_order_relaxed); });
+    }
+    pool.waitIdle();
+    state.SetItemsProcessed(static_cast<int64_t>(ran.load()));
+}
+BENCHMARK(BM_WorkStealingSubmit)->Arg(1)->Arg(4);
+
+} // namespace
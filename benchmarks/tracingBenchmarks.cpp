@@ -0,0 +1,34 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// tracingBenchmarks.cpp : Cost of a TRACE_SCOPE with tracing off and on.
+//
+#include <benchmark/benchmark.h>
+
+#include "tracing.h"
+
+namespace {
+
+void BM_TraceScopeDisabled(benchmark::State& state) {
+    for (auto _ : state) {
+        TRACE_SCOPE("disabled");
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_TraceScopeDisabled);
+
+void BM_TraceScopeEnabled(benchmark::State& state) {
+    trace::TraceOptions options;
+    options.process_name = "tracingBenchmarks";
+    options.summary_interval_s = 0.0;
+    options.final_summary = false;
+    trace::start(options);
+    for (auto _ : state) {
+        TRACE_SCOPE("enabled");
+        benchmark::ClobberMemory();
+    }
+    trace::stop();
+}
+BENCHMARK(BM_TraceScopeEnabled);
+
+} // namespace
@@ -0,0 +1,68 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// viewerBenchmarks.cpp : Producer-side cost of the live viewer handoff (TripleBuffer),
+// with a consumer thread polling for updates the way the viewer's render timer does.
+//
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "tripleBuffer.h"
+
+namespace {
+
+// Polls update() until stopped and touches the first value of each new front slot
+class PollingConsumer {
+public:
+    explicit PollingConsumer(TripleBuffer<std::vector<float>>& buffer)
+        : thread_([this, &buffer] {
+              while (running_.load(std::memory_order_relaxed)) {
+                  if (buffer.update() && !buffer.front().empty()) seen_ += buffer.front()[0];
+                  std::this_thread::yield();
+              }
+          }) {}
+    ~PollingConsumer() {
+        running_ = false;
+        thread_.join();
+    }
+
+private:
+    std::atomic<bool> running_{ true };
+    float seen_ = 0.0f;
+    std::thread thread_;
+};
+
+void BM_TripleBufferPublish(benchmark::State& state) {
+    TripleBuffer<std::vector<float>> buffer;
+    PollingConsumer consumer(buffer);
+    float value = 0.0f;
+    for (auto _ : state) {
+        std::vector<float>& back = buffer.back();
+        back.assign(1, value += 1.0f);
+        buffer.publish();
+    }
+    state.counters["dropped_fraction"] = static_cast<double>(buffer.dropped()) / buffer.published();
+}
+BENCHMARK(BM_TripleBufferPublish);
+
+// Arg: points. Writing a cloud into the reused back slot and publishing it.
+void BM_TripleBufferCloud(benchmark::State& state) {
+    const size_t points = static_cast<size_t>(state.range(0));
+    TripleBuffer<std::vector<float>> buffer;
+    PollingConsumer consumer(buffer);
+    float value = 0.0f;
+    for (auto _ : state) {
+        std::vector<float>& back = buffer.back();
+        back.resize(points * 3);
+        value += 1.0f;
+        for (size_t i = 0; i < back.size(); ++i) back[i] = value;
+        buffer.publish();
+    }
+    state.SetItemsProcessed(state.iterations() * points);
+}
+BENCHMARK(BM_TripleBufferCloud)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,339 @@
+//
+// Copyright(c) 2024 deepwave-ai. All Rights Reserved.
+//
+// visionBenchmarks.cpp : Feature front-end and pose estimation of the ORB / SIFT programs,
+// on a synthetic frame pair and on frames of a recorded video. The video defaults to one
+// of the demo clips in the repository; set PERCEPTION_BENCH_VIDEO to use another one.
+//
+#include <benchmark/benchmark.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmarkCheck.h"
+#include "featureFrontEnd.h"
+#include "featureLogCv.h"
+#include "pyramidFeatures.h"
+#include "visualOdometry.h"
+
+namespace {
+
+// Same intrinsics as the SLAM programs
+const cv::Mat& cameraMatrix() {
+    static const cv::Mat K = (cv::Mat_<double>(3, 3) << 718.856, 0, 607.1928, 0, 718.856, 185.2157, 0, 0, 1);
+    return K;
+}
+
+// Textured 640x480 BGR frame and a copy moved by a small rotation and shift
+struct FramePair {
+    cv::Mat first, second;
+
+    FramePair() {
+        cv::RNG rng(12345);
+        cv::Mat noise(480, 640, CV_8UC1);
+        rng.fill(noise, cv::RNG::UNIFORM, 0, 256);
+        cv::GaussianBlur(noise, noise, cv::Size(5, 5), 1.5);
+        for (int i = 0; i < 60; ++i) {
+            cv::rectangle(noise, cv::Rect(rng.uniform(0, 600), rng.uniform(0, 440), rng.uniform(10, 80), rng.uniform(10, 80)),
+                cv::Scalar(rng.uniform(0, 256)), cv::FILLED);
+        }
+        cv::cvtColor(noise, first, cv::COLOR_GRAY2BGR);
+        cv::Mat motion = cv::getRotationMatrix2D(cv::Point2f(320, 240), 2.0, 1.0);
+        motion.at<double>(0, 2) += 6.0;
+        motion.at<double>(1, 2) += 3.0;
+        cv::warpAffine(first, second, motion, first.size(), cv::INTER_LINEAR, cv::BORDER_REFLECT);
+    }
+};
+
+const FramePair& framePair() {
+    static const FramePair pair;
+    return pair;
+}
+
+cv::Mat gray(const cv::Mat& frame) {
+    cv::Mat result;
+    cv::cvtColor(frame, result, cv::COLOR_BGR2GRAY);
+    return result;
+}
+
+// First frames of the recorded clip, decoded once outside the timed loops
+const std::vector<cv::Mat>& recordedFrames() {
+    static const std::vector<cv::Mat> frames = [] {
+        const char* path = std::getenv("PERCEPTION_BENCH_VIDEO");
+        cv::VideoCapture capture(path ? std::string(path) : std::string(PERCEPTION_BENCH_VIDEO_DEFAULT));
+        std::vector<cv::Mat> result;
+        cv::Mat frame;
+        while (result.size() < 30 && capture.read(frame)) result.push_back(frame.clone());
+        return result;
+    }();
+    return frames;
+}
+
+// Pixels where bgrToGray() (imagePyramid.h) differs from cv::cvtColor, on full-range random
+// data with a width that leaves a scalar tail after the vector loop
+size_t grayMismatches() {
+    cv::Mat bgr(37, 1283, CV_8UC3), expected;
+    cv::RNG rng(7);
+    rng.fill(bgr, cv::RNG::UNIFORM, 0, 256);
+    cv::cvtColor(bgr, expected, cv::COLOR_BGR2GRAY);
+    cv::Mat result(bgr.size(), CV_8UC1);
+    bgrToGray(bgr.data, bgr.step, result.data, result.step, bgr.cols, bgr.rows);
+    return static_cast<size_t>(cv::countNonZero(result != expected));
+}
+
+void BM_CvtColor(benchmark::State& state) {
+    if (grayMismatches() != 0) {
+        failCheck(state, "bgrToGray is not bit-exact with cv::cvtColor");
+        return;
+    }
+    const cv::Mat& frame = framePair().first;
+    cv::Mat result;
+    for (auto _ : state) {
+        cv::cvtColor(frame, result, cv::COLOR_BGR2GRAY);
+        benchmark::DoNotOptimize(result.data);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.total() * frame.elemSize());
+}
+BENCHMARK(BM_CvtColor)->Unit(benchmark::kMicrosecond);
+
+template <typename Detector>
+void detectBenchmark(benchmark::State& state, cv::Ptr<Detector> detector, const cv::Mat& image) {
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
+    for (auto _ : state) {
+        detector->detectAndCompute(image, cv::noArray(), keypoints, descriptors);
+        benchmark::DoNotOptimize(descriptors.data);
+    }
+    state.counters["keypoints"] = static_cast<double>(keypoints.size());
+}
+
+void BM_OrbDetect(benchmark::State& state) {
+    detectBenchmark(state, cv::ORB::create(), gray(framePair().first));
+}
+BENCHMARK(BM_OrbDetect)->Unit(benchmark::kMillisecond);
+
+// ORB on the shared pyramid: one single-level ORB per level, as in the ORB programs.
+// Includes building the pyramid, which replaces cvtColor and the ORB internal pyramid.
+void BM_OrbDetectSharedPyramid(benchmark::State& state) {
+    const cv::Mat& frame = framePair().first;
+    cv::Ptr<cv::ORB> orb = cv::ORB::create();
+    PyramidPool pool;
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
+    for (auto _ : state) {
+        auto pyramid = pool.build(frame.data, frame.cols, frame.rows, frame.step);
+        detectOrbOnPyramid(*orb, *pyramid, 500, keypoints, descriptors);
+        benchmark::DoNotOptimize(descriptors.data);
+    }
+    state.counters["keypoints"] = static_cast<double>(keypoints.size());
+}
+BENCHMARK(BM_OrbDetectSharedPyramid)->Unit(benchmark::kMillisecond);
+
+// Bytes cv::ORB writes into its internal pyramid: every level is copied with a border of
+// edgeThreshold pixels (an estimate; OpenCV's exact layout may add alignment padding)
+size_t orbPyramidBytes(const cv::ORB& orb, int width, int height) {
+    const int border = orb.getEdgeThreshold();
+    size_t bytes = 0;
+    double scale = 1.0;
+    for (int i = 0; i < orb.getNLevels(); ++i, scale *= orb.getScaleFactor()) {
+        const int w = cvRound(width / scale), h = cvRound(height / scale);
+        bytes += static_cast<size_t>(w + 2 * border) * (h + 2 * border);
+    }
+    return bytes;
+}
+
+// Per-frame preprocessing and ORB as the ORB program runs it. Arg 0 = 0: the path before
+// the shared pyramid, cv::cvtColor and detectAndCompute, which builds ORB's own pyramid;
+// 1: PyramidPool and detectOrbOnPyramid(). preprocess_MB estimates the bytes read and
+// written before detection: the BGR frame, the gray image or shared pyramid, and the
+// bordered level copies cv::ORB makes in both cases (one level at a time on the shared
+// pyramid). The shared pyramid only saves traffic once several consumers read it.
+void BM_FramePreprocess(benchmark::State& state) {
+    const cv::Mat& frame = framePair().first;
+    const bool shared = state.range(0) != 0;
+    cv::Ptr<cv::ORB> orb = cv::ORB::create();
+    PyramidPool pool;
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat gray, descriptors;
+    for (auto _ : state) {
+        if (shared) {
+            auto pyramid = pool.build(frame.data, frame.cols, frame.rows, frame.step);
+            detectOrbOnPyramid(*orb, *pyramid, 500, keypoints, descriptors);
+        }
+        else {
+            cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+            orb->detectAndCompute(gray, cv::noArray(), keypoints, descriptors);
+        }
+        benchmark::DoNotOptimize(descriptors.data);
+    }
+
+    size_t traffic = frame.total() * frame.elemSize();
+    if (shared) {
+        auto pyramid = pool.build(frame.data, frame.cols, frame.rows, frame.step);
+        cv::Ptr<cv::ORB> level_orb = cv::ORB::create(500, orb->getScaleFactor(), 1);
+        traffic += pyramid->bytes();
+        for (int i = 0; i < pyramid->levels(); ++i) {
+            traffic += orbPyramidBytes(*level_orb, pyramid->level(i).width, pyramid->level(i).height);
+        }
+    }
+    else {
+        traffic += frame.total() + orbPyramidBytes(*orb, frame.cols, frame.rows);
+    }
+    state.counters["keypoints"] = static_cast<double>(keypoints.size());
+    state.counters["preprocess_MB"] = traffic / 1048576.0;
+}
+BENCHMARK(BM_FramePreprocess)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Adaptive front-end at a 10 ms budget while busy threads compete for the CPU.
+// Arg 0: 0 = ORB, 1 = SIFT, 2 = FAST+BRIEF; arg 1: number of busy threads. Reports the
+// achieved detection rate and the keypoints and feature budget the controller settled on.
+void BM_AdaptiveFrontEnd(benchmark::State& state) {
+    const DetectorType types[] = { DetectorType::Orb, DetectorType::Sift, DetectorType::FastBrief };
+    FrontEndConfig config;
+    config.type = types[state.range(0)];
+    config.budget_ms = 10.0;
+    config.report_every = 0;
+    FeatureFrontEnd front_end(config);
+
+    const cv::Mat& frame = framePair().first;
+    PyramidPool pool;
+    auto pyramid = pool.build(frame.data, frame.cols, frame.rows, frame.step);
+
+    std::atomic<bool> stop{ false };
+    std::vector<std::thread> load;
+    for (int i = 0; i < state.range(1); ++i) {
+        load.emplace_back([&stop] {
+            volatile double x = 1.0;
+            while (!stop.load(std::memory_order_relaxed)) x = x * 1.0000001 + 1e-9;
+        });
+    }
+
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
+    for (int i = 0; i < 30; ++i) front_end.detect(*pyramid, keypoints, descriptors);
+
+    size_t keypoint_total = 0;
+    for (auto _ : state) {
+        front_end.detect(*pyramid, keypoints, descriptors);
+        keypoint_total += keypoints.size();
+    }
+    stop = true;
+    for (std::thread& thread : load) thread.join();
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["keypoints"] = static_cast<double>(keypoint_total) / state.iterations();
+    state.counters["features"] = front_end.params().features;
+    state.counters["levels"] = front_end.params().levels;
+    state.counters["detect_ms"] = front_end.smoothedMs();
+}
+BENCHMARK(BM_AdaptiveFrontEnd)->ArgsProduct({ { 0, 1, 2 }, { 0, 2, 4 } })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_SiftDetect(benchmark::State& state) {
+    detectBenchmark(state, cv::SIFT::create(), gray(framePair().first));
+}
+BENCHMARK(BM_SiftDetect)->Unit(benchmark::kMillisecond);
+
+// Detect, match and estimate the pose for a frame pair; arg 0 = ORB, 1 = SIFT
+void BM_MatchAndPose(benchmark::State& state) {
+    cv::Ptr<cv::Feature2D> detector = state.range(0) == 0 ? cv::Ptr<cv::Feature2D>(cv::ORB::create()) : cv::Ptr<cv::Feature2D>(cv::SIFT::create());
+    std::vector<cv::KeyPoint> keypoints1, keypoints2;
+    cv::Mat descriptors1, descriptors2;
+    detector->detectAndCompute(gray(framePair().first), cv::noArray(), keypoints1, descriptors1);
+    detector->detectAndCompute(gray(framePair().second), cv::noArray(), keypoints2, descriptors2);
+
+    std::vector<cv::DMatch> matches;
+    for (auto _ : state) {
+        matches = computeMatches(descriptors1, descriptors2);
+        cv::Mat R, t, mask;
+        findPose(matches, keypoints1, keypoints2, cameraMatrix(), R, t, mask);
+        benchmark::DoNotOptimize(R.data);
+    }
+    state.counters["matches"] = static_cast<double>(matches.size());
+}
+BENCHMARK(BM_MatchAndPose)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// ORB SLAM front-end over the recorded clip: grayscale, detect, match to the previous frame
+void BM_OrbSlamRecorded(benchmark::State& state) {
+    const std::vector<cv::Mat>& frames = recordedFrames();
+    if (frames.size() < 2) {
+        state.SkipWithError("recorded video not found, set PERCEPTION_BENCH_VIDEO");
+        return;
+    }
+    cv::Ptr<cv::ORB> orb = cv::ORB::create();
+    std::vector<cv::KeyPoint> previous_keypoints, keypoints;
+    cv::Mat previous_descriptors, descriptors;
+    size_t index = 0;
+    for (auto _ : state) {
+        orb->detectAndCompute(gray(frames[index]), cv::noArray(), keypoints, descriptors);
+        if (!previous_descriptors.empty()) {
+            std::vector<cv::DMatch> matches = computeMatches(previous_descriptors, descriptors);
+            benchmark::DoNotOptimize(matches.data());
+        }
+        std::swap(previous_keypoints, keypoints);
+        std::swap(previous_descriptors, descriptors);
+        index = (index + 1) % frames.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OrbSlamRecorded)->Unit(benchmark::kMillisecond);
+
+// Replay of the same front-end from a feature log written once: keypoints and
+// descriptors come from the mapping, only matching runs. Compare with BM_OrbSlamRecorded.
+void BM_OrbSlamFromLog(benchmark::State& state) {
+    const std::vector<cv::Mat>& frames = recordedFrames();
+    if (frames.size() < 2) {
+        state.SkipWithError("recorded video not found, set PERCEPTION_BENCH_VIDEO");
+        return;
+    }
+    const std::string path = (std::filesystem::temp_directory_path() / "orbSlamReplay.flog").string();
+    {
+        cv::Ptr<cv::ORB> orb = cv::ORB::create();
+        FeatureLogWriter writer;
+        writer.open(path);
+        std::vector<LogKeypoint> buffer;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            Frame frame;
+            frame.index = static_cast<int64_t>(i);
+            std::vector<cv::KeyPoint> keypoints;
+            cv::Mat descriptors;
+            orb->detectAndCompute(gray(frames[i]), cv::noArray(), keypoints, descriptors);
+            appendFeatureLog(writer, frame, keypoints, descriptors, cv::Mat(), cv::Mat(), buffer);
+        }
+        writer.close();
+    }
+    FeatureLogReader log;
+    if (!log.open(path)) {
+        failCheck(state, "feature log could not be read back");
+        return;
+    }
+
+    cv::Mat previous_descriptors;
+    size_t index = 0;
+    for (auto _ : state) {
+        const FeatureLogFrame frame = log.frame(index);
+        std::vector<cv::KeyPoint> keypoints = logKeypoints(frame);
+        cv::Mat descriptors = logDescriptors(frame);
+        if (!previous_descriptors.empty()) {
+            std::vector<cv::DMatch> matches = computeMatches(previous_descriptors, descriptors);
+            benchmark::DoNotOptimize(matches.data());
+        }
+        benchmark::DoNotOptimize(keypoints.data());
+        previous_descriptors = descriptors;
+        index = (index + 1) % log.frames();
+    }
+    log.close();
+    std::filesystem::remove(path);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OrbSlamFromLog)->Unit(benchmark::kMillisecond);
+
+} // namespace